@@ -5,7 +5,8 @@
  * Licensed under the MIT license:
  * http://www.opensource.org/licenses/mit-license.php
  *
- * Implementation of writable buffer object.
+ * Implementation of writable buffer object, read-only buffer views,
+ * typed numeric buffers and packing of cairo paths.
  */
 
 #include <string.h>
@@ -63,6 +64,513 @@ static const luaL_Reg buffer_mt_reg[] = {
   { NULL, NULL }
 };
 
+/* Read-only view into memory owned either by some native object (e.g.
+   GBytes or array returned from C function) or by Lua value stored in
+   view's environment table. */
+typedef struct _BufferView
+{
+  /* Viewed memory block. */
+  const guint8 *data;
+  gsize size;
+
+  /* Native owner of the data and its destroy function, invoked when
+   the view is garbage collected.  NULL if the memory is owned by the
+   Lua value. */
+  gpointer owner;
+  GDestroyNotify destroy;
+} BufferView;
+
+void
+lgi_buffer_view_new (lua_State *L, gconstpointer data, gsize size,
+		     gpointer owner, GDestroyNotify destroy)
+{
+  BufferView *view = lua_newuserdata (L, sizeof (BufferView));
+  view->data = data;
+  view->size = size;
+  view->owner = owner;
+  view->destroy = destroy;
+  luaL_getmetatable (L, LGI_BYTES_VIEW);
+  lua_setmetatable (L, -2);
+}
+
+gconstpointer
+lgi_buffer_view_get (lua_State *L, int narg, gsize *size)
+{
+  BufferView *view = lgi_udata_test (L, narg, LGI_BYTES_VIEW);
+  if (view == NULL)
+    return NULL;
+
+  if (size != NULL)
+    *size = view->size;
+  return view->data;
+}
+
+/* Makes view on the top of the stack keeping alive Lua value at
+   narg index. */
+static void
+buffer_view_keep (lua_State *L, int narg)
+{
+  lua_createtable (L, 1, 0);
+  lua_pushvalue (L, narg);
+  lua_rawseti (L, -2, 1);
+  lua_setfenv (L, -2);
+}
+
+static int
+buffer_view_gc (lua_State *L)
+{
+  BufferView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  if (view->owner != NULL && view->destroy != NULL)
+    view->destroy (view->owner);
+  view->owner = NULL;
+  view->data = NULL;
+  view->size = 0;
+  return 0;
+}
+
+static int
+buffer_view_len (lua_State *L)
+{
+  BufferView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  lua_pushinteger (L, view->size);
+  return 1;
+}
+
+static int
+buffer_view_tostring (lua_State *L)
+{
+  BufferView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  lua_pushlstring (L, (const char *) view->data, view->size);
+  return 1;
+}
+
+static int
+buffer_view_index (lua_State *L)
+{
+  BufferView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  if (lua_type (L, 2) == LUA_TNUMBER)
+    {
+      lgi_Unsigned index = lua_tointeger (L, 2);
+      if (index > 0 && (gsize) index <= view->size)
+	lua_pushinteger (L, view->data[index - 1]);
+      else
+	lua_pushnil (L);
+    }
+  else
+    {
+      /* Lookup the method in the table stored as upvalue. */
+      lua_pushvalue (L, 2);
+      lua_rawget (L, lua_upvalueindex (1));
+    }
+  return 1;
+}
+
+static int
+buffer_view_newindex (lua_State *L)
+{
+  return luaL_error (L, "bytes.view is read-only");
+}
+
+/* view:sub(i[, j]) creates new view of the range, semantics of i, j
+   arguments are the same as in string.sub(). */
+static int
+buffer_view_sub (lua_State *L)
+{
+  BufferView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  lua_Integer size = view->size;
+  lua_Integer start = luaL_checkinteger (L, 2);
+  lua_Integer end = luaL_optinteger (L, 3, -1);
+  if (start < 0)
+    start += size + 1;
+  if (start < 1)
+    start = 1;
+  else if (start > size + 1)
+    start = size + 1;
+  if (end < 0)
+    end += size + 1;
+  if (end > size)
+    end = size;
+
+  /* New view does not own the native memory, it keeps parent view
+     alive instead. */
+  lgi_buffer_view_new (L, view->data + start - 1,
+		       (start <= end) ? end - start + 1 : 0, NULL, NULL);
+  buffer_view_keep (L, 1);
+  return 1;
+}
+
+/* view:int(pos[, width]) and view:uint(pos[, width]) read integer of
+   specified width (1, 2, 4 or 8, default 4) in native byte order, pos
+   is 1-based byte offset of the integer. */
+static int
+buffer_view_read (lua_State *L, gboolean is_signed)
+{
+  BufferView *view = luaL_checkudata (L, 1, LGI_BYTES_VIEW);
+  lua_Integer pos = luaL_checkinteger (L, 2);
+  lua_Integer width = luaL_optinteger (L, 3, 4);
+  const guint8 *data;
+  luaL_argcheck (L, width == 1 || width == 2 || width == 4 || width == 8,
+		 3, "bad integer width");
+  luaL_argcheck (L, pos > 0 && (gsize) (pos - 1 + width) <= view->size,
+		 2, "bad index");
+  data = view->data + pos - 1;
+  switch (width)
+    {
+#define HANDLE_WIDTH(w, stype, utype)			\
+      case w:						\
+	{						\
+	  utype val;					\
+	  memcpy (&val, data, w);			\
+	  if (is_signed)				\
+	    lua_pushinteger (L, (stype) val);		\
+	  else						\
+	    lua_pushinteger (L, val);			\
+	  break;					\
+	}
+
+      HANDLE_WIDTH(1, gint8, guint8)
+      HANDLE_WIDTH(2, gint16, guint16)
+      HANDLE_WIDTH(4, gint32, guint32)
+      HANDLE_WIDTH(8, gint64, guint64)
+#undef HANDLE_WIDTH
+    }
+  return 1;
+}
+
+static int
+buffer_view_int (lua_State *L)
+{
+  return buffer_view_read (L, TRUE);
+}
+
+static int
+buffer_view_uint (lua_State *L)
+{
+  return buffer_view_read (L, FALSE);
+}
+
+static const luaL_Reg buffer_view_mt_reg[] = {
+  { "__gc", buffer_view_gc },
+  { "__len", buffer_view_len },
+  { "__tostring", buffer_view_tostring },
+  { "__newindex", buffer_view_newindex },
+  { NULL, NULL }
+};
+
+static const luaL_Reg buffer_view_methods_reg[] = {
+  { "sub", buffer_view_sub },
+  { "int", buffer_view_int },
+  { "uint", buffer_view_uint },
+  { NULL, NULL }
+};
+
+/* bytes.view(source) creates read-only view of given string, bytes
+   buffer or GLib.Bytes instance, without copying its contents. */
+static int
+buffer_view (lua_State *L)
+{
+  gpointer data;
+  size_t size;
+
+  if (lua_type (L, 1) == LUA_TSTRING)
+    {
+      data = (gpointer) lua_tolstring (L, 1, &size);
+      lgi_buffer_view_new (L, data, size, NULL, NULL);
+      buffer_view_keep (L, 1);
+    }
+  else if ((data = lgi_udata_test (L, 1, LGI_BYTES_BUFFER)) != NULL)
+    {
+      lgi_buffer_view_new (L, data, lua_objlen (L, 1), NULL, NULL);
+      buffer_view_keep (L, 1);
+    }
+  else if (lgi_udata_test (L, 1, LGI_BYTES_VIEW) != NULL)
+    lua_pushvalue (L, 1);
+  else
+    {
+#if GLIB_CHECK_VERSION(2, 32, 0)
+      GBytes *bytes = NULL;
+      lgi_type_get_repotype (L, G_TYPE_BYTES, NULL);
+      lgi_record_2c (L, 1, &bytes, FALSE, FALSE, TRUE, TRUE);
+      if (bytes != NULL)
+	{
+	  data = (gpointer) g_bytes_get_data (bytes, &size);
+	  lgi_buffer_view_new (L, data, size, g_bytes_ref (bytes),
+			       (GDestroyNotify) g_bytes_unref);
+	}
+      else
+#endif
+	return luaL_argerror (L, 1, "string, bytes or GLib.Bytes expected");
+    }
+  return 1;
+}
+
+/* Buffer of numeric elements of the same type, which can be passed
+   to and from C arrays in one block. */
+typedef struct _TypedBuffer
+{
+  /* Type tag of elements and number of elements. */
+  GITypeTag tag;
+  gsize length;
+
+  /* Pointer to the elements; points either right behind this header
+     or to the block owned by owner. */
+  gpointer data;
+  gpointer owner;
+  GDestroyNotify destroy;
+
+  /* Set for buffers viewing immutable memory. */
+  gboolean readonly;
+} TypedBuffer;
+
+/* Supported element types of typed buffers. */
+static const char *const typed_names[] = {
+  "int8", "uint8", "int16", "uint16", "int32", "uint32",
+  "int64", "uint64", "float", "double", NULL
+};
+static const GITypeTag typed_tags[] = {
+  GI_TYPE_TAG_INT8, GI_TYPE_TAG_UINT8, GI_TYPE_TAG_INT16,
+  GI_TYPE_TAG_UINT16, GI_TYPE_TAG_INT32, GI_TYPE_TAG_UINT32,
+  GI_TYPE_TAG_INT64, GI_TYPE_TAG_UINT64, GI_TYPE_TAG_FLOAT,
+  GI_TYPE_TAG_DOUBLE
+};
+static const gsize typed_sizes[] = {
+  1, 1, 2, 2, 4, 4, 8, 8, sizeof (gfloat), sizeof (gdouble)
+};
+
+/* Gets index of given tag in typed_ tables, -1 if not supported. */
+static int
+buffer_typed_index (GITypeTag tag)
+{
+  int i;
+  for (i = 0; typed_names[i] != NULL; i++)
+    if (typed_tags[i] == tag)
+      return i;
+  return -1;
+}
+
+gboolean
+lgi_buffer_typed_new (lua_State *L, GITypeTag tag, gpointer data,
+		      gsize length, gpointer owner, GDestroyNotify destroy)
+{
+  TypedBuffer *buffer;
+  int type = buffer_typed_index (tag);
+  if (type < 0)
+    return FALSE;
+
+  if (owner == NULL && length > (G_MAXSIZE - sizeof (TypedBuffer))
+      / typed_sizes[type])
+    luaL_error (L, "typed buffer of %lu elements is too large",
+		(unsigned long) length);
+  buffer = lua_newuserdata (L, sizeof (TypedBuffer)
+			    + (owner ? 0 : length * typed_sizes[type]));
+  buffer->tag = tag;
+  buffer->length = length;
+  buffer->owner = owner;
+  buffer->destroy = destroy;
+  buffer->readonly = FALSE;
+  if (owner != NULL)
+    buffer->data = data;
+  else
+    {
+      buffer->data = &buffer[1];
+      if (data != NULL)
+	memcpy (buffer->data, data, length * typed_sizes[type]);
+      else
+	memset (buffer->data, 0, length * typed_sizes[type]);
+    }
+  luaL_getmetatable (L, LGI_TYPED_BUFFER);
+  lua_setmetatable (L, -2);
+  return TRUE;
+}
+
+void
+lgi_buffer_typed_freeze (lua_State *L, int narg)
+{
+  TypedBuffer *buffer = luaL_checkudata (L, narg, LGI_TYPED_BUFFER);
+  buffer->readonly = TRUE;
+}
+
+gpointer
+lgi_buffer_typed_get (lua_State *L, int narg, GITypeTag tag, gsize *length)
+{
+  TypedBuffer *buffer = lgi_udata_test (L, narg, LGI_TYPED_BUFFER);
+  if (buffer == NULL || buffer->tag != tag)
+    return NULL;
+
+  *length = buffer->length;
+  return buffer->data;
+}
+
+static int
+buffer_typed_gc (lua_State *L)
+{
+  TypedBuffer *buffer = luaL_checkudata (L, 1, LGI_TYPED_BUFFER);
+  if (buffer->owner != NULL && buffer->destroy != NULL)
+    buffer->destroy (buffer->owner);
+  buffer->owner = NULL;
+  buffer->length = 0;
+  return 0;
+}
+
+static int
+buffer_typed_len (lua_State *L)
+{
+  TypedBuffer *buffer = luaL_checkudata (L, 1, LGI_TYPED_BUFFER);
+  lua_pushinteger (L, buffer->length);
+  return 1;
+}
+
+static int
+buffer_typed_tostring (lua_State *L)
+{
+  TypedBuffer *buffer = luaL_checkudata (L, 1, LGI_TYPED_BUFFER);
+  lua_pushlstring (L, buffer->data, buffer->length
+		   * typed_sizes[buffer_typed_index (buffer->tag)]);
+  return 1;
+}
+
+static int
+buffer_typed_index_mt (lua_State *L)
+{
+  TypedBuffer *buffer = luaL_checkudata (L, 1, LGI_TYPED_BUFFER);
+  lgi_Unsigned index = lua_tointeger (L, 2);
+  if (lua_type (L, 2) == LUA_TNUMBER
+      && index > 0 && (gsize) index <= buffer->length)
+    {
+      index--;
+      switch (buffer->tag)
+	{
+#define HANDLE_INT(nameupper, nametype)				\
+	  case GI_TYPE_TAG_ ## nameupper:			\
+	    lua_pushinteger (L, ((nametype *) buffer->data)[index]);	\
+	    break;
+
+	  HANDLE_INT(INT8, gint8)
+	  HANDLE_INT(UINT8, guint8)
+	  HANDLE_INT(INT16, gint16)
+	  HANDLE_INT(UINT16, guint16)
+	  HANDLE_INT(INT32, gint32)
+	  HANDLE_INT(UINT32, guint32)
+	  HANDLE_INT(INT64, gint64)
+	  HANDLE_INT(UINT64, guint64)
+#undef HANDLE_INT
+
+	case GI_TYPE_TAG_FLOAT:
+	  lua_pushnumber (L, ((gfloat *) buffer->data)[index]);
+	  break;
+
+	case GI_TYPE_TAG_DOUBLE:
+	  lua_pushnumber (L, ((gdouble *) buffer->data)[index]);
+	  break;
+
+	default:
+	  g_assert_not_reached ();
+	}
+    }
+  else if (g_strcmp0 (lua_tostring (L, 2), "type") == 0)
+    lua_pushstring (L, typed_names[buffer_typed_index (buffer->tag)]);
+  else
+    {
+      luaL_argcheck (L, !lua_isnoneornil (L, 2), 2, "nil index");
+      lua_pushnil (L);
+    }
+  return 1;
+}
+
+/* Stores Lua value at narg into index-th element of the buffer. */
+static void
+buffer_typed_set (lua_State *L, TypedBuffer *buffer, gsize index, int narg)
+{
+  switch (buffer->tag)
+    {
+#define HANDLE_INT(nameupper, nametype)					\
+      case GI_TYPE_TAG_ ## nameupper:					\
+	((nametype *) buffer->data)[index] = (nametype) luaL_checknumber (L, narg); \
+	break;
+
+      HANDLE_INT(INT8, gint8)
+      HANDLE_INT(UINT8, guint8)
+      HANDLE_INT(INT16, gint16)
+      HANDLE_INT(UINT16, guint16)
+      HANDLE_INT(INT32, gint32)
+      HANDLE_INT(UINT32, guint32)
+#undef HANDLE_INT
+
+    case GI_TYPE_TAG_INT64:
+      ((gint64 *) buffer->data)[index] = luaL_checkinteger (L, narg);
+      break;
+
+    case GI_TYPE_TAG_UINT64:
+      ((guint64 *) buffer->data)[index] = luaL_checkinteger (L, narg);
+      break;
+
+    case GI_TYPE_TAG_FLOAT:
+      ((gfloat *) buffer->data)[index] = luaL_checknumber (L, narg);
+      break;
+
+    case GI_TYPE_TAG_DOUBLE:
+      ((gdouble *) buffer->data)[index] = luaL_checknumber (L, narg);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static int
+buffer_typed_newindex (lua_State *L)
+{
+  lgi_Unsigned index;
+  TypedBuffer *buffer = luaL_checkudata (L, 1, LGI_TYPED_BUFFER);
+  luaL_argcheck (L, !buffer->readonly, 1, "read-only buffer");
+  index = luaL_checkint (L, 2);
+  luaL_argcheck (L, index > 0 && (gsize) index <= buffer->length,
+		 2, "bad index");
+  buffer_typed_set (L, buffer, index - 1, 3);
+  return 0;
+}
+
+static const luaL_Reg buffer_typed_mt_reg[] = {
+  { "__gc", buffer_typed_gc },
+  { "__len", buffer_typed_len },
+  { "__tostring", buffer_typed_tostring },
+  { "__index", buffer_typed_index_mt },
+  { "__newindex", buffer_typed_newindex },
+  { NULL, NULL }
+};
+
+/* bytes.new(type, count|table) creates typed buffer, either
+   zero-filled or initialized with contents of given table. */
+static int
+buffer_typed_new (lua_State *L)
+{
+  int type = luaL_checkoption (L, 1, NULL, typed_names);
+  gsize index, length;
+  TypedBuffer *buffer;
+
+  if (lua_istable (L, 2))
+    length = lua_objlen (L, 2);
+  else
+    {
+      int count = luaL_checkint (L, 2);
+      luaL_argcheck (L, count >= 0 && (gsize) count
+		     <= G_MAXSIZE / typed_sizes[type], 2, "invalid count");
+      length = count;
+    }
+  lgi_buffer_typed_new (L, typed_tags[type], NULL, length, NULL, NULL);
+  if (lua_istable (L, 2))
+    {
+      buffer = lua_touserdata (L, -1);
+      for (index = 0; index < length; index++)
+	{
+	  lua_rawgeti (L, 2, index + 1);
+	  buffer_typed_set (L, buffer, index, -1);
+	  lua_pop (L, 1);
+	}
+    }
+  return 1;
+}
+
 static int
 buffer_new (lua_State *L)
 {
@@ -70,6 +578,10 @@ buffer_new (lua_State *L)
   gpointer *buffer;
   const char *source = NULL;
 
+  /* Check for typed variant of the buffer. */
+  if (lua_type (L, 1) == LUA_TSTRING && !lua_isnoneornil (L, 2))
+    return buffer_typed_new (L);
+
   if (lua_type (L, 1) == LUA_TSTRING)
     source = lua_tolstring (L, 1, &size);
   else
@@ -84,8 +596,160 @@ buffer_new (lua_State *L)
   return 1;
 }
 
+/* Layout of cairo_path_t and cairo_path_data_t, which is part of
+   stable cairo ABI; lgi does not depend on cairo headers. */
+typedef union _CairoPathData
+{
+  struct { int type; int length; } header;
+  struct { double x, y; } point;
+} CairoPathData;
+
+typedef struct _CairoPath
+{
+  int status;
+  CairoPathData *data;
+  int num_data;
+} CairoPath;
+
+/* Path operations, in the order of cairo_path_data_type_t values.
+   Operations are encoded as characters of ops strings. */
+static const char path_ops[] = "MLCZ";
+static const int path_op_coords[] = { 2, 2, 6, 0 };
+
+/* Gets coordinate from typed buffer or table. */
+static double
+path_coord (lua_State *L, const double *coords, gsize index)
+{
+  double coord;
+  if (coords != NULL)
+    return coords[index];
+
+  lua_rawgeti (L, 1, index + 1);
+  if (!lua_isnumber (L, -1))
+    luaL_error (L, "number expected at coordinate %d", (int) index + 1);
+  coord = lua_tonumber (L, -1);
+  lua_pop (L, 1);
+  return coord;
+}
+
+/* Packs flat array of coordinates into cairo_path_t, stored in bytes
+   buffer which can be passed to cairo_append_path().  coords is
+   either typed buffer of doubles or table of numbers.  ops is string
+   of operations 'M' (move_to), 'L' (line_to), 'C' (curve_to) and 'Z'
+   (close_path), each of them consuming its coordinates from coords.
+   When ops is nil, the coordinates form polyline.  Lua prototype:
+   buffer = cairo.path_pack(coords[, ops]) */
+static int
+buffer_path_pack (lua_State *L)
+{
+  const double *coords;
+  const char *ops;
+  size_t n_ops, i;
+  gsize n_coords, needed = 0, index = 0;
+  int num_data = 0, op;
+  CairoPath *path;
+  CairoPathData *data;
+
+  coords = lgi_buffer_typed_get (L, 1, GI_TYPE_TAG_DOUBLE, &n_coords);
+  if (coords == NULL)
+    {
+      luaL_checktype (L, 1, LUA_TTABLE);
+      n_coords = lua_objlen (L, 1);
+    }
+  ops = luaL_optlstring (L, 2, NULL, &n_ops);
+
+  /* Count the size of the path. */
+  if (ops == NULL)
+    {
+      needed = n_coords - n_coords % 2;
+      num_data = needed;
+    }
+  else
+    for (i = 0; i < n_ops; i++)
+      {
+	const char *pos = strchr (path_ops, ops[i]);
+	if (ops[i] == '\0' || pos == NULL)
+	  return luaL_argerror (L, 2, lua_pushfstring
+				(L, "bad path operation '%c'", ops[i]));
+	op = pos - path_ops;
+	needed += path_op_coords[op];
+	num_data += path_op_coords[op] / 2 + 1;
+      }
+  if (needed != n_coords)
+    return luaL_argerror (L, 1, lua_pushfstring
+			  (L, "%d coordinates expected, got %d",
+			   (int) needed, (int) n_coords));
+
+  /* Create the path. */
+  path = lua_newuserdata (L, sizeof (CairoPath)
+			  + num_data * sizeof (CairoPathData));
+  path->status = 0;
+  path->data = data = (CairoPathData *) &path[1];
+  path->num_data = num_data;
+  for (i = 0; ops != NULL ? i < n_ops : index < n_coords; i++)
+    {
+      int j, points;
+      op = (ops != NULL) ? strchr (path_ops, ops[i]) - path_ops : (i > 0);
+      points = path_op_coords[op] / 2;
+      data->header.type = op;
+      data->header.length = points + 1;
+      data++;
+      for (j = 0; j < points; j++, data++)
+	{
+	  data->point.x = path_coord (L, coords, index++);
+	  data->point.y = path_coord (L, coords, index++);
+	}
+    }
+  luaL_getmetatable (L, LGI_BYTES_BUFFER);
+  lua_setmetatable (L, -2);
+  return 1;
+}
+
+/* Unpacks cairo_path_t at given address into typed buffer of
+   coordinates and string of operations, in the format accepted by
+   path_pack.  Lua prototype:
+   coords, ops = cairo.path_unpack(addr) */
+static int
+buffer_path_unpack (lua_State *L)
+{
+  const CairoPath *path;
+  const CairoPathData *data;
+  luaL_Buffer ops;
+  gsize n_coords = 0, index = 0;
+  double *coords;
+  int i, j;
+
+  luaL_checktype (L, 1, LUA_TLIGHTUSERDATA);
+  path = lua_touserdata (L, 1);
+  for (i = 0; i < path->num_data; i += path->data[i].header.length)
+    n_coords += 2 * (path->data[i].header.length - 1);
+
+  lgi_buffer_typed_new (L, GI_TYPE_TAG_DOUBLE, NULL, n_coords, NULL, NULL);
+  coords = lgi_buffer_typed_get (L, -1, GI_TYPE_TAG_DOUBLE, &n_coords);
+  luaL_buffinit (L, &ops);
+  for (i = 0; i < path->num_data; i += path->data[i].header.length)
+    {
+      data = &path->data[i];
+      luaL_addchar (&ops, path_ops[data->header.type & 3]);
+      for (j = 1; j < data->header.length; j++)
+	{
+	  coords[index++] = data[j].point.x;
+	  coords[index++] = data[j].point.y;
+	}
+    }
+  luaL_pushresult (&ops);
+  return 2;
+}
+
+static const luaL_Reg buffer_path_reg[] = {
+  { "path_pack", buffer_path_pack },
+  { "path_unpack", buffer_path_unpack },
+  { NULL, NULL }
+};
+
 static const luaL_Reg buffer_reg[] = {
   { "new", buffer_new },
+  { "view", buffer_view },
   { NULL, NULL }
 };
 
@@ -96,9 +760,24 @@ lgi_buffer_init (lua_State *L)
   luaL_newmetatable (L, LGI_BYTES_BUFFER);
   luaL_register (L, NULL, buffer_mt_reg);
   lua_pop (L, 1);
+  luaL_newmetatable (L, LGI_BYTES_VIEW);
+  luaL_register (L, NULL, buffer_view_mt_reg);
+  lua_newtable (L);
+  luaL_register (L, NULL, buffer_view_methods_reg);
+  lua_pushcclosure (L, buffer_view_index, 1);
+  lua_setfield (L, -2, "__index");
+  lua_pop (L, 1);
+  luaL_newmetatable (L, LGI_TYPED_BUFFER);
+  luaL_register (L, NULL, buffer_typed_mt_reg);
+  lua_pop (L, 1);
 
   /* Register global API. */
   lua_newtable (L);
   luaL_register (L, NULL, buffer_reg);
   lua_setfield (L, -2, "bytes");
+
+  /* Register cairo path helpers. */
+  lua_newtable (L);
+  luaL_register (L, NULL, buffer_path_reg);
+  lua_setfield (L, -2, "cairo");
 }
@@ -11,6 +11,7 @@
 
 #include "lgi.h"
 #include <string.h>
+#include <time.h>
 #include <ffi.h>
 
 /* Kinds or Param structure variation. */
@@ -65,8 +66,62 @@ typedef struct _Param
   /* Index into env table attached to the callable, contains repotype
      table for specified argument. */
   guint repotype_index : 4;
+
+  /* Following fields form precompiled call plan, filled in by
+     callable_param_compile().  Cached type tag of ti, valid only when
+     ti is not NULL. */
+  guint tag : 5;
+
+  /* Set if the value is a scalar which can be marshalled without
+     consulting the typeinfo. */
+  guint scalar : 1;
+
+  /* Set if the value may be omitted (nil) on the Lua side. */
+  guint optional : 1;
+
+  /* Set for out:caller-allocates arguments. */
+  guint caller_alloc : 1;
 } Param;
 
+/* Kinds of 'self' argument of the callable. */
+typedef enum _SelfKind
+  {
+    /* Self is an object or interface instance. */
+    SELF_KIND_OBJECT = 0,
+
+    /* Self is a struct or union. */
+    SELF_KIND_RECORD,
+
+    /* Self of different kind, should not happen. */
+    SELF_KIND_OTHER
+  } SelfKind;
+
+/* Phases of the call distinguished by the profiler. */
+typedef enum _ProfilePhase
+  {
+    /* Waiting for the state lock. */
+    PROFILE_LOCK = 0,
+
+    /* Marshalling arguments into the callee. */
+    PROFILE_IN,
+
+    /* The call itself, i.e. ffi_call() of C function or Lua call of
+       the closure target. */
+    PROFILE_CALL,
+
+    /* Marshalling return values back to the caller. */
+    PROFILE_OUT,
+
+    PROFILE_PHASES
+  } ProfilePhase;
+
+/* Accumulated profile of the callable, times are in nanoseconds. */
+typedef struct _CallableProfile
+{
+  guint64 calls;
+  gint64 time[PROFILE_PHASES];
+} CallableProfile;
+
 /* Structure representing userdata allocated for any callable, i.e. function,
    method, signal, vtable, callback... */
 typedef struct _Callable
@@ -87,6 +142,38 @@ typedef struct _Callable
   guint ignore_retval : 1;
   guint is_closure_marshal : 1;
 
+  /* Set if the return value (possibly ignored) is not void. */
+  guint has_retval : 1;
+
+  /* Set if returned owned uint8 arrays should be marshalled as
+     read-only bytes views instead of strings. */
+  guint bytes_view : 1;
+
+  /* Set if returned numeric arrays should be marshalled as typed
+     buffers instead of tables. */
+  guint typed_buffers : 1;
+
+  /* Set if returned owned lists and hash tables should be marshalled
+     as lazy container proxies instead of tables. */
+  guint lazy_containers : 1;
+
+  /* Set if the state lock is kept locked during the call.  Useful
+     for trivial functions which can neither block nor call back. */
+  guint keep_lock : 1;
+
+  /* Kind of 'self' argument, one of SelfKind values, valid only when
+     has_self is set. */
+  guint self_kind : 2;
+
+  /* Container of the callable and its GType, describing 'self'
+     argument. */
+  GIBaseInfo *self_info;
+  GType self_gtype;
+
+  /* Profile of the callable, allocated when the callable is first
+     invoked with the profiler running. */
+  CallableProfile *profile;
+
   /* Initialized FFI CIF structure. */
   ffi_cif cif;
 
@@ -129,23 +216,18 @@ typedef struct _FfiClosure
   /* Pointer to the block to which this closure belongs. */
   FfiClosureBlock *block;
 
-  union
-  {
-    struct
-    {
-      /* Lua reference to associated Callable. */
-      int callable_ref;
+  /* Lua reference to associated Callable. */
+  int callable_ref;
 
-      /* Callable's target to be invoked (either function,
-	 userdata/table with __call metafunction or coroutine (which
-	 is resumed instead of called). */
-      int target_ref;
-    };
+  /* Callable's target to be invoked (either function, userdata/table
+     with __call metafunction or coroutine (which is resumed instead
+     of called). */
+  int target_ref;
 
-    /* Closure's entry point, stored only temporarily until closure is
-       created. */
-    gpointer call_addr;
-  };
+  /* Closure's entry point.  Kept for the whole lifetime of the
+     closure, so that the closure can be prepared again when its block
+     is recycled from the pool. */
+  gpointer call_addr;
 
   /* Flag indicating whether closure should auto-destroy itself after it is
      called. */
@@ -169,6 +251,10 @@ struct _FfiClosureBlock
      contained already in this header. */
   int closures_count;
 
+  /* Next free block in the closure pool, valid only when the block is
+     stored in the pool. */
+  FfiClosureBlock *next_free;
+
   /* Variable-length array of pointers to other closures.
      Unfortunately libffi does not allow to allocate contiguous block
      containing more closures, otherwise this array would simply
@@ -180,6 +266,41 @@ struct _FfiClosureBlock
 /* lightuserdata key to callable cache table. */
 static int callable_cache;
 
+/* lightuserdata key to table of functions which keep the state lock
+   during the call.  Indexed by C symbol names or namespace names. */
+static int callable_keep_lock;
+
+/* Maximal number of closures in the block, limited by the size of
+   Param::n_closures field. */
+#define CLOSURE_POOL_SLOTS 16
+
+/* Maximal number of released blocks kept in every slot of the pool. */
+#define CLOSURE_POOL_MAX 16
+
+/* Pool of released closure blocks, avoiding repeated allocation of
+   executable memory for callbacks.  Kept per Lua state as a userdata
+   in the registry, free blocks are indexed by their closures count. */
+typedef struct _ClosurePool
+{
+  FfiClosureBlock *free[CLOSURE_POOL_SLOTS];
+  guint size[CLOSURE_POOL_SLOTS];
+
+  /* Memory statistics: number of allocated blocks (both outstanding
+     and pooled ones), number of blocks handed out and not yet
+     destroyed and total size of memory allocated by
+     ffi_closure_alloc() for the blocks. */
+  guint blocks;
+  guint outstanding;
+  gsize ffi_bytes;
+
+  /* Set when the pool was already collected, i.e. the state is being
+     closed.  Blocks are not pooled but freed immediately then. */
+  guint closed : 1;
+} ClosurePool;
+
+/* lightuserdata key to ClosurePool userdata. */
+static int closure_pool;
+
 /* Gets ffi_type for given tag, returns NULL if it cannot be handled. */
 static ffi_type *
 get_simple_ffi_type (GITypeTag tag)
@@ -288,6 +409,60 @@ callable_param_init (Param *param)
   param->call_scoped_user_data = FALSE;
   param->kind = PARAM_KIND_TI;
   param->repotype_index = 0;
+  param->tag = GI_TYPE_TAG_VOID;
+  param->scalar = FALSE;
+  param->optional = TRUE;
+  param->caller_alloc = FALSE;
+}
+
+/* Precompiles information needed by marshallers during the call, so
+   that the typelib does not have to be queried for it repeatedly. */
+static void
+callable_param_compile (Param *param)
+{
+  if (param->ti != NULL)
+    {
+      param->tag = g_type_info_get_tag (param->ti);
+      param->scalar = lgi_marshal_tag_is_scalar (param->tag);
+    }
+  if (param->has_arg_info)
+    {
+      param->optional = (g_arg_info_is_optional (&param->ai)
+			 || g_arg_info_may_be_null (&param->ai));
+      param->caller_alloc = (param->dir != GI_DIRECTION_IN
+			     && g_arg_info_is_caller_allocates (&param->ai));
+    }
+}
+
+/* Precompiles 'self' and return value information of the callable. */
+static void
+callable_compile (Callable *callable)
+{
+  int argi;
+
+  callable_param_compile (&callable->retval);
+  for (argi = 0; argi < callable->nargs; argi++)
+    callable_param_compile (&callable->params[argi]);
+
+  callable->has_retval = (callable->retval.ti == NULL
+			  || callable->retval.tag != GI_TYPE_TAG_VOID
+			  || g_type_info_is_pointer (callable->retval.ti));
+
+  if (callable->has_self)
+    {
+      GIBaseInfo *parent = g_base_info_get_container (callable->info);
+      GIInfoType type = g_base_info_get_type (parent);
+      callable->self_info = parent;
+      if (type == GI_INFO_TYPE_OBJECT || type == GI_INFO_TYPE_INTERFACE)
+	{
+	  callable->self_kind = SELF_KIND_OBJECT;
+	  callable->self_gtype = g_registered_type_info_get_g_type (parent);
+	}
+      else if (type == GI_INFO_TYPE_STRUCT || type == GI_INFO_TYPE_UNION)
+	callable->self_kind = SELF_KIND_RECORD;
+      else
+	callable->self_kind = SELF_KIND_OTHER;
+    }
 }
 
 static Callable *
@@ -314,6 +489,15 @@ callable_allocate (lua_State *L, int nargs, ffi_type ***ffi_args)
   callable->throws = 0;
   callable->ignore_retval = 0;
   callable->is_closure_marshal = 0;
+  callable->has_retval = 0;
+  callable->bytes_view = 0;
+  callable->typed_buffers = 0;
+  callable->lazy_containers = 0;
+  callable->keep_lock = 0;
+  callable->self_kind = SELF_KIND_OTHER;
+  callable->self_info = NULL;
+  callable->self_gtype = G_TYPE_INVALID;
+  callable->profile = NULL;
 
   /* Clear all 'internal' flags inside callable parameters, parameters are then
      marked as internal during processing of their parents. */
@@ -377,6 +561,19 @@ lgi_callable_create (lua_State *L, GICallableInfo *info, gpointer addr)
 	/* Fail with the error message. */
 	return luaL_error (L, "could not locate %s(%s): %s",
 			   lua_tostring (L, -3), symbol, g_module_error ());
+
+      /* Check whether the function keeps the lock, either by its
+	 symbol or by its whole namespace. */
+      lua_pushlightuserdata (L, &callable_keep_lock);
+      lua_rawget (L, LUA_REGISTRYINDEX);
+      lua_getfield (L, -1, symbol);
+      if (lua_isnil (L, -1))
+	{
+	  lua_pop (L, 1);
+	  lua_getfield (L, -1, g_base_info_get_namespace (info));
+	}
+      callable->keep_lock = lua_toboolean (L, -1);
+      lua_pop (L, 2);
     }
   else if (GI_IS_SIGNAL_INFO (info))
     /* Signals always have 'self', i.e. the object on which they are
@@ -452,6 +649,9 @@ lgi_callable_create (lua_State *L, GICallableInfo *info, gpointer addr)
   if (callable->throws)
     *ffi_arg++ = &ffi_type_pointer;
 
+  /* Prepare the call plan. */
+  callable_compile (callable);
+
   /* Create ffi_cif. */
   if (ffi_prep_cif (&callable->cif, FFI_DEFAULT_ABI,
 		    callable->has_self + nargs + callable->throws,
@@ -621,6 +821,14 @@ lgi_callable_parse (lua_State *L, int info, gpointer addr)
   if (callable->throws)
     ffi_args[i] = &ffi_type_pointer;
 
+  /* Handle 'keep_lock' flag. */
+  lua_getfield (L, info, "keep_lock");
+  callable->keep_lock = lua_toboolean (L, -1);
+  lua_pop (L, 1);
+
+  /* Prepare the call plan. */
+  callable_compile (callable);
+
   /* Create ffi_cif. */
   if (ffi_prep_cif (&callable->cif, FFI_DEFAULT_ABI,
 		    nargs + callable->throws,
@@ -676,6 +884,8 @@ callable_gc (lua_State *L)
     callable_param_destroy (&callable->params[i]);
 
   callable_param_destroy (&callable->retval );
+  g_free (callable->profile);
+  callable->profile = NULL;
 
   /* Unset the metatable / make the callable unusable */
   lua_pushnil (L);
@@ -734,6 +944,154 @@ callable_tostring (lua_State *L)
   return 1;
 }
 
+/* Set while the profiler is running.  Process-wide; checked once at
+   the start of every call and callback. */
+static gboolean callable_profiling;
+
+/* lightuserdata key to registry, containing weak table with all
+   callables which have allocated profile. */
+static int callable_profiles;
+
+/* Timestamps of single profiled call. */
+typedef struct _ProfileMarks
+{
+  gint64 last;
+  gint64 time[PROFILE_PHASES];
+} ProfileMarks;
+
+static gint64
+profile_now (void)
+{
+#if defined (CLOCK_MONOTONIC) && !defined (G_OS_WIN32)
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64) ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+#else
+  return g_get_monotonic_time () * 1000;
+#endif
+}
+
+/* Starts profiling, returns marks to be used for the call or NULL if
+   the profiler is not running. */
+#define PROFILE_BEGIN(marks_data)				\
+  (G_UNLIKELY (callable_profiling)				\
+   ? profile_begin (&(marks_data)) : NULL)
+
+/* Accounts time elapsed since the previous mark to given phase. */
+#define PROFILE_MARK(marks, phase)				\
+  do {								\
+    if (G_UNLIKELY ((marks) != NULL))				\
+      profile_mark ((marks), (phase));				\
+  } while (0)
+
+static ProfileMarks *
+profile_begin (ProfileMarks *marks)
+{
+  memset (marks, 0, sizeof (*marks));
+  marks->last = profile_now ();
+  return marks;
+}
+
+static void
+profile_mark (ProfileMarks *marks, ProfilePhase phase)
+{
+  gint64 now = profile_now ();
+  marks->time[phase] += now - marks->last;
+  marks->last = now;
+}
+
+/* Finishes profiled call, accounting the rest of the time as
+   marshalling of return values.  'narg' is the absolute stack index
+   of callable userdata. */
+static void
+profile_commit (lua_State *L, int narg, Callable *callable,
+		ProfileMarks *marks)
+{
+  int i;
+
+  profile_mark (marks, PROFILE_OUT);
+  if (G_UNLIKELY (callable->profile == NULL))
+    {
+      /* Register the callable, so that it is found by the report. */
+      luaL_checkstack (L, 3, "");
+      callable->profile = g_new0 (CallableProfile, 1);
+      lua_pushlightuserdata (L, &callable_profiles);
+      lua_rawget (L, LUA_REGISTRYINDEX);
+      lua_pushvalue (L, narg);
+      lua_pushboolean (L, 1);
+      lua_rawset (L, -3);
+      lua_pop (L, 1);
+    }
+
+  callable->profile->calls++;
+  for (i = 0; i < PROFILE_PHASES; i++)
+    callable->profile->time[i] += marks->time[i];
+}
+
+/* Controls the profiler.  Lua prototypes:
+   callable.profile('start') -- resets all profiles and starts profiling
+   callable.profile('stop')
+   records = callable.profile('report')
+
+   Report is an array of records with fields 'name', 'calls', 'lock',
+   'marshal_in', 'call' and 'marshal_out', times are in seconds. */
+static int
+callable_profile (lua_State *L)
+{
+  static const char *const verbs[] = { "start", "stop", "report", NULL };
+  static const char *const phases[] = {
+    "lock", "marshal_in", "call", "marshal_out"
+  };
+  int verb = luaL_checkoption (L, 1, NULL, verbs), index = 0, i;
+  Callable *callable;
+
+  lua_settop (L, 1);
+  if (verb == 1)
+    {
+      callable_profiling = FALSE;
+      return 0;
+    }
+
+  lua_pushlightuserdata (L, &callable_profiles);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  if (verb == 2)
+    lua_newtable (L);
+  lua_pushnil (L);
+  while (lua_next (L, 2) != 0)
+    {
+      lua_pop (L, 1);
+      /* Collected callables can be still present in the table. */
+      callable = lua_touserdata (L, -1);
+      if (callable->profile == NULL)
+	continue;
+      if (verb == 0)
+	memset (callable->profile, 0, sizeof (CallableProfile));
+      else if (callable->profile->calls > 0)
+	{
+	  lua_createtable (L, 0, 6);
+	  lua_pushcfunction (L, callable_tostring);
+	  lua_pushvalue (L, -3);
+	  lua_call (L, 1, 1);
+	  lua_setfield (L, -2, "name");
+	  lua_pushnumber (L, (lua_Number) callable->profile->calls);
+	  lua_setfield (L, -2, "calls");
+	  for (i = 0; i < PROFILE_PHASES; i++)
+	    {
+	      lua_pushnumber (L, callable->profile->time[i] / 1e9);
+	      lua_setfield (L, -2, phases[i]);
+	    }
+	  lua_rawseti (L, 3, ++index);
+	}
+    }
+
+  if (verb == 0)
+    {
+      callable_profiling = TRUE;
+      return 0;
+    }
+  return 1;
+}
+
 static int
 callable_param_2c (lua_State *L, Param *param, int narg, int parent,
 		   GIArgument *arg, int callable_index,
@@ -752,7 +1110,11 @@ callable_param_2c (lua_State *L, Param *param, int narg, int parent,
 
   if (param->kind != PARAM_KIND_RECORD)
     {
-      if (param->ti)
+      if (param->scalar)
+	lgi_marshal_2c_scalar (L, param->tag, arg, narg,
+			       param->optional
+			       || parent == LGI_PARENT_CALLER_ALLOC, parent);
+      else if (param->ti)
 	nret = lgi_marshal_2c (L, param->ti,
 			       param->has_arg_info ? &param->ai : NULL,
 			       param->transfer, arg, narg, parent,
@@ -787,11 +1149,27 @@ callable_param_2lua (lua_State *L, Param *param, GIArgument *arg,
 {
   if (param->kind != PARAM_KIND_RECORD)
     {
-      if (param->ti)
-	lgi_marshal_2lua (L, param->ti, callable->info ? &param->ai : NULL,
-			  param->dir, param->transfer,
-			  arg, parent, callable->info,
-			  args + callable->has_self);
+      if (param->scalar)
+	lgi_marshal_2lua_scalar (L, param->tag, arg, parent);
+      else if (param->ti)
+	{
+	  if (param->tag == GI_TYPE_TAG_ARRAY)
+	    {
+	      if (callable->typed_buffers)
+		parent = LGI_PARENT_TYPED_BUFFER;
+	      else if (callable->bytes_view)
+		parent = LGI_PARENT_BYTES_VIEW;
+	    }
+	  else if ((param->tag == GI_TYPE_TAG_GLIST
+		    || param->tag == GI_TYPE_TAG_GSLIST
+		    || param->tag == GI_TYPE_TAG_GHASH)
+		   && callable->lazy_containers)
+	    parent = LGI_PARENT_LAZY_CONTAINER;
+	  lgi_marshal_2lua (L, param->ti, callable->info ? &param->ai : NULL,
+			    param->dir, param->transfer,
+			    arg, parent, callable->info,
+			    args + callable->has_self);
+	}
       else
 	{
 	  union { GIArgument arg; ffi_sarg i; } *u = (gpointer) arg;
@@ -821,53 +1199,86 @@ callable_param_2lua (lua_State *L, Param *param, GIArgument *arg,
     }
 }
 
+/* Marshals 'self' argument of the callable from given stack index.
+   Returns number of temporary values left on the stack. */
 static int
-callable_call (lua_State *L)
+callable_self_2c (lua_State *L, Callable *callable, int narg,
+		  GIArgument *arg)
+{
+  if (callable->self_kind == SELF_KIND_OBJECT)
+    arg->v_pointer =
+      lgi_object_2c (L, narg, callable->self_gtype, FALSE, FALSE, FALSE);
+  else
+    {
+      lgi_type_get_repotype (L, G_TYPE_INVALID, callable->self_info);
+      lgi_record_2c (L, narg, &arg->v_pointer, FALSE, FALSE, FALSE, FALSE);
+    }
+  return 1;
+}
+
+/* State of single invocation of the callable, shared by ordinary
+   calls and calls offloaded to worker threads. */
+typedef struct _CallState
 {
-  Param *param;
-  int i, lua_argi, nret, caller_allocated = 0, nargs;
   GIArgument retval, *args;
   void **ffi_args, **redirect_out;
-  GError *err = NULL;
-  gpointer state_lock = lgi_state_get_lock (L);
-  Callable *callable = callable_get (L, 1);
+  GError *err;
+  gpointer **scoped_closures;
+  int n_scoped_closures;
+  int caller_allocated;
+} CallState;
+
+/* Sets up arrays of the state, 'mem' must point to memory of
+   CALL_STATE_SIZE(callable) bytes. */
+#define CALL_STATE_SIZE(callable)					\
+  (((callable)->nargs + (callable)->has_self)				\
+   * (sizeof (GIArgument) + sizeof (gpointer *))			\
+   + ((callable)->nargs + (callable)->has_self + (callable)->throws)	\
+   * 2 * sizeof (void *))
+
+static void
+call_state_init (CallState *state, Callable *callable, gpointer mem)
+{
+  int nargs = callable->nargs + callable->has_self;
+  state->args = mem;
+  state->redirect_out = (void **) (state->args + nargs);
+  state->ffi_args = state->redirect_out + nargs + callable->throws;
+  state->scoped_closures =
+    (gpointer **) (state->ffi_args + nargs + callable->throws);
+  state->err = NULL;
+  state->n_scoped_closures = 0;
+  state->caller_allocated = 0;
+}
+
+/* Marshals input arguments of the callable, which is expected at
+   stack index 'narg', followed by its Lua arguments.  Returns number
+   of temporary values left on the stack; caller-allocated output
+   values are stored below them. */
+static int
+callable_call_prepare (lua_State *L, int narg, Callable *callable,
+		       CallState *state)
+{
+  Param *param;
+  int i, lua_argi, nret, nargs;
+  GIArgument *args = state->args;
+  void **ffi_args = state->ffi_args, **redirect_out = state->redirect_out;
 
   /* Make sure that all unspecified arguments are set as nil; during
      marshalling we might create temporary values on the stack, which
      can be confused with input arguments expected but not passed by
      caller. */
-  lua_settop(L, callable->has_self + callable->nargs + 1);
+  lua_settop(L, callable->has_self + callable->nargs + narg);
 
   /* We cannot push more stuff than count of arguments we have. */
   luaL_checkstack (L, callable->nargs, "");
-
-  /* Prepare data for the call. */
   nargs = callable->nargs + callable->has_self;
-  args = g_newa (GIArgument, nargs);
-  redirect_out = g_newa (void *, nargs + callable->throws);
-  ffi_args = g_newa (void *, nargs + callable->throws);
 
   /* Prepare 'self', if present. */
-  lua_argi = 2;
+  lua_argi = narg + 1;
   nret = 0;
   if (callable->has_self)
     {
-      GIBaseInfo *parent = g_base_info_get_container (callable->info);
-      GIInfoType type = g_base_info_get_type (parent);
-      if (type == GI_INFO_TYPE_OBJECT || type == GI_INFO_TYPE_INTERFACE)
-	{
-	  args[0].v_pointer =
-	    lgi_object_2c (L, 2, g_registered_type_info_get_g_type (parent),
-			   FALSE, FALSE, FALSE);
-	  nret++;
-	}
-      else
-	{
-	  lgi_type_get_repotype (L, G_TYPE_INVALID, parent);
-	  lgi_record_2c (L, 2, &args[0].v_pointer, FALSE, FALSE, FALSE, FALSE);
-	  nret++;
-	}
-
+      nret += callable_self_2c (L, callable, narg + 1, &args[0]);
       ffi_args[0] = &args[0];
       lua_argi++;
     }
@@ -894,9 +1305,14 @@ callable_call (lua_State *L)
 	{
 	  args[argi].v_pointer = lgi_closure_allocate (L, param->n_closures);
 	  if (param->call_scoped_user_data)
-	    /* Add guard which releases closure block after the
-	       call. */
-	    *lgi_guard_create (L, lgi_closure_destroy) = args[argi].v_pointer;
+	    {
+	      /* Add guard which releases closure block if the call is
+		 not reached, otherwise the block is released right
+		 after the call. */
+	      gpointer *guard = lgi_scratch_guard (L, lgi_closure_destroy);
+	      *guard = args[argi].v_pointer;
+	      state->scoped_closures[state->n_scoped_closures++] = guard;
+	    }
 	}
     }
 
@@ -909,10 +1325,10 @@ callable_call (lua_State *L)
 	int argi = i + callable->has_self;
 	if (param->dir != GI_DIRECTION_OUT)
 	  nret += callable_param_2c (L, param, lua_argi++, 0, &args[argi],
-				     1, callable, ffi_args);
+				     narg, callable, ffi_args);
 	/* Special handling for out/caller-alloc structures; we have to
 	   manually pre-create them and store them on the stack. */
-	else if (callable->info && g_arg_info_is_caller_allocates (&param->ai)
+	else if (param->caller_alloc
 		 && lgi_marshal_2c_caller_alloc (L, param->ti, &args[argi], 0))
 	  {
 	    /* Even when marked as OUT, caller-allocates arguments
@@ -922,7 +1338,7 @@ callable_call (lua_State *L)
 	    /* Move the value on the stack *below* any already present
 	       temporary values. */
 	    lua_insert (L, -nret - 1);
-	    caller_allocated++;
+	    state->caller_allocated++;
 	  }
 	else
 	  /* Normal OUT parameters.  Ideally we don't have to touch
@@ -936,32 +1352,44 @@ callable_call (lua_State *L)
   /* Add error for 'throws' type function. */
   if (callable->throws)
     {
-      redirect_out[nargs] = &err;
+      redirect_out[nargs] = &state->err;
       ffi_args[nargs] = &redirect_out[nargs];
     }
 
-  /* Unlock the state. */
-  lgi_state_leave (state_lock);
+  return nret;
+}
 
-  /* Call the function. */
-  ffi_call (&callable->cif, callable->address, &retval, ffi_args);
+/* Releases resources of the performed call and marshals its results.
+   Expects the callable at stack index 1 and 'ntemps' temporaries
+   returned by callable_call_prepare() at the top of the stack.
+   Returns number of values pushed. */
+static int
+callable_call_finish (lua_State *L, Callable *callable, CallState *state,
+		      int ntemps)
+{
+  Param *param;
+  int i, nret, caller_allocated = state->caller_allocated;
+  GIArgument *retval = &state->retval;
 
-  /* Heading back to Lua, lock the state back again. */
-  lgi_state_enter (state_lock);
+  /* Call-scoped closures cannot be invoked any more, return them to
+     the pool immediately instead of waiting for their guards to be
+     collected. */
+  for (i = 0; i < state->n_scoped_closures; i++)
+    {
+      lgi_closure_destroy (*state->scoped_closures[i]);
+      *state->scoped_closures[i] = NULL;
+    }
 
   /* Pop any temporary items from the stack which might be stored there by
      marshalling code. */
-  lua_pop (L, nret);
+  lua_pop (L, ntemps);
 
   /* Handle return value. */
   nret = 0;
-  if (!callable->ignore_retval
-      && (callable->retval.ti == NULL
-	  || (g_type_info_get_tag (callable->retval.ti) != GI_TYPE_TAG_VOID
-	      || g_type_info_is_pointer (callable->retval.ti))))
+  if (!callable->ignore_retval && callable->has_retval)
     {
-      callable_param_2lua (L, &callable->retval, &retval, LGI_PARENT_IS_RETVAL,
-			   1, callable, ffi_args);
+      callable_param_2lua (L, &callable->retval, retval, LGI_PARENT_IS_RETVAL,
+			   1, callable, state->ffi_args);
       nret++;
       lua_insert (L, -caller_allocated - 1);
     }
@@ -972,12 +1400,12 @@ callable_call (lua_State *L)
       union {
 	GIArgument arg;
 	ffi_sarg s;
-      } *ru = (gpointer) &retval;
+      } *ru = (gpointer) retval;
       ru->arg.v_boolean = (gboolean) ru->s;
     }
 
   /* Check, whether function threw. */
-  if (err != NULL)
+  if (state->err != NULL)
     {
       if (nret == 0)
 	{
@@ -987,7 +1415,7 @@ callable_call (lua_State *L)
 
       /* Wrap error instance into GLib.Error record. */
       lgi_type_get_repotype (L, G_TYPE_ERROR, NULL);
-      lgi_record_2lua (L, err, TRUE, 0);
+      lgi_record_2lua (L, state->err, TRUE, 0);
       return nret + 1;
     }
 
@@ -996,7 +1424,7 @@ callable_call (lua_State *L)
   for (i = 0; i < callable->nargs; i++, param++)
     if (!param->internal && param->dir != GI_DIRECTION_IN)
       {
-	if (callable->info && g_arg_info_is_caller_allocates (&param->ai)
+	if (param->caller_alloc
 	    && lgi_marshal_2c_caller_alloc (L, param->ti, NULL,
 					    -caller_allocated  - nret))
 	  /* Caller allocated parameter is already marshalled and
@@ -1005,15 +1433,15 @@ callable_call (lua_State *L)
 	else
 	  {
 	    /* Marshal output parameter. */
-	    callable_param_2lua (L, param, &args[i + callable->has_self],
-				 0, 1, callable, ffi_args);
+	    callable_param_2lua (L, param, &state->args[i + callable->has_self],
+				 0, 1, callable, state->ffi_args);
 	    lua_insert (L, -caller_allocated - 1);
 	  }
 
 	/* In case that this callable is in ignore-retval mode and
 	   function actually returned FALSE, replace the already
 	   marshalled return value with NULL. */
-	if (callable->ignore_retval && !retval.v_boolean)
+	if (callable->ignore_retval && !retval->v_boolean)
 	  {
 	    lua_pushnil (L);
 	    lua_replace (L, -caller_allocated - 2);
@@ -1035,6 +1463,392 @@ callable_call (lua_State *L)
   return nret;
 }
 
+static int
+callable_call (lua_State *L)
+{
+  int nret;
+  CallState state;
+  gpointer state_lock = lgi_state_get_lock (L);
+  Callable *callable = callable_get (L, 1);
+  ProfileMarks marks_data, *marks = PROFILE_BEGIN (marks_data);
+  LgiScratch *scratch;
+
+  /* Prepare data for the call. */
+  call_state_init (&state, callable, g_alloca (CALL_STATE_SIZE (callable)));
+
+  /* Temporaries of the call are allocated in the scratch arena;
+     address of 'scratch' identifies the frame of this call. */
+  scratch = lgi_scratch_enter (L, 1, &scratch);
+  nret = callable_call_prepare (L, 1, callable, &state);
+
+  /* Unlock the state, unless the callable is known not to block. */
+  PROFILE_MARK (marks, PROFILE_IN);
+  lgi_scratch_suspend (scratch, &scratch);
+  if (!callable->keep_lock)
+    lgi_state_leave (state_lock);
+
+  /* Call the function. */
+  ffi_call (&callable->cif, callable->address, &state.retval,
+	    state.ffi_args);
+  PROFILE_MARK (marks, PROFILE_CALL);
+
+  /* Heading back to Lua, lock the state back again. */
+  if (!callable->keep_lock)
+    lgi_state_enter (state_lock);
+  lgi_scratch_resume (scratch, &scratch);
+  PROFILE_MARK (marks, PROFILE_LOCK);
+
+  nret = callable_call_finish (L, callable, &state, nret);
+  lgi_scratch_leave (scratch, &scratch);
+  if (G_UNLIKELY (marks != NULL))
+    profile_commit (L, 1, callable, marks);
+  return nret;
+}
+
+/* Invokes the callable repeatedly, once for every tuple of arguments,
+   releasing the state lock only once for all the calls.  Lua
+   prototype:
+   results = callable:batch(fixed_args..., args)
+
+   Only callables whose arguments are all scalar inputs, optionally
+   preceded by 'self' and other non-scalar input arguments, are
+   supported.  The leading non-scalar arguments (fixed_args) are
+   marshalled only once and are the same for all calls.  args is
+   either table of argument tuples, flat table or typed buffer
+   containing remaining arguments of all calls in sequence; for
+   callables without scalar arguments it is the count of calls.  Returns
+   table with return values if the callable returns some value,
+   otherwise returns number of performed calls. */
+static int
+callable_batch (lua_State *L)
+{
+  Callable *callable = callable_get (L, 1);
+  int nargs = callable->nargs + callable->has_self;
+  int fixed, nscalar, argi, lua_argi, i, count, narg;
+  GIArgument *args, *retvals, *fixed_args;
+  void **ffi_args;
+  Param *param;
+  gboolean tuples = FALSE;
+  gpointer buffer = NULL;
+  gsize length = 0, esize = 0;
+  gpointer state_lock;
+  LgiScratch *scratch;
+
+  /* Check that the callable is suitable for batching. */
+  luaL_argcheck (L, !callable->throws
+		 && (!callable->has_retval || callable->retval.scalar),
+		 1, "callable not suitable for batch");
+  for (fixed = 0; fixed < callable->nargs && !callable->params[fixed].scalar;
+       fixed++)
+    luaL_argcheck (L, callable->params[fixed].dir == GI_DIRECTION_IN
+		   && !callable->params[fixed].internal
+		   && callable->params[fixed].n_closures == 0,
+		   1, "callable not suitable for batch");
+  for (i = fixed, param = &callable->params[fixed]; i < callable->nargs;
+       i++, param++)
+    luaL_argcheck (L, param->scalar && param->dir == GI_DIRECTION_IN
+		   && !param->internal, 1, "callable not suitable for batch");
+  nscalar = callable->nargs - fixed;
+  fixed += callable->has_self;
+
+  /* Marshal fixed arguments; their temporaries stay on the stack or
+     in the scratch arena until we return. */
+  lua_argi = 2 + fixed;
+  luaL_checkany (L, lua_argi);
+  lua_settop (L, lua_argi);
+  scratch = lgi_scratch_enter (L, 1, &scratch);
+  fixed_args = g_newa (GIArgument, fixed + 1);
+  ffi_args = g_newa (void *, nargs + 1);
+  if (callable->has_self)
+    callable_self_2c (L, callable, 2, &fixed_args[0]);
+  for (argi = callable->has_self; argi < fixed; argi++)
+    callable_param_2c (L, &callable->params[argi - callable->has_self],
+		       2 + argi, 0, &fixed_args[argi], 1, callable, ffi_args);
+  for (argi = 0; argi < fixed; argi++)
+    ffi_args[argi] = &fixed_args[argi];
+
+  /* Find out the source of the scalar arguments and the count of
+     calls. */
+  if (nscalar > 0)
+    {
+      GITypeTag tag = callable->params[fixed - callable->has_self].tag;
+      buffer = lgi_buffer_typed_get (L, lua_argi, tag, &length);
+      if (buffer != NULL)
+	{
+	  for (i = fixed - callable->has_self; i < callable->nargs; i++)
+	    luaL_argcheck (L, callable->params[i].tag == tag,
+			   lua_argi, "buffer type mismatch");
+	  esize = get_simple_ffi_type (tag)->size;
+	}
+      else
+	{
+	  luaL_checktype (L, lua_argi, LUA_TTABLE);
+	  length = lua_objlen (L, lua_argi);
+	  lua_rawgeti (L, lua_argi, 1);
+	  tuples = lua_istable (L, -1);
+	  lua_pop (L, 1);
+	}
+      if (tuples)
+	count = length;
+      else
+	{
+	  luaL_argcheck (L, length % nscalar == 0, lua_argi,
+			 "incomplete argument tuple");
+	  count = length / nscalar;
+	}
+    }
+  else
+    {
+      count = luaL_checkinteger (L, lua_argi);
+      luaL_argcheck (L, count >= 0, lua_argi, "bad count");
+    }
+
+  /* Marshal scalar arguments of all calls. */
+  args = lua_newuserdata (L, sizeof (GIArgument) * ((gsize) count
+						    * (nscalar + 1) + 1));
+  retvals = args + (gsize) count * nscalar;
+  for (i = 0; i < count; i++)
+    for (argi = 0; argi < nscalar; argi++)
+      {
+	GIArgument *arg = &args[(gsize) i * nscalar + argi];
+	param = &callable->params[fixed - callable->has_self + argi];
+	if (buffer != NULL)
+	  {
+	    memcpy (arg, (guint8 *) buffer
+		    + ((gsize) i * nscalar + argi) * esize, esize);
+	    continue;
+	  }
+	if (tuples)
+	  {
+	    lua_rawgeti (L, lua_argi, i + 1);
+	    luaL_argcheck (L, lua_istable (L, -1), lua_argi,
+			   "table of tuples expected");
+	    lua_rawgeti (L, -1, argi + 1);
+	    narg = -2;
+	  }
+	else
+	  {
+	    lua_rawgeti (L, lua_argi, i * nscalar + argi + 1);
+	    narg = -1;
+	  }
+	lgi_marshal_2c_scalar (L, param->tag, arg, -1, param->optional, 0);
+	lua_pop (L, -narg);
+      }
+
+  /* Perform all the calls. */
+  state_lock = lgi_state_get_lock (L);
+  lgi_scratch_suspend (scratch, &scratch);
+  if (!callable->keep_lock)
+    lgi_state_leave (state_lock);
+  for (i = 0; i < count; i++)
+    {
+      for (argi = 0; argi < nscalar; argi++)
+	ffi_args[fixed + argi] = &args[(gsize) i * nscalar + argi];
+      ffi_call (&callable->cif, callable->address, &retvals[i], ffi_args);
+    }
+  if (!callable->keep_lock)
+    lgi_state_enter (state_lock);
+  lgi_scratch_leave (scratch, &scratch);
+
+  /* Collect the results. */
+  if (!callable->has_retval)
+    {
+      lua_pushinteger (L, count);
+      return 1;
+    }
+
+  lua_createtable (L, count, 0);
+  for (i = 0; i < count; i++)
+    {
+      lgi_marshal_2lua_scalar (L, callable->retval.tag, &retvals[i],
+			       LGI_PARENT_IS_RETVAL);
+      lua_rawseti (L, -2, i + 1);
+    }
+  return 1;
+}
+
+/* Gets C type name and kind of the value for the LuaJIT FFI fast
+   path, returns FALSE if the value cannot go through it.  Kinds are
+   'number', 'int64', 'boolean', 'string', 'object' and 'record'. */
+static gboolean
+callable_fastpath_type (Param *param, const char **ctype, const char **kind)
+{
+  static const char *const ctypes[] = {
+    "int", "int8_t", "uint8_t", "int16_t", "uint16_t", "int32_t",
+    "uint32_t", "int64_t", "uint64_t", "float", "double"
+  };
+
+  if (param->transfer != GI_TRANSFER_NOTHING)
+    return FALSE;
+  if (param->kind == PARAM_KIND_RECORD)
+    {
+      *ctype = "void *";
+      *kind = "record";
+      return TRUE;
+    }
+  if (param->kind != PARAM_KIND_TI || param->ti == NULL)
+    return FALSE;
+
+  switch (param->tag)
+    {
+    case GI_TYPE_TAG_BOOLEAN:
+    case GI_TYPE_TAG_INT8:
+    case GI_TYPE_TAG_UINT8:
+    case GI_TYPE_TAG_INT16:
+    case GI_TYPE_TAG_UINT16:
+    case GI_TYPE_TAG_INT32:
+    case GI_TYPE_TAG_UINT32:
+    case GI_TYPE_TAG_INT64:
+    case GI_TYPE_TAG_UINT64:
+    case GI_TYPE_TAG_FLOAT:
+    case GI_TYPE_TAG_DOUBLE:
+      if (g_type_info_is_pointer (param->ti))
+	return FALSE;
+      *ctype = ctypes[param->tag - GI_TYPE_TAG_BOOLEAN];
+      *kind = (param->tag == GI_TYPE_TAG_BOOLEAN) ? "boolean"
+	: (param->tag == GI_TYPE_TAG_INT64
+	   || param->tag == GI_TYPE_TAG_UINT64) ? "int64" : "number";
+      return TRUE;
+
+    case GI_TYPE_TAG_UTF8:
+    case GI_TYPE_TAG_FILENAME:
+      *ctype = "const char *";
+      *kind = "string";
+      return TRUE;
+
+    case GI_TYPE_TAG_INTERFACE:
+      {
+	GIBaseInfo *ii = g_type_info_get_interface (param->ti);
+	GIInfoType type = g_base_info_get_type (ii);
+	g_base_info_unref (ii);
+	if ((type != GI_INFO_TYPE_OBJECT && type != GI_INFO_TYPE_INTERFACE)
+	    || !g_type_info_is_pointer (param->ti))
+	  return FALSE;
+	*ctype = "void *";
+	*kind = "object";
+	return TRUE;
+      }
+
+    default:
+      return FALSE;
+    }
+}
+
+/* Pushes description of the callable for the LuaJIT FFI fast path,
+   or nil if the callable cannot be called through it.  Only callables
+   keeping the state lock qualify, because code called through FFI
+   must neither call back nor let other threads enter the state.
+   All arguments must be inputs mapping to simple C types and the
+   callable must not throw.  The description contains 'addr', 'ctype'
+   (C function pointer type), 'ret' (kind of the return value or
+   'void'), kinds of the arguments in the array part, 'gtypes' and
+   'repos' tables with types of 'object' and 'record' arguments and
+   'optional' table marking arguments accepting nil. */
+static int
+callable_fastpath (lua_State *L, Callable *callable)
+{
+  const char *ctype, *kind, *ret_ctype = "void";
+  GString *args;
+  Param *param;
+  int i, index = 1;
+
+  if (!callable->keep_lock || callable->throws || callable->ignore_retval
+      || callable->address == NULL
+      || (callable->has_self && callable->self_kind == SELF_KIND_OTHER))
+    return 0;
+  for (i = 0, param = callable->params; i < callable->nargs; i++, param++)
+    if (param->internal || param->dir != GI_DIRECTION_IN
+	|| !callable_fastpath_type (param, &ctype, &kind))
+      return 0;
+  if (callable->has_retval)
+    {
+      if (!callable_fastpath_type (&callable->retval, &ret_ctype, &kind)
+	  || g_str_equal (kind, "object") || g_str_equal (kind, "record"))
+	return 0;
+    }
+  else
+    kind = "void";
+
+  lua_createtable (L, callable->nargs + callable->has_self, 6);
+  lua_pushstring (L, kind);
+  lua_setfield (L, -2, "ret");
+  lua_pushlightuserdata (L, callable->address);
+  lua_setfield (L, -2, "addr");
+  lua_newtable (L);
+  lua_setfield (L, -2, "gtypes");
+  lua_newtable (L);
+  lua_setfield (L, -2, "repos");
+  lua_newtable (L);
+  lua_setfield (L, -2, "optional");
+
+  /* Describe 'self' argument. */
+  if (callable->has_self)
+    {
+      lua_getfield (L, -1, callable->self_kind == SELF_KIND_OBJECT
+		    ? "gtypes" : "repos");
+      if (callable->self_kind == SELF_KIND_OBJECT)
+	lua_pushnumber (L, callable->self_gtype);
+      else
+	lgi_type_get_repotype (L, G_TYPE_INVALID, callable->self_info);
+      lua_rawseti (L, -2, index);
+      lua_pop (L, 1);
+      lua_pushstring (L, callable->self_kind == SELF_KIND_OBJECT
+		      ? "object" : "record");
+      lua_rawseti (L, -2, index++);
+    }
+
+  /* Describe the rest of arguments. */
+  for (i = 0, param = callable->params; i < callable->nargs; i++, param++)
+    {
+      callable_fastpath_type (param, &ctype, &kind);
+      if (g_str_equal (kind, "object") || g_str_equal (kind, "record"))
+	{
+	  lua_getfield (L, -1, kind[0] == 'o' ? "gtypes" : "repos");
+	  if (kind[0] == 'o')
+	    {
+	      GIBaseInfo *ii = g_type_info_get_interface (param->ti);
+	      lua_pushnumber (L, g_registered_type_info_get_g_type (ii));
+	      g_base_info_unref (ii);
+	    }
+	  else
+	    {
+	      lua_getfenv (L, 1);
+	      lua_rawgeti (L, -1, param->repotype_index);
+	      lua_replace (L, -2);
+	    }
+	  lua_rawseti (L, -2, index);
+	  lua_pop (L, 1);
+	}
+      if (param->optional)
+	{
+	  lua_getfield (L, -1, "optional");
+	  lua_pushboolean (L, 1);
+	  lua_rawseti (L, -2, index);
+	  lua_pop (L, 1);
+	}
+      lua_pushstring (L, kind);
+      lua_rawseti (L, -2, index++);
+    }
+
+  /* Build C type of the function pointer. */
+  args = g_string_new (ret_ctype);
+  g_string_append (args, " (*)(");
+  if (callable->has_self)
+    g_string_append (args, "void *");
+  for (i = 0, param = callable->params; i < callable->nargs; i++, param++)
+    {
+      callable_fastpath_type (param, &ctype, &kind);
+      if (i > 0 || callable->has_self)
+	g_string_append (args, ", ");
+      g_string_append (args, ctype);
+    }
+  g_string_append (args, index > 1 ? ")" : "void)");
+  lua_pushstring (L, args->str);
+  g_string_free (args, TRUE);
+  lua_setfield (L, -2, "ctype");
+  return 1;
+}
+
 static int
 callable_index (lua_State *L)
 {
@@ -1086,6 +1900,15 @@ callable_index (lua_State *L)
 		lua_pushboolean (L, 1);
 		lua_setfield (L, -2, "out");
 	      }
+
+	    /* Mark async callbacks with associated user_data. */
+	    if (param->has_arg_info
+		&& g_arg_info_get_scope (&param->ai) == GI_SCOPE_TYPE_ASYNC
+		&& g_arg_info_get_closure (&param->ai) >= 0)
+	      {
+		lua_pushboolean (L, 1);
+		lua_setfield (L, -2, "closure");
+	      }
 	    lua_rawseti (L, -2, index++);
 	  }
       return 1;
@@ -1095,6 +1918,33 @@ callable_index (lua_State *L)
       lua_pushlightuserdata (L, callable->user_data);
       return 1;
     }
+  else if (g_strcmp0 (verb, "bytes_view") == 0)
+    {
+      lua_pushboolean (L, callable->bytes_view);
+      return 1;
+    }
+  else if (g_strcmp0 (verb, "typed_buffers") == 0)
+    {
+      lua_pushboolean (L, callable->typed_buffers);
+      return 1;
+    }
+  else if (g_strcmp0 (verb, "lazy_containers") == 0)
+    {
+      lua_pushboolean (L, callable->lazy_containers);
+      return 1;
+    }
+  else if (g_strcmp0 (verb, "keep_lock") == 0)
+    {
+      lua_pushboolean (L, callable->keep_lock);
+      return 1;
+    }
+  else if (g_strcmp0 (verb, "batch") == 0)
+    {
+      lua_pushcfunction (L, callable_batch);
+      return 1;
+    }
+  else if (g_strcmp0 (verb, "fastpath") == 0)
+    return callable_fastpath (L, callable);
 
   return 0;
 }
@@ -1103,8 +1953,17 @@ static int
 callable_newindex (lua_State *L)
 {
   Callable *callable = callable_get (L, 1);
-  if (g_strcmp0 (lua_tostring (L, 2), "user_data") == 0)
+  const gchar *verb = lua_tostring (L, 2);
+  if (g_strcmp0 (verb, "user_data") == 0)
     callable->user_data = lua_touserdata (L, 3);
+  else if (g_strcmp0 (verb, "bytes_view") == 0)
+    callable->bytes_view = lua_toboolean (L, 3);
+  else if (g_strcmp0 (verb, "typed_buffers") == 0)
+    callable->typed_buffers = lua_toboolean (L, 3);
+  else if (g_strcmp0 (verb, "lazy_containers") == 0)
+    callable->lazy_containers = lua_toboolean (L, 3);
+  else if (g_strcmp0 (verb, "keep_lock") == 0)
+    callable->keep_lock = lua_toboolean (L, 3);
 
   return 0;
 }
@@ -1127,15 +1986,13 @@ marshal_arguments (lua_State *L, void **args, int callable_index, Callable *call
   /* Marshall 'self' argument, if it is present. */
   if (callable->has_self)
     {
-      GIBaseInfo *parent = g_base_info_get_container (callable->info);
-      GIInfoType type = g_base_info_get_type (parent);
       gpointer addr = ((GIArgument*) args[0])->v_pointer;
       npos++;
-      if (type == GI_INFO_TYPE_OBJECT || type == GI_INFO_TYPE_INTERFACE)
+      if (callable->self_kind == SELF_KIND_OBJECT)
 	lgi_object_2lua (L, addr, FALSE, FALSE);
-      else if (type == GI_INFO_TYPE_STRUCT || type == GI_INFO_TYPE_UNION)
+      else if (callable->self_kind == SELF_KIND_RECORD)
 	{
-	  lgi_type_get_repotype (L, G_TYPE_INVALID, parent);
+	  lgi_type_get_repotype (L, G_TYPE_INVALID, callable->self_info);
 	  lgi_record_2lua (L, addr, FALSE, 0);
 	}
       else
@@ -1189,7 +2046,6 @@ static void
 marshal_return_values (lua_State *L, void *ret, void **args, int callable_index, Callable *callable, int npos)
 {
   int to_pop, i;
-  GITypeTag tag;
   Param *param;
 
   /* Make sure that all unspecified returns and outputs are set as
@@ -1199,9 +2055,7 @@ marshal_return_values (lua_State *L, void *ret, void **args, int callable_index,
   lua_settop(L, lua_gettop (L) + callable->has_self + callable->nargs + 1);
 
   /* Marshal return value from Lua. */
-  tag = g_type_info_get_tag (callable->retval.ti);
-  if (tag != GI_TYPE_TAG_VOID
-      || g_type_info_is_pointer (callable->retval.ti))
+  if (callable->has_retval)
     {
       if (callable->ignore_retval)
 	/* Return value should be ignored on Lua side, so we have
@@ -1233,8 +2087,7 @@ marshal_return_values (lua_State *L, void *ret, void **args, int callable_index,
       {
 	gpointer *arg = args[i + callable->has_self];
 	gboolean caller_alloc =
-	  callable->info && g_arg_info_is_caller_allocates (&param->ai)
-	  && g_type_info_get_tag (param->ti) == GI_TYPE_TAG_INTERFACE;
+	  param->caller_alloc && param->tag == GI_TYPE_TAG_INTERFACE;
 	to_pop = callable_param_2c (L, param, npos, caller_alloc
 				    ? LGI_PARENT_CALLER_ALLOC : 0, *arg,
 				    callable_index, callable,
@@ -1272,7 +2125,7 @@ marshal_return_error (lua_State *L, void *ret, void **args, Callable *callable)
       }
 
     /* Such function should usually return FALSE, so do it. */
-    if (g_type_info_get_tag (callable->retval.ti) == GI_TYPE_TAG_BOOLEAN)
+    if (callable->retval.tag == GI_TYPE_TAG_BOOLEAN)
       *(gboolean *) ret = FALSE;
 }
 
@@ -1289,10 +2142,12 @@ closure_callback (ffi_cif *cif, void *ret, void **args, void *closure_arg)
   gboolean call;
   lua_State *L;
   lua_State *marshal_L;
+  ProfileMarks marks_data, *marks = PROFILE_BEGIN (marks_data);
   (void)cif;
 
   /* Get access to proper Lua context. */
   lgi_state_enter (block->callback.state_lock);
+  PROFILE_MARK (marks, PROFILE_LOCK);
   lua_rawgeti (block->callback.L, LUA_REGISTRYINDEX, block->callback.thread_ref);
   L = lua_tothread (block->callback.L, -1);
   call = (closure->target_ref != LUA_NOREF);
@@ -1353,6 +2208,7 @@ closure_callback (ffi_cif *cif, void *ret, void **args, void *closure_arg)
   callable_index = lua_gettop (marshal_L);
 
   npos = marshal_arguments (marshal_L, args, callable_index, callable);
+  PROFILE_MARK (marks, PROFILE_IN);
 
   /* Remove callable userdata from callable_index, otherwise they mess
      up carefully prepared stack structure. */
@@ -1404,6 +2260,7 @@ closure_callback (ffi_cif *cif, void *ret, void **args, void *closure_arg)
 	stacktop = lua_gettop (L);
     }
 
+  PROFILE_MARK (marks, PROFILE_CALL);
   lua_xmove (L, marshal_L, lua_gettop(L) - stacktop);
 
   /* Reintroduce callable to the stack, we might need it during
@@ -1418,6 +2275,8 @@ closure_callback (ffi_cif *cif, void *ret, void **args, void *closure_arg)
     marshal_return_values (marshal_L, ret, args, callable_index, callable, npos);
   else
     marshal_return_error (marshal_L, ret, args, callable);
+  if (G_UNLIKELY (marks != NULL))
+    profile_commit (marshal_L, callable_index, callable, marks);
 
   /* If the closure is marked as autodestroy, destroy it now.  Note that it is
      unfortunately not possible to destroy it directly here, because we would
@@ -1436,14 +2295,62 @@ closure_callback (ffi_cif *cif, void *ret, void **args, void *closure_arg)
   lgi_state_leave (block->callback.state_lock);
 }
 
-/* Destroys specified closure. */
+/* Size of executable memory allocated for the block of given number
+   of closures beyond the first one. */
+#define CLOSURE_BLOCK_SIZE(count)				\
+  (offsetof (FfiClosureBlock, ffi_closures)			\
+   + (count) * (sizeof (FfiClosure *) + sizeof (FfiClosure)))
+
+/* Frees memory of all closures in the block. */
+static void
+closure_block_free (FfiClosureBlock *block)
+{
+  int i;
+  for (i = block->closures_count - 1; i >= 0; --i)
+    ffi_closure_free (block->ffi_closures[i]);
+  ffi_closure_free (&block->ffi_closure);
+}
+
+/* Retrieves closure pool of given state. */
+static ClosurePool *
+closure_pool_get (lua_State *L)
+{
+  ClosurePool *pool;
+  lua_pushlightuserdata (L, &closure_pool);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  pool = lua_touserdata (L, -1);
+  lua_pop (L, 1);
+  return pool;
+}
+
+static int
+closure_pool_gc (lua_State *L)
+{
+  ClosurePool *pool = lua_touserdata (L, 1);
+  FfiClosureBlock *block;
+  int i;
+
+  for (i = 0; i < CLOSURE_POOL_SLOTS; i++)
+    while (pool->free[i] != NULL)
+      {
+	block = pool->free[i];
+	pool->free[i] = block->next_free;
+	closure_block_free (block);
+      }
+  pool->closed = 1;
+  return 0;
+}
+
+/* Destroys specified closure.  The block is returned to the pool of
+   its state, where it is kept for the next lgi_closure_allocate(). */
 void
 lgi_closure_destroy (gpointer user_data)
 {
   FfiClosureBlock* block = user_data;
   lua_State *L = block->callback.L;
+  ClosurePool *pool;
   FfiClosure *closure;
-  int i;
+  int i, slot;
 
   for (i = block->closures_count - 1; i >= -1; --i)
     {
@@ -1452,10 +2359,29 @@ lgi_closure_destroy (gpointer user_data)
 	{
 	  luaL_unref (L, LUA_REGISTRYINDEX, closure->callable_ref);
 	  luaL_unref (L, LUA_REGISTRYINDEX, closure->target_ref);
+	  closure->created = 0;
+	}
+    }
+  luaL_unref (L, LUA_REGISTRYINDEX, block->callback.thread_ref);
+
+  pool = closure_pool_get (L);
+  slot = block->closures_count;
+  if (pool != NULL)
+    pool->outstanding--;
+  if (pool == NULL || pool->closed || pool->size[slot] >= CLOSURE_POOL_MAX)
+    {
+      if (pool != NULL)
+	{
+	  pool->blocks--;
+	  pool->ffi_bytes -= CLOSURE_BLOCK_SIZE (slot);
 	}
-      if (i < 0)
-	luaL_unref (L, LUA_REGISTRYINDEX, block->callback.thread_ref);
-      ffi_closure_free (closure);
+      closure_block_free (block);
+    }
+  else
+    {
+      block->next_free = pool->free[slot];
+      pool->free[slot] = block;
+      pool->size[slot]++;
     }
 }
 
@@ -1465,26 +2391,48 @@ gpointer
 lgi_closure_allocate (lua_State *L, int count)
 {
   gpointer call_addr;
+  FfiClosureBlock *block;
+  ClosurePool *pool = closure_pool_get (L);
   int i;
 
-  /* Allocate header block. */
-  FfiClosureBlock *block =
-    ffi_closure_alloc (offsetof (FfiClosureBlock, ffi_closures)
-		       + (--count * sizeof (FfiClosure*)), &call_addr);
-  block->ffi_closure.created = 0;
-  block->ffi_closure.call_addr = call_addr;
-  block->ffi_closure.block = block;
-  block->closures_count = count;
-
-  /* Allocate all additional closures. */
-  for (i = 0; i < count; ++i)
+  g_assert (count > 0 && count <= CLOSURE_POOL_SLOTS);
+  --count;
+  if (pool != NULL && pool->free[count] != NULL)
     {
-      block->ffi_closures[i] = ffi_closure_alloc (sizeof (FfiClosure),
-						  &call_addr);
-      block->ffi_closures[i]->created = 0;
-      block->ffi_closures[i]->call_addr = call_addr;
-      block->ffi_closures[i]->block = block;
+      /* Reuse already prepared block from the pool. */
+      block = pool->free[count];
+      pool->free[count] = block->next_free;
+      pool->size[count]--;
     }
+  else
+    {
+      /* Allocate header block. */
+      block = ffi_closure_alloc (offsetof (FfiClosureBlock, ffi_closures)
+				 + (count * sizeof (FfiClosure*)),
+				 &call_addr);
+      block->ffi_closure.created = 0;
+      block->ffi_closure.call_addr = call_addr;
+      block->ffi_closure.block = block;
+      block->closures_count = count;
+
+      /* Allocate all additional closures. */
+      for (i = 0; i < count; ++i)
+	{
+	  block->ffi_closures[i] = ffi_closure_alloc (sizeof (FfiClosure),
+						      &call_addr);
+	  block->ffi_closures[i]->created = 0;
+	  block->ffi_closures[i]->call_addr = call_addr;
+	  block->ffi_closures[i]->block = block;
+	}
+      if (pool != NULL)
+	{
+	  pool->blocks++;
+	  pool->ffi_bytes += CLOSURE_BLOCK_SIZE (count);
+	}
+    }
+  if (pool != NULL)
+    pool->outstanding++;
+  block->next_free = NULL;
 
   /* Store reference to target Lua thread. */
   block->callback.L = L;
@@ -1504,7 +2452,6 @@ lgi_closure_create (lua_State *L, gpointer user_data,
   FfiClosureBlock* block = user_data;
   FfiClosure *closure;
   Callable *callable;
-  gpointer call_addr;
   int i;
 
   /* Find pointer to target FfiClosure. */
@@ -1516,7 +2463,6 @@ lgi_closure_create (lua_State *L, gpointer user_data,
 
   /* Prepare callable and store reference to it. */
   callable = lua_touserdata (L, -1);
-  call_addr = closure->call_addr;
   closure->created = 1;
   closure->autodestroy = autodestroy;
   closure->callable_ref = luaL_ref (L, LUA_REGISTRYINDEX);
@@ -1533,18 +2479,419 @@ lgi_closure_create (lua_State *L, gpointer user_data,
       closure->target_ref = LUA_NOREF;
     }
 
-  /* Create closure. */
+  /* Create closure; recycled closures are simply prepared again in
+     place. */
   if (ffi_prep_closure_loc (&closure->ffi_closure, &callable->cif,
-			    closure_callback, closure, call_addr) != FFI_OK)
+			    closure_callback, closure,
+			    closure->call_addr) != FFI_OK)
     {
       lua_concat (L, lgi_type_get_name (L, callable->info));
       luaL_error (L, "failed to prepare closure for `%'", lua_tostring (L, -1));
       return NULL;
     }
 
-  return call_addr;
+  return closure->call_addr;
+}
+
+/* Queue of completed async operations, which were started with the
+   shared async trampoline.  Its env table contains the queueing
+   thread, dispatcher function and the batch of pending completions,
+   stored as (coroutine, source, result) triples. */
+typedef struct _AsyncQueue
+{
+  lua_State *L;
+  int count;
+  gboolean dispatching;
+
+  /* Main loop depth at which the running dispatch started. */
+  gint depth;
+} AsyncQueue;
+
+enum {
+  ASYNC_QUEUE_THREAD = 1,
+  ASYNC_QUEUE_DISPATCH,
+  ASYNC_QUEUE_BATCH
+};
+
+/* lightuserdata key to registry, containing AsyncQueue userdata. */
+static int async_queue;
+
+/* Dispatches batches of completions until the queue is drained.  The
+   env table of the queue is expected on the top of the stack of L.
+   The batch is replaced before dispatching, because resumed
+   coroutines can queue new completions. */
+static void
+async_queue_dispatch (lua_State *L, AsyncQueue *queue)
+{
+  gboolean dispatching = queue->dispatching;
+  gint depth = queue->depth;
+  int count;
+
+  queue->dispatching = TRUE;
+  queue->depth = g_main_depth ();
+  while (queue->count > 0)
+    {
+      count = queue->count;
+      queue->count = 0;
+      lua_rawgeti (L, -1, ASYNC_QUEUE_DISPATCH);
+      lua_rawgeti (L, -2, ASYNC_QUEUE_BATCH);
+      lua_newtable (L);
+      lua_rawseti (L, -4, ASYNC_QUEUE_BATCH);
+      lua_pushinteger (L, count);
+      if (lua_pcall (L, 2, 0, 0) != 0)
+	{
+	  g_warning ("%s", lua_tostring (L, -1));
+	  lua_pop (L, 1);
+	}
+    }
+  queue->dispatching = dispatching;
+  queue->depth = depth;
+}
+
+/* GAsyncReadyCallback shared by all async operations started from
+   coroutines.  'user_data' is the closure block allocated for the
+   call, which references the calling coroutine.  The completion is
+   queued and the block is returned to the pool.  Completions arriving
+   while the queue is being dispatched (e.g. operations finishing
+   synchronously in resumed coroutines) are only appended and picked
+   up by the running dispatch in the next batch, instead of resuming
+   coroutines recursively.  Completions arriving from main loop
+   iterated inside the running dispatch (a resumed coroutine blocking
+   in nested Gio.Async.call or modal loop) are dispatched re-entrantly
+   on a fresh thread, otherwise they would never be delivered.
+   GAsyncResult is declared as plain GObject, because lgi does not
+   depend on gio headers. */
+static void
+async_queue_ready (GObject *source, GObject *result, gpointer user_data)
+{
+  FfiClosureBlock *block = user_data;
+  gpointer state_lock = block->callback.state_lock;
+  AsyncQueue *queue;
+  lua_State *L, *T;
+  int base;
+
+  lgi_state_enter (state_lock);
+  L = block->callback.L;
+  lua_pushlightuserdata (L, &async_queue);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  queue = lua_touserdata (L, -1);
+  lua_pop (L, 1);
+
+  /* Append the completion to the batch. */
+  L = queue->L;
+  luaL_checkstack (L, 5, "");
+  lua_pushlightuserdata (L, &async_queue);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_getfenv (L, -1);
+  lua_rawgeti (L, -1, ASYNC_QUEUE_BATCH);
+  base = queue->count++ * 3;
+  lua_rawgeti (L, LUA_REGISTRYINDEX, block->callback.thread_ref);
+  lua_rawseti (L, -2, base + 1);
+  lgi_object_2lua (L, source, FALSE, FALSE);
+  lua_rawseti (L, -2, base + 2);
+  lgi_object_2lua (L, result, FALSE, FALSE);
+  lua_rawseti (L, -2, base + 3);
+  lua_pop (L, 1);
+  lgi_closure_destroy (block);
+
+  if (!queue->dispatching)
+    async_queue_dispatch (L, queue);
+  else if (g_main_depth () > queue->depth)
+    {
+      /* Nested dispatch; queue->L is busy resuming the coroutine
+	 which iterates the loop, so run on new (anchored) thread. */
+      T = lua_newthread (L);
+      lua_pushvalue (L, -2);
+      lua_xmove (L, T, 1);
+      async_queue_dispatch (T, queue);
+      lua_pop (L, 1);
+    }
+  lua_pop (L, 2);
+  lgi_state_leave (state_lock);
+}
+
+/* Registers dispatcher of async completions and returns address of
+   shared async trampoline, to be passed as GAsyncReadyCallback
+   argument.  Lua prototype:
+   addr = callable.async(function(batch, count)) */
+static int
+callable_async (lua_State *L)
+{
+  luaL_checktype (L, 1, LUA_TFUNCTION);
+  lua_pushlightuserdata (L, &async_queue);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_getfenv (L, -1);
+  lua_pushvalue (L, 1);
+  lua_rawseti (L, -2, ASYNC_QUEUE_DISPATCH);
+  lua_pushlightuserdata (L, async_queue_ready);
+  return 1;
+}
+
+/* Call of the callable offloaded to the worker thread pool.  The
+   env table of the userdata contains OffloadEnv slots. */
+typedef struct _Offload
+{
+  Callable *callable;
+  CallState state;
+
+  /* Context in which the completion is delivered. */
+  GMainContext *context;
+  gpointer state_lock;
+
+  /* Thread used to deliver the completion and registry reference
+     keeping the userdata alive while the call is in progress. */
+  lua_State *L;
+  int ref;
+
+  /* Number of temporaries stored in the env table. */
+  int ntemps;
+
+  /* Completion source posted by the worker, until it is dispatched.
+     Protected by offload_mutex, together with 'running' and
+     'cancelled' flags. */
+  GSource *source;
+
+  /* Set while the worker performs the call and when the state is
+     being closed, so that completion must not be posted. */
+  guint running : 1;
+  guint cancelled : 1;
+
+  /* Set when the worker returned from the call and when its results
+     were already marshalled by finish(). */
+  guint done : 1;
+  guint finished : 1;
+} Offload;
+
+enum {
+  OFFLOAD_CALLABLE = 1,
+  OFFLOAD_DONE,
+  OFFLOAD_THREAD,
+  OFFLOAD_DRAIN,
+  OFFLOAD_TEMPS
+};
+
+#define UD_OFFLOAD "lgi.offload"
+
+/* Maximal number of worker threads, the same as GTask uses for its
+   blocking calls. */
+#define OFFLOAD_MAX_THREADS 10
+
+static GThreadPool *offload_pool;
+static GMutex *offload_mutex;
+static GCond *offload_cond;
+
+/* Delivers the completion of the call, invokes its 'done' callback in
+   the context which started the call. */
+static gboolean
+offload_complete (gpointer user_data)
+{
+  Offload *offload = user_data;
+  gpointer state_lock = offload->state_lock;
+  lua_State *L;
+
+  lgi_state_enter (state_lock);
+  g_mutex_lock (offload_mutex);
+  g_source_unref (offload->source);
+  offload->source = NULL;
+  g_mutex_unlock (offload_mutex);
+  L = offload->L;
+  luaL_checkstack (L, 3, "");
+  lua_rawgeti (L, LUA_REGISTRYINDEX, offload->ref);
+  luaL_unref (L, LUA_REGISTRYINDEX, offload->ref);
+  offload->ref = LUA_NOREF;
+  offload->done = TRUE;
+  lua_getfenv (L, -1);
+  lua_rawgeti (L, -1, OFFLOAD_DONE);
+  lua_pushvalue (L, -3);
+  if (lua_pcall (L, 1, 0, 0) != 0)
+    {
+      g_warning ("%s", lua_tostring (L, -1));
+      lua_pop (L, 1);
+    }
+  lua_pop (L, 2);
+  lgi_state_leave (state_lock);
+  return FALSE;
+}
+
+/* Worker of the thread pool, performs the call itself and posts its
+   completion to the context of the caller. */
+static void
+offload_run (gpointer data, gpointer user_data)
+{
+  Offload *offload = data;
+  GSource *source;
+  ffi_call (&offload->callable->cif, offload->callable->address,
+	    &offload->state.retval, offload->state.ffi_args);
+
+  g_mutex_lock (offload_mutex);
+  if (!offload->cancelled)
+    {
+      source = g_idle_source_new ();
+      g_source_set_priority (source, G_PRIORITY_DEFAULT);
+      g_source_set_callback (source, offload_complete, offload, NULL);
+      g_source_attach (source, offload->context);
+      offload->source = source;
+    }
+  offload->running = FALSE;
+  g_cond_broadcast (offload_cond);
+  g_mutex_unlock (offload_mutex);
+}
+
+/* Destroy notify of the guard created after all temporaries of the
+   call, so that when the state is being closed, it is collected
+   before them.  Waits until the worker returns from the call and
+   removes its pending completion, which would otherwise be delivered
+   into already closed state.  Does nothing when the completion was
+   already delivered. */
+static void
+offload_drain (gpointer data)
+{
+  Offload *offload = data;
+  g_mutex_lock (offload_mutex);
+  offload->cancelled = TRUE;
+  while (offload->running)
+    g_cond_wait (offload_cond, offload_mutex);
+  if (offload->source != NULL)
+    {
+      g_source_destroy (offload->source);
+      g_source_unref (offload->source);
+      offload->source = NULL;
+    }
+  g_mutex_unlock (offload_mutex);
+}
+
+/* Marshals arguments of the callable and starts the call in the
+   worker thread pool.  When the call returns, done(offload) is called
+   from the thread-default main context of the caller; results are
+   then retrieved by offload:finish().  Lua prototype:
+   offload = callable.offload(done, callable, args...) */
+static int
+callable_offload (lua_State *L)
+{
+  Offload *offload;
+  Callable *callable;
+  LgiScratch *scratch;
+  int i, base;
+
+  luaL_checktype (L, 1, LUA_TFUNCTION);
+  callable = callable_get (L, 2);
+
+  /* Create offload record, it replaces 'done' argument at the
+     stack. */
+  offload = lua_newuserdata (L, sizeof (Offload)
+			     + CALL_STATE_SIZE (callable));
+  offload->callable = callable;
+  call_state_init (&offload->state, callable, offload + 1);
+  offload->context = NULL;
+  offload->state_lock = lgi_state_get_lock (L);
+  offload->ref = LUA_NOREF;
+  offload->source = NULL;
+  offload->running = offload->cancelled = FALSE;
+  offload->done = offload->finished = FALSE;
+  luaL_getmetatable (L, UD_OFFLOAD);
+  lua_setmetatable (L, -2);
+  lua_createtable (L, OFFLOAD_TEMPS, 0);
+  lua_pushvalue (L, 2);
+  lua_rawseti (L, -2, OFFLOAD_CALLABLE);
+  lua_pushvalue (L, 1);
+  lua_rawseti (L, -2, OFFLOAD_DONE);
+  offload->L = lua_newthread (L);
+  lua_rawseti (L, -2, OFFLOAD_THREAD);
+  lua_setfenv (L, -2);
+  lua_replace (L, 1);
+
+  /* Marshal arguments.  Temporaries must outlive this call, so they
+     are not allocated from the scratch arena; entering suspended
+     frame makes lgi_scratch_guard() fall back to collected guards. */
+  base = callable->has_self + callable->nargs + 3;
+  scratch = lgi_scratch_enter (L, 2, &scratch);
+  lgi_scratch_suspend (scratch, &scratch);
+  offload->ntemps = callable_call_prepare (L, 2, callable, &offload->state);
+  lgi_scratch_leave (scratch, &scratch);
+
+  /* Move caller-allocated values and temporaries into the env
+     table, they have to be kept alive until finish(). */
+  lua_getfenv (L, 1);
+  lua_insert (L, base);
+  for (i = lua_gettop (L) - base; i > 0; i--)
+    lua_rawseti (L, base, OFFLOAD_TEMPS + i - 1);
+  lua_settop (L, 1);
+
+  /* Start the call. */
+  lua_getfenv (L, 1);
+  *lgi_guard_create (L, offload_drain) = offload;
+  lua_rawseti (L, -2, OFFLOAD_DRAIN);
+  lua_pop (L, 1);
+  offload->context = g_main_context_ref_thread_default ();
+  lua_pushvalue (L, 1);
+  offload->ref = luaL_ref (L, LUA_REGISTRYINDEX);
+  offload->running = TRUE;
+  g_thread_pool_push (offload_pool, offload, NULL);
+  return 1;
+}
+
+static Offload *
+offload_get (lua_State *L, int narg)
+{
+  return luaL_checkudata (L, narg, UD_OFFLOAD);
+}
+
+/* Marshals results of completed offloaded call, returns the same
+   values as direct call of the callable would.  Lua prototype:
+   results... = offload:finish() */
+static int
+offload_finish (lua_State *L)
+{
+  Offload *offload = offload_get (L, 1);
+  int i, count;
+  if (!offload->done)
+    return luaL_error (L, "offloaded call is still running");
+  if (offload->finished)
+    return luaL_error (L, "offloaded call was already finished");
+  offload->finished = TRUE;
+
+  /* Prepare the stack in the same layout as callable_call() has after
+     the call. */
+  lua_settop (L, 1);
+  lua_getfenv (L, 1);
+  lua_rawgeti (L, 2, OFFLOAD_CALLABLE);
+  lua_insert (L, 1);
+  count = offload->state.caller_allocated + offload->ntemps;
+  luaL_checkstack (L, count, "");
+  for (i = 0; i < count; i++)
+    lua_rawgeti (L, 3, OFFLOAD_TEMPS + i);
+  return callable_call_finish (L, offload->callable, &offload->state,
+			       offload->ntemps);
+}
+
+static int
+offload_gc (lua_State *L)
+{
+  Offload *offload = offload_get (L, 1);
+  if (offload->context != NULL)
+    {
+      g_main_context_unref (offload->context);
+      offload->context = NULL;
+    }
+  return 0;
+}
+
+static int
+offload_tostring (lua_State *L)
+{
+  Offload *offload = offload_get (L, 1);
+  lua_pushfstring (L, "lgi.offload %s: %p", offload->finished ? "finished"
+		   : (offload->done ? "done" : "running"), offload);
+  return 1;
 }
 
+static const struct luaL_Reg offload_reg[] = {
+  { "__gc", offload_gc },
+  { "__tostring", offload_tostring },
+  { "finish", offload_finish },
+  { NULL, NULL }
+};
+
 /* Creates new Callable instance according to given gi.info. Lua prototype:
    callable = callable.new(callable_info[, addr]) or
    callable = callable.new(description_table[, addr]) */
@@ -1560,15 +2907,46 @@ callable_new (lua_State *L)
 				  addr);
 }
 
+/* Returns table with statistics of the closure blocks of the state. */
+static int
+callable_stats (lua_State *L)
+{
+  ClosurePool *pool = closure_pool_get (L);
+  guint pooled = 0;
+  int i;
+
+  lua_newtable (L);
+  if (pool == NULL)
+    return 1;
+
+  for (i = 0; i < CLOSURE_POOL_SLOTS; i++)
+    pooled += pool->size[i];
+  lua_pushnumber (L, pool->blocks);
+  lua_setfield (L, -2, "blocks");
+  lua_pushnumber (L, pool->outstanding);
+  lua_setfield (L, -2, "outstanding");
+  lua_pushnumber (L, pooled);
+  lua_setfield (L, -2, "pooled");
+  lua_pushnumber (L, pool->ffi_bytes);
+  lua_setfield (L, -2, "ffi_bytes");
+  return 1;
+}
+
 /* Callable module public API table. */
 static const luaL_Reg callable_api_reg[] = {
   { "new", callable_new },
+  { "async", callable_async },
+  { "offload", callable_offload },
+  { "profile", callable_profile },
+  { "stats", callable_stats },
   { NULL, NULL }
 };
 
 void
 lgi_callable_init (lua_State *L)
 {
+  AsyncQueue *queue;
+
   /* Create a thread for marshalling arguments to yielded threads, register it
    * so that it is not GC'd. */
   lua_pushlightuserdata (L, &marshalling_L_address);
@@ -1584,8 +2962,72 @@ lgi_callable_init (lua_State *L)
   /* Create cache for callables. */
   lgi_cache_create (L, &callable_cache, NULL);
 
+  /* Create pool of closure blocks. */
+  lua_pushlightuserdata (L, &closure_pool);
+  memset (lua_newuserdata (L, sizeof (ClosurePool)), 0, sizeof (ClosurePool));
+  lua_newtable (L);
+  lua_pushcfunction (L, closure_pool_gc);
+  lua_setfield (L, -2, "__gc");
+  lua_setmetatable (L, -2);
+  lua_rawset (L, LUA_REGISTRYINDEX);
+
+  /* Create weak table of profiled callables. */
+  lua_pushlightuserdata (L, &callable_profiles);
+  lua_newtable (L);
+  lua_newtable (L);
+  lua_pushstring (L, "k");
+  lua_setfield (L, -2, "__mode");
+  lua_setmetatable (L, -2);
+  lua_rawset (L, LUA_REGISTRYINDEX);
+
+  /* Create queue of async completions. */
+  lua_pushlightuserdata (L, &async_queue);
+  queue = lua_newuserdata (L, sizeof (AsyncQueue));
+  queue->L = lua_newthread (L);
+  queue->count = 0;
+  queue->dispatching = FALSE;
+  queue->depth = 0;
+  lua_createtable (L, 3, 0);
+  lua_insert (L, -2);
+  lua_rawseti (L, -2, ASYNC_QUEUE_THREAD);
+  lua_newtable (L);
+  lua_rawseti (L, -2, ASYNC_QUEUE_BATCH);
+  lua_setfenv (L, -2);
+  lua_rawset (L, LUA_REGISTRYINDEX);
+
+  /* Register metatable of offloaded calls and create the shared
+     worker thread pool. */
+  luaL_newmetatable (L, UD_OFFLOAD);
+  luaL_register (L, NULL, offload_reg);
+  lua_pushvalue (L, -1);
+  lua_setfield (L, -2, "__index");
+  lua_pop (L, 1);
+  if (g_once_init_enter (&offload_pool))
+    {
+#if GLIB_CHECK_VERSION(2, 32, 0)
+      offload_mutex = g_new (GMutex, 1);
+      g_mutex_init (offload_mutex);
+      offload_cond = g_new (GCond, 1);
+      g_cond_init (offload_cond);
+#else
+      offload_mutex = g_mutex_new ();
+      offload_cond = g_cond_new ();
+#endif
+      g_once_init_leave (&offload_pool,
+		       g_thread_pool_new (offload_run, NULL,
+					  OFFLOAD_MAX_THREADS, FALSE, NULL));
+    }
+
   /* Create public api for callable module. */
   lua_newtable (L);
   luaL_register (L, NULL, callable_api_reg);
+
+  /* Create table of functions keeping the lock, exported also as
+     callable.keep_lock. */
+  lua_pushlightuserdata (L, &callable_keep_lock);
+  lua_newtable (L);
+  lua_pushvalue (L, -1);
+  lua_setfield (L, -4, "keep_lock");
+  lua_rawset (L, LUA_REGISTRYINDEX);
   lua_setfield (L, -2, "callable");
 }
@@ -90,7 +90,8 @@ local function load_properties(info)
    return component.get_category(
       info.properties, nil,
       function(name) return string.gsub(name, '_', '-') end,
-      function(name) return string.gsub(name, '%-', '_') end)
+      function(name) return string.gsub(name, '%-', '_') end,
+      info.fullname .. ':properties')
 end
 
 local function find_constructor(info)
@@ -221,9 +222,11 @@ function class.load_interface(namespace, info)
    -- Load all components of the interface.
    local interface = component.create(info, class.interface_mt)
    interface._property = load_properties(info)
-   interface._method = component.get_category(info.methods, load_method)
+   interface._method = component.get_category(
+      info.methods, load_method, nil, nil, info.fullname .. ':methods')
    interface._signal = component.get_category(
-      info.signals, nil, load_signal_name, load_signal_name_reverse)
+      info.signals, nil, load_signal_name, load_signal_name_reverse,
+      info.fullname .. ':signals')
    interface._constant = component.get_category(info.constants, core.constant)
    local type_struct = info.type_struct
    if type_struct then
@@ -254,11 +257,14 @@ function class.load_class(namespace, info)
       info, parent and getmetatable(parent) or class.class_mt)
    class._parent = parent
    class._property = load_properties(info)
-   class._method = component.get_category(info.methods, load_method)
+   class._method = component.get_category(
+      info.methods, load_method, nil, nil, info.fullname .. ':methods')
    class._signal = component.get_category(
-      info.signals, nil, load_signal_name, load_signal_name_reverse)
+      info.signals, nil, load_signal_name, load_signal_name_reverse,
+      info.fullname .. ':signals')
    class._constant = component.get_category(info.constants, core.constant)
-   class._field = component.get_category(info.fields)
+   class._field = component.get_category(
+      info.fields, core.marshal.field, nil, nil, info.fullname .. ':fields')
    local type_struct = info.type_struct
    if type_struct then
       class._virtual = component.get_category(
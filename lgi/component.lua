@@ -16,6 +16,7 @@ type, select, error
 local table = require 'table'
 local string = require 'string'
 local core = require 'lgi.core'
+local namecache = require 'lgi.namecache'
 
 -- Generic component metatable.  Component is any entity in the repo,
 -- e.g. record, object, enum, etc.
@@ -24,9 +25,10 @@ local component = { mt = {} }
 -- Creates new component table by cloning all contents and setting
 -- Gets table for category of compound (i.e. _field of struct or _property
 -- for class etc).  Installs metatable which performs on-demand lookup of
--- symbols.
+-- symbols.  Optional cache_key ('Namespace.Type:category') allows
+-- taking name->index mapping from persistent namecache.
 function component.get_category(children, xform_value,
-				xform_name, xform_name_reverse)
+				xform_name, xform_name_reverse, cache_key)
    -- Either none or both transform methods must be provided.
    assert(not xform_name or xform_name_reverse)
 
@@ -37,7 +39,12 @@ function component.get_category(children, xform_value,
    -- from 'children' table, and table part contains name->index
    -- mapping.
    local index, mt = {}, {}
-   for i = 1, #children do index[i] = i end
+   local names = cache_key and namecache.names(cache_key, children)
+   if names then
+      for i = 1, #names do index[names[i]] = i end
+   else
+      for i = 1, #children do index[i] = i end
+   end
 
    -- Fully resolves the category (i.e. loads everything remaining to
    -- be loaded in given category) and disconnects on-demand loading
@@ -62,9 +69,12 @@ function component.get_category(children, xform_value,
 	 end
       end
 
-      -- Load all known indices.
-      for en, idx in pairs(index) do
-	 val = xvalue(children[idx])
+      -- Load all known indices.  Names are taken from the infos, in
+      -- case that the index came from stale namecache.
+      for _, idx in pairs(index) do
+	 ei = children[idx]
+	 val = xvalue(ei)
+	 en = ei.name
 	 en = not xform_name_reverse and en or xform_name_reverse(en)
 	 if en then category[en] = val end
       end
@@ -87,8 +97,24 @@ function component.get_category(children, xform_value,
       if idx then
 	 -- We know at least the index, so get info directly.
 	 val = children[idx]
-	 index[name] = nil
-      else
+	 if val.name == name then
+	    index[name] = nil
+	 else
+	    -- Stale namecache entry; forget all cached names and
+	    -- fall back to scanning.
+	    local known = {}
+	    for en, i in pairs(index) do
+	       if type(en) == 'string' then known[en] = i end
+	    end
+	    for en, i in pairs(known) do
+	       index[en] = nil
+	       index[#index + 1] = i
+	    end
+	    namecache.invalidate(cache_key)
+	    idx, val = nil, nil
+	 end
+      end
+      if not idx then
 	 -- Not yet, go through unknown indices and try to find the
 	 -- name.
 	 while #index > 0 do
@@ -119,6 +119,37 @@ lgi_cache_create (lua_State *L, gpointer key, const char *mode)
   lua_rawset (L, LUA_REGISTRYINDEX);
 }
 
+/* Adds given amount to the numeric field of the table on the top of
+   the stack. */
+static void
+stats_inc (lua_State *L, const char *field, size_t amount)
+{
+  lua_getfield (L, -1, field);
+  lua_pushnumber (L, lua_tonumber (L, -1) + amount);
+  lua_setfield (L, -3, field);
+  lua_pop (L, 1);
+}
+
+void
+lgi_stats_add (lua_State *L, int narg, const char *kind, size_t bytes)
+{
+  lua_pushvalue (L, -1);
+  lua_rawget (L, narg);
+  if (lua_isnil (L, -1))
+    {
+      lua_pop (L, 1);
+      lua_newtable (L);
+      lua_pushvalue (L, -2);
+      lua_pushvalue (L, -2);
+      lua_rawset (L, narg);
+    }
+  stats_inc (L, "count", 1);
+  stats_inc (L, "bytes", bytes);
+  if (kind != NULL)
+    stats_inc (L, kind, 1);
+  lua_pop (L, 2);
+}
+
 int
 lgi_type_get_name (lua_State *L, GIBaseInfo *info)
 {
@@ -269,6 +300,228 @@ lgi_guard_create (lua_State *L, GDestroyNotify destroy)
   return &guard->data;
 }
 
+/* Scratch arena of call-scoped temporaries.  Each OS thread has its
+   own arena, a stack of chunks of guards which are never moved, so
+   that the pointers returned by lgi_scratch_guard() stay valid.  The
+   arena is divided into frames, one for each running callable_call().
+   Temporaries are allocated in the arena only while the topmost frame
+   is active, i.e. while the call is marshalling its arguments or
+   return values, and only by the C function which owns the frame;
+   otherwise (e.g. in callbacks invoked during the C call or in nested
+   Lua marshallers) lgi_scratch_guard() falls back to GC-collected
+   guard.
+
+   Frames are identified by address of variable on the C stack of the
+   owning call.  When Lua error unwinds the call, its frame is left in
+   the arena; it is unwound by the enclosing call or, when there is
+   none, by the next call entering the arena at the same or shallower
+   C stack depth (C stack is assumed to grow downwards).  Until then,
+   the owner check makes sure that no temporaries are allocated into
+   such aborted frame: the frame remembers the Lua state and the value
+   at given stack index of the owning C function, which cannot be seen
+   at the same index by any other function. */
+#define SCRATCH_CHUNK_SIZE 64
+
+typedef struct _ScratchChunk ScratchChunk;
+struct _ScratchChunk
+{
+  ScratchChunk *prev, *next;
+  Guard guards[SCRATCH_CHUNK_SIZE];
+};
+
+typedef struct _ScratchFrame
+{
+  gsize marker;
+  ScratchChunk *chunk;
+  guint used;
+  gboolean active;
+
+  /* Owner of the frame, value at stack index 'narg' of the owning C
+     function running in Lua state L. */
+  lua_State *L;
+  int narg;
+  gconstpointer owner;
+} ScratchFrame;
+
+struct _LgiScratch
+{
+  /* Current chunk and number of used guards in it. */
+  ScratchChunk *chunk;
+  guint used;
+
+  /* Stack of frames. */
+  ScratchFrame *frames;
+  guint n_frames, n_allocated;
+
+  ScratchChunk first;
+};
+
+#if GLIB_CHECK_VERSION(2, 32, 0)
+static void
+scratch_free (gpointer data)
+{
+  LgiScratch *scratch = data;
+  ScratchChunk *chunk, *next;
+  for (chunk = scratch->first.next; chunk != NULL; chunk = next)
+    {
+      next = chunk->next;
+      g_free (chunk);
+    }
+  g_free (scratch->frames);
+  g_free (scratch);
+}
+
+static GPrivate scratch_key = G_PRIVATE_INIT (scratch_free);
+#endif
+
+/* Runs destructors of all guards allocated after the top frame was
+   entered and removes the frame. */
+static void
+scratch_pop_frame (LgiScratch *scratch)
+{
+  ScratchFrame *frame = &scratch->frames[--scratch->n_frames];
+  while (scratch->chunk != frame->chunk || scratch->used > frame->used)
+    {
+      Guard *guard;
+      if (scratch->used == 0)
+	{
+	  scratch->chunk = scratch->chunk->prev;
+	  scratch->used = SCRATCH_CHUNK_SIZE;
+	  continue;
+	}
+
+      guard = &scratch->chunk->guards[--scratch->used];
+      if (guard->data != NULL)
+	{
+	  gpointer data = guard->data;
+	  guard->data = NULL;
+	  guard->destroy (data);
+	}
+    }
+}
+
+/* Removes frames left above the frame with given marker by calls
+   aborted by an error. */
+static void
+scratch_restore (LgiScratch *scratch, gsize marker)
+{
+  while (scratch->n_frames > 0
+	 && scratch->frames[scratch->n_frames - 1].marker != marker)
+    scratch_pop_frame (scratch);
+}
+
+/* Returns top frame of the arena if it belongs to the call identified
+   by given marker, otherwise NULL. */
+static ScratchFrame *
+scratch_top (LgiScratch *scratch, gsize marker)
+{
+  scratch_restore (scratch, marker);
+  return scratch->n_frames > 0 ? &scratch->frames[scratch->n_frames - 1]
+    : NULL;
+}
+
+LgiScratch *
+lgi_scratch_enter (lua_State *L, int narg, gconstpointer marker)
+{
+#if GLIB_CHECK_VERSION(2, 32, 0)
+  LgiScratch *scratch = g_private_get (&scratch_key);
+  ScratchFrame *frame;
+  if (G_UNLIKELY (scratch == NULL))
+    {
+      scratch = g_new0 (LgiScratch, 1);
+      scratch->chunk = &scratch->first;
+      g_private_set (&scratch_key, scratch);
+    }
+
+  /* Frames not deeper on the C stack than ours cannot enclose us, so
+     they were aborted by an error. */
+  while (scratch->n_frames > 0
+	 && scratch->frames[scratch->n_frames - 1].marker <= (gsize) marker)
+    scratch_pop_frame (scratch);
+
+  if (G_UNLIKELY (scratch->n_frames == scratch->n_allocated))
+    {
+      scratch->n_allocated = scratch->n_allocated * 2 + 8;
+      scratch->frames = g_renew (ScratchFrame, scratch->frames,
+				 scratch->n_allocated);
+    }
+  frame = &scratch->frames[scratch->n_frames++];
+  frame->marker = (gsize) marker;
+  frame->chunk = scratch->chunk;
+  frame->used = scratch->used;
+  frame->active = TRUE;
+  frame->L = L;
+  frame->narg = narg;
+  frame->owner = lua_topointer (L, narg);
+  return scratch;
+#else
+  (void) L;
+  (void) narg;
+  (void) marker;
+  return NULL;
+#endif
+}
+
+void
+lgi_scratch_suspend (LgiScratch *scratch, gconstpointer marker)
+{
+  ScratchFrame *frame;
+  if (scratch != NULL && (frame = scratch_top (scratch, (gsize) marker)))
+    frame->active = FALSE;
+}
+
+void
+lgi_scratch_resume (LgiScratch *scratch, gconstpointer marker)
+{
+  ScratchFrame *frame;
+  if (scratch != NULL && (frame = scratch_top (scratch, (gsize) marker)))
+    frame->active = TRUE;
+}
+
+void
+lgi_scratch_leave (LgiScratch *scratch, gconstpointer marker)
+{
+  if (scratch != NULL && scratch_top (scratch, (gsize) marker))
+    scratch_pop_frame (scratch);
+}
+
+gpointer *
+lgi_scratch_guard (lua_State *L, GDestroyNotify destroy)
+{
+#if GLIB_CHECK_VERSION(2, 32, 0)
+  LgiScratch *scratch = g_private_get (&scratch_key);
+  ScratchFrame *frame = (scratch != NULL && scratch->n_frames > 0)
+    ? &scratch->frames[scratch->n_frames - 1] : NULL;
+  if (frame != NULL && frame->active && frame->L == L
+      && frame->narg <= lua_gettop (L)
+      && lua_topointer (L, frame->narg) == frame->owner
+      && (gsize) &frame < frame->marker)
+    {
+      Guard *guard;
+      if (G_UNLIKELY (scratch->used == SCRATCH_CHUNK_SIZE))
+	{
+	  if (scratch->chunk->next == NULL)
+	    {
+	      scratch->chunk->next = g_new (ScratchChunk, 1);
+	      scratch->chunk->next->prev = scratch->chunk;
+	      scratch->chunk->next->next = NULL;
+	    }
+	  scratch->chunk = scratch->chunk->next;
+	  scratch->used = 0;
+	}
+
+      /* Push placeholder, so that the stack layout is the same as
+	 with the collected guard. */
+      guard = &scratch->chunk->guards[scratch->used++];
+      guard->data = NULL;
+      guard->destroy = destroy;
+      lua_pushlightuserdata (L, &guard->data);
+      return &guard->data;
+    }
+#endif
+  return lgi_guard_create (L, destroy);
+}
+
 /* Converts any allowed GType kind to lightuserdata form. */
 static int
 core_gtype (lua_State *L)
@@ -304,12 +557,34 @@ core_constant (lua_State *L)
   return 1;
 }
 
+/* Number of buckets in the histogram of lock wait times.  N-th
+   bucket counts waits shorter than 10^N microseconds, the last one
+   counts all longer waits. */
+#define LOCK_STATS_BUCKETS 8
+
+/* Lock contention statistics, gathered only when enabled. */
+typedef struct _LgiLockStats
+{
+  /* Nonzero when statistics are gathered, accessed atomically. */
+  gint enabled;
+
+  /* Following fields are updated only while holding the lock. */
+  guint64 acquisitions;
+  guint64 contended;
+  gint64 wait_total;
+  gint64 wait_max;
+  guint64 histogram[LOCK_STATS_BUCKETS];
+} LgiLockStats;
+
 typedef struct _LgiStateMutex
 {
   /* Pointer to either local state lock (next member of this
      structure) or to global package lock. */
   GRecMutex *mutex;
   GRecMutex state_mutex;
+
+  /* Contention statistics of this state lock. */
+  LgiLockStats stats;
 } LgiStateMutex;
 
 /* Global package lock (the one used for
@@ -344,11 +619,37 @@ lgi_state_get_lock (lua_State *L)
   return state_lock;
 }
 
+/* Records lock acquisition into the statistics, start is the time
+   when the waiting for the contended lock started, 0 if the lock was
+   not contended.  Must be called with the lock held. */
+static void
+lock_stats_record (LgiLockStats *stats, gint64 start)
+{
+  gint64 wait, limit;
+  int bucket;
+
+  stats->acquisitions++;
+  if (start == 0)
+    return;
+
+  wait = g_get_monotonic_time () - start;
+  stats->contended++;
+  stats->wait_total += wait;
+  if (wait > stats->wait_max)
+    stats->wait_max = wait;
+  for (bucket = 0, limit = 1;
+       bucket < LOCK_STATS_BUCKETS - 1 && wait >= limit; bucket++)
+    limit *= 10;
+  stats->histogram[bucket]++;
+}
+
 void
 lgi_state_enter (gpointer state_lock)
 {
   LgiStateMutex *mutex = state_lock;
   GRecMutex *wait_on;
+  gboolean stats = g_atomic_int_get (&mutex->stats.enabled);
+  gint64 start = 0;
 
   /* There is a complication with lock switching.  During the wait for
      the lock, someone could call core.registerlock() and thus change
@@ -356,13 +657,24 @@ lgi_state_enter (gpointer state_lock)
   for (;;)
     {
       wait_on = g_atomic_pointer_get (&mutex->mutex);
-      g_rec_mutex_lock (wait_on);
+      if (!stats)
+	g_rec_mutex_lock (wait_on);
+      else if (!g_rec_mutex_trylock (wait_on))
+	{
+	  /* The lock is contended, measure the time of waiting. */
+	  if (start == 0)
+	    start = g_get_monotonic_time ();
+	  g_rec_mutex_lock (wait_on);
+	}
       if (wait_on == mutex->mutex)
 	break;
 
       /* The lock is changed, unlock this one and wait again. */
       g_rec_mutex_unlock (wait_on);
     }
+
+  if (stats)
+    lock_stats_record (&mutex->stats, start);
 }
 
 void
@@ -373,6 +685,44 @@ lgi_state_leave (gpointer state_lock)
   g_rec_mutex_unlock (mutex->mutex);
 }
 
+/* Returns table with lock statistics of the state.  If enable
+   argument is given, statistics are reset and their gathering is
+   enabled or disabled.  Lua prototype:
+   stats = core.lockstats([enable]) */
+static int
+core_lockstats (lua_State *L)
+{
+  LgiStateMutex *mutex = lgi_state_get_lock (L);
+  LgiLockStats *stats = &mutex->stats;
+  int i;
+
+  if (!lua_isnone (L, 1))
+    {
+      memset (stats, 0, sizeof (*stats));
+      g_atomic_int_set (&stats->enabled, lua_toboolean (L, 1));
+    }
+
+  lua_newtable (L);
+  lua_pushboolean (L, g_atomic_int_get (&stats->enabled));
+  lua_setfield (L, -2, "enabled");
+  lua_pushnumber (L, (lua_Number) stats->acquisitions);
+  lua_setfield (L, -2, "acquisitions");
+  lua_pushnumber (L, (lua_Number) stats->contended);
+  lua_setfield (L, -2, "contended");
+  lua_pushnumber (L, stats->wait_total / (lua_Number) G_USEC_PER_SEC);
+  lua_setfield (L, -2, "wait_total");
+  lua_pushnumber (L, stats->wait_max / (lua_Number) G_USEC_PER_SEC);
+  lua_setfield (L, -2, "wait_max");
+  lua_createtable (L, LOCK_STATS_BUCKETS, 0);
+  for (i = 0; i < LOCK_STATS_BUCKETS; i++)
+    {
+      lua_pushnumber (L, (lua_Number) stats->histogram[i]);
+      lua_rawseti (L, -2, i + 1);
+    }
+  lua_setfield (L, -2, "histogram");
+  return 1;
+}
+
 static const char* log_levels[] = {
   "ERROR", "CRITICAL", "WARNING", "MESSAGE", "INFO", "DEBUG", "???", NULL
 };
@@ -604,6 +954,7 @@ static const struct luaL_Reg lgi_reg[] = {
   { "constant", core_constant },
   { "yield", core_yield },
   { "registerlock", core_registerlock },
+  { "lockstats", core_lockstats },
   { "band", core_band },
   { "bor", core_bor },
   { "module", core_module },
@@ -743,6 +1094,7 @@ luaopen_lgi_corelgilua51 (lua_State* L)
      the registry. */
   lua_pushlightuserdata (L, &call_mutex);
   mutex = lua_newuserdata (L, sizeof (*mutex));
+  memset (&mutex->stats, 0, sizeof (mutex->stats));
   mutex->mutex = &mutex->state_mutex;
   g_rec_mutex_init (&mutex->state_mutex);
   g_rec_mutex_lock (&mutex->state_mutex);
@@ -782,6 +1134,7 @@ luaopen_lgi_corelgilua51 (lua_State* L)
   lgi_record_init (L);
   lgi_object_init (L);
   lgi_callable_init (L);
+  lgi_variant_init (L);
 
   /* Return registration table. */
   return 1;
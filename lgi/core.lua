@@ -9,9 +9,19 @@
 ------------------------------------------------------------------------------
 
 -- This module decides what kind of core routines should be loaded.
--- Currently only one implementation exists, standard-Lua C-side
--- implementation, LuaJIT-FFI-based one is planned.
+-- Standard-Lua C-side implementation is always used; under LuaJIT,
+-- simple calls can be additionally routed through FFI fast path when
+-- LGI_FASTCALL environment variable is set.
 local core = require 'lgi.corelgilua51'
+local os = require 'os'
+
+local fastcall = require 'lgi.fastcall'
+if fastcall.available and os.getenv('LGI_FASTCALL') then
+   local new = core.callable.new
+   function core.callable.new(...)
+      return fastcall.wrap(core, new(...))
+   end
+end
 
 -- Helper methods for converting between CamelCase and uscore_delim
 -- names.
@@ -0,0 +1,67 @@
+------------------------------------------------------------------------------
+--
+--  lgi LuaJIT FFI fast path of simple calls
+--
+--  Copyright (c) 2026 lgi contributors
+--  Licensed under the MIT license:
+--  http://www.opensource.org/licenses/mit-license.php
+--
+------------------------------------------------------------------------------
+
+-- Callables which keep the state lock and have only simple arguments
+-- and return values (numbers, booleans, strings and instances) can be
+-- called directly through LuaJIT FFI instead of libffi, so that JIT
+-- compiler can compile the calls.  Other callables are left intact.
+
+local ipairs, pcall, require, tostring, tonumber, rawget
+   = ipairs, pcall, require, tostring, tonumber, rawget
+local table = require 'table'
+local load = rawget(_G, 'loadstring') or load
+
+local ffi_ok, ffi = pcall(require, 'ffi')
+local fastcall = { available = ffi_ok and rawget(_G, 'jit') ~= nil }
+
+-- Conversions of the arguments, according to their kinds.
+local arg_conv = {
+   boolean = '%s and 1 or 0',
+   object = 'object_query(%s, "addr", gtypes[%d], %s)',
+   record = 'record_query(%s, "addr", repos[%d], %s)',
+}
+
+-- Conversions of the call result, according to the kind of return
+-- value.
+local ret_conv = {
+   void = '%s',
+   number = 'return %s',
+   int64 = 'return tonumber(%s)',
+   boolean = 'return %s ~= 0',
+   string = 'local res = %s\n   if res ~= nil then return ffi_string(res) end',
+}
+
+-- Returns function calling given callable through FFI, or the callable
+-- itself when it cannot be called this way.
+function fastcall.wrap(core, callable)
+   local desc = fastcall.available and callable.fastpath
+   if not desc then return callable end
+
+   -- Generate source of the wrapper.
+   local params, args = {}, {}
+   for i, kind in ipairs(desc) do
+      params[i] = 'a' .. i
+      args[i] = (arg_conv[kind] or '%s'):format(
+	 params[i], i, tostring(desc.optional[i] or false))
+   end
+   local source = table.concat {
+      'local func, object_query, record_query, gtypes, repos, tonumber, ',
+      'ffi_string = ...\n',
+      'return function(', table.concat(params, ', '), ')\n   ',
+      ret_conv[desc.ret]:format(
+	 'func(' .. table.concat(args, ', ') .. ')'), '\nend\n',
+   }
+   local chunk = load(source, '=' .. tostring(callable))
+   return chunk(ffi.cast(desc.ctype, desc.addr), core.object.query,
+		core.record.query, desc.gtypes, desc.repos, tonumber,
+		ffi.string)
+end
+
+return fastcall
@@ -10,16 +10,69 @@
 
 #include <string.h>
 #include "lgi.h"
+#include <glib/gstdio.h>
 
 typedef GIBaseInfo *(* InfosItemGet)(GIBaseInfo* info, gint item);
 
+/* Userdata of LGI_GI_INFO.  The info pointer has to stay the first
+   member, the rest of the code accesses the userdata simply as
+   GIBaseInfo **.  Attributes which are expensive to query are
+   memoized here. */
+typedef struct _Info
+{
+  GIBaseInfo *info;
+  GType gtype;
+  guint has_gtype : 1;
+} Info;
+
+/* Names of all attributes recognized by info_index.  They are
+   interned into the table stored as upvalue of info_index, which maps
+   them to InfoKey values, so that the dispatch does not have to
+   compare strings. */
+#define INFO_KEYS \
+  INFO_KEY (type) INFO_KEY (name) INFO_KEY (namespace) INFO_KEY (fullname) \
+  INFO_KEY (deprecated) INFO_KEY (container) INFO_KEY (typeinfo) \
+  INFO_KEY (gtype) INFO_KEY (is_gtype_struct) INFO_KEY (size) \
+  INFO_KEY (fields) INFO_KEY (methods) INFO_KEY (type_struct) \
+  INFO_KEY (prerequisites) INFO_KEY (vfuncs) INFO_KEY (constants) \
+  INFO_KEY (properties) INFO_KEY (signals) INFO_KEY (parent) \
+  INFO_KEY (interfaces) INFO_KEY (return_type) INFO_KEY (return_transfer) \
+  INFO_KEY (args) INFO_KEY (flags) INFO_KEY (storage) INFO_KEY (values) \
+  INFO_KEY (error_domain) INFO_KEY (value) INFO_KEY (direction) \
+  INFO_KEY (transfer) INFO_KEY (optional) INFO_KEY (offset) INFO_KEY (tag) \
+  INFO_KEY (is_basic) INFO_KEY (params) INFO_KEY (interface) \
+  INFO_KEY (array_type) INFO_KEY (is_zero_terminated) \
+  INFO_KEY (array_length) INFO_KEY (fixed_size) INFO_KEY (is_pointer) \
+  INFO_KEY (is_arg) INFO_KEY (is_callable) INFO_KEY (is_function) \
+  INFO_KEY (is_signal) INFO_KEY (is_vfunc) INFO_KEY (is_constant) \
+  INFO_KEY (is_field) INFO_KEY (is_property) INFO_KEY (is_registered_type) \
+  INFO_KEY (is_enum) INFO_KEY (is_interface) INFO_KEY (is_object) \
+  INFO_KEY (is_struct) INFO_KEY (is_union) INFO_KEY (is_type) \
+  INFO_KEY (is_value)
+
+typedef enum _InfoKey
+{
+  INFO_KEY_UNKNOWN = 0,
+#define INFO_KEY(name) INFO_KEY_ ## name,
+  INFO_KEYS
+#undef INFO_KEY
+  INFO_KEY_LAST
+} InfoKey;
+
+static const char *const info_key_names[] = {
+  NULL,
+#define INFO_KEY(name) #name,
+  INFO_KEYS
+#undef INFO_KEY
+};
+
 /* Creates new instance of info from given GIBaseInfo pointer. */
 int
 lgi_gi_info_new (lua_State *L, GIBaseInfo *info)
 {
   if (info)
     {
-      GIBaseInfo **ud_info;
+      Info *ud_info;
 
       if (g_base_info_get_type (info) == GI_INFO_TYPE_INVALID)
 	{
@@ -28,8 +81,9 @@ lgi_gi_info_new (lua_State *L, GIBaseInfo *info)
 	}
       else
 	{
-	  ud_info = lua_newuserdata (L, sizeof (info));
-	  *ud_info = info;
+	  ud_info = lua_newuserdata (L, sizeof (Info));
+	  ud_info->info = info;
+	  ud_info->has_gtype = 0;
 	  luaL_getmetatable (L, LGI_GI_INFO);
 	  lua_setmetatable (L, -2);
 	}
@@ -156,22 +210,35 @@ info_push_transfer (lua_State *L, GITransfer transfer)
 static int
 info_index (lua_State *L)
 {
-  GIBaseInfo **info = luaL_checkudata (L, 1, LGI_GI_INFO);
-  const gchar *prop = luaL_checkstring (L, 2);
+  Info *ud = luaL_checkudata (L, 1, LGI_GI_INFO);
+  GIBaseInfo **info = &ud->info;
+  InfoKey key;
+
+  /* Translate the key using interned keys table. */
+  luaL_checkstring (L, 2);
+  lua_pushvalue (L, 2);
+  lua_rawget (L, lua_upvalueindex (1));
+  key = lua_tointeger (L, -1);
+  lua_pop (L, 1);
+  if (key == INFO_KEY_UNKNOWN)
+    {
+      lua_pushnil (L);
+      return 1;
+    }
 
 #define INFOS(n1, n2)							\
-  else if (strcmp (prop, #n2 "s") == 0)					\
+  else if (key == INFO_KEY_ ## n2 ## s)					\
     return infos_new (L, *info,						\
 		      g_ ## n1 ## _info_get_n_ ## n2 ## s (*info),	\
 		      g_ ## n1 ## _info_get_ ## n2);
 
 #define INFOS2(n1, n2, n3)					\
-  else if (strcmp (prop, #n3) == 0)				\
+  else if (key == INFO_KEY_ ## n3)				\
     return infos_new (L, *info,					\
 		      g_ ## n1 ## _info_get_n_ ## n3 (*info),	\
 		      g_ ## n1 ## _info_get_ ## n2);
 
-  if (strcmp (prop, "type") == 0)
+  if (key == INFO_KEY_type)
     {
       switch (g_base_info_get_type (*info))
 	{
@@ -205,7 +272,7 @@ info_index (lua_State *L)
     }
 
 #define H(n1, n2)						\
-  if (strcmp (prop, "is_" #n2) == 0)				\
+  if (key == INFO_KEY_is_ ## n2)				\
     {								\
       lua_pushboolean (L, GI_IS_ ## n1 ## _INFO (*info));	\
       return 1;							\
@@ -230,37 +297,37 @@ info_index (lua_State *L)
 
   if  (!GI_IS_TYPE_INFO (*info))
     {
-      if (strcmp (prop, "name") == 0)
+      if (key == INFO_KEY_name)
 	{
 	  lua_pushstring (L, g_base_info_get_name (*info));
 	  return 1;
 	}
-      else if (strcmp (prop, "namespace") == 0)
+      else if (key == INFO_KEY_namespace)
 	{
 	  lua_pushstring (L, g_base_info_get_namespace (*info));
 	  return 1;
 	}
     }
 
-  if (strcmp (prop, "fullname") == 0)
+  if (key == INFO_KEY_fullname)
     {
       lua_concat (L, lgi_type_get_name (L, *info));
       return 1;
     }
 
-  if (strcmp (prop, "deprecated") == 0)
+  if (key == INFO_KEY_deprecated)
     {
       lua_pushboolean (L, g_base_info_is_deprecated (*info));
       return 1;
     }
-  else if (strcmp (prop, "container") == 0)
+  else if (key == INFO_KEY_container)
     {
       GIBaseInfo *container = g_base_info_get_container (*info);
       if (container)
 	g_base_info_ref (container);
       return lgi_gi_info_new (L, container);
     }
-  else if (strcmp (prop, "typeinfo") == 0)
+  else if (key == INFO_KEY_typeinfo)
     {
       GITypeInfo *ti = NULL;
       if (GI_IS_ARG_INFO (*info))
@@ -278,23 +345,27 @@ info_index (lua_State *L)
 
   if (GI_IS_REGISTERED_TYPE_INFO (*info))
     {
-      if (strcmp (prop, "gtype") == 0)
+      if (key == INFO_KEY_gtype)
 	{
-	  GType gtype = g_registered_type_info_get_g_type (*info);
-	  if (gtype != G_TYPE_NONE)
-	    lua_pushlightuserdata (L, (void *) gtype);
+	  if (!ud->has_gtype)
+	    {
+	      ud->gtype = g_registered_type_info_get_g_type (*info);
+	      ud->has_gtype = 1;
+	    }
+	  if (ud->gtype != G_TYPE_NONE)
+	    lua_pushlightuserdata (L, (void *) ud->gtype);
 	  else
 	    lua_pushnil (L);
 	  return 1;
 	}
       else if (GI_IS_STRUCT_INFO (*info))
 	{
-	  if (strcmp (prop, "is_gtype_struct") == 0)
+	  if (key == INFO_KEY_is_gtype_struct)
 	    {
 	      lua_pushboolean (L, g_struct_info_is_gtype_struct (*info));
 	      return 1;
 	    }
-	  else if (strcmp (prop, "size") == 0)
+	  else if (key == INFO_KEY_size)
 	    {
 	      lua_pushinteger (L, g_struct_info_get_size (*info));
 	      return 1;
@@ -304,7 +375,7 @@ info_index (lua_State *L)
 	}
       else if (GI_IS_UNION_INFO (*info))
 	{
-	  if (strcmp (prop, "size") == 0)
+	  if (key == INFO_KEY_size)
 	    {
 	      lua_pushinteger (L, g_struct_info_get_size (*info));
 	      return 1;
@@ -314,7 +385,7 @@ info_index (lua_State *L)
 	}
       else if (GI_IS_INTERFACE_INFO (*info))
 	{
-	  if (strcmp (prop, "type_struct") == 0)
+	  if (key == INFO_KEY_type_struct)
 	    return
 	      lgi_gi_info_new (L, g_interface_info_get_iface_struct (*info));
 	  INFOS (interface, prerequisite)
@@ -326,9 +397,9 @@ info_index (lua_State *L)
 	}
       else if (GI_IS_OBJECT_INFO (*info))
 	{
-	  if (strcmp (prop, "parent") == 0)
+	  if (key == INFO_KEY_parent)
 	    return lgi_gi_info_new (L, g_object_info_get_parent (*info));
-	  else if (strcmp (prop, "type_struct") == 0)
+	  else if (key == INFO_KEY_type_struct)
 	    return lgi_gi_info_new (L, g_object_info_get_class_struct (*info));
 	  INFOS (object, interface)
 	    INFOS (object, field)
@@ -342,15 +413,15 @@ info_index (lua_State *L)
 
   if (GI_IS_CALLABLE_INFO (*info))
     {
-      if (strcmp (prop, "return_type") == 0)
+      if (key == INFO_KEY_return_type)
 	return lgi_gi_info_new (L, g_callable_info_get_return_type (*info));
-      else if (strcmp (prop, "return_transfer") == 0)
+      else if (key == INFO_KEY_return_transfer)
 	return info_push_transfer (L, g_callable_info_get_caller_owns (*info));
       INFOS (callable, arg);
 
       if (GI_IS_SIGNAL_INFO (*info))
 	{
-	  if (strcmp (prop, "flags") == 0)
+	  if (key == INFO_KEY_flags)
 	    {
 	      GSignalFlags flags = g_signal_info_get_flags (*info);
 	      lua_newtable (L);
@@ -374,7 +445,7 @@ info_index (lua_State *L)
 
       if (GI_IS_FUNCTION_INFO (*info))
 	{
-	  if (strcmp (prop, "flags") == 0)
+	  if (key == INFO_KEY_flags)
 	    {
 	      GIFunctionInfoFlags flags = g_function_info_get_flags (*info);
 	      lua_newtable (L);
@@ -399,7 +470,7 @@ info_index (lua_State *L)
 
   if (GI_IS_ENUM_INFO (*info))
     {
-      if (strcmp (prop, "storage") == 0)
+      if (key == INFO_KEY_storage)
 	{
 	  GITypeTag tag = g_enum_info_get_storage_type (*info);
 	  lua_pushstring (L, g_type_tag_to_string (tag));
@@ -409,7 +480,7 @@ info_index (lua_State *L)
       INFOS (enum, method)
 #endif
 	INFOS (enum, value)
-      else if (strcmp (prop, "error_domain") == 0)
+      else if (key == INFO_KEY_error_domain)
 	{
 	  const gchar *domain = g_enum_info_get_error_domain (*info);
 	  if (domain != NULL)
@@ -423,7 +494,7 @@ info_index (lua_State *L)
 
   if (GI_IS_VALUE_INFO (*info))
     {
-      if (strcmp (prop, "value") == 0)
+      if (key == INFO_KEY_value)
 	{
 	  lua_pushinteger (L, g_value_info_get_value (*info));
 	  return 1;
@@ -432,7 +503,7 @@ info_index (lua_State *L)
 
   if (GI_IS_ARG_INFO (*info))
     {
-      if (strcmp (prop, "direction") == 0)
+      if (key == INFO_KEY_direction)
 	{
 	  GIDirection dir = g_arg_info_get_direction (*info);
 	  if (dir == GI_DIRECTION_OUT)
@@ -442,10 +513,10 @@ info_index (lua_State *L)
 	    lua_pushstring (L, dir == GI_DIRECTION_IN ? "in" : "inout");
 	  return 1;
 	}
-      if (strcmp (prop, "transfer") == 0)
+      if (key == INFO_KEY_transfer)
 	return info_push_transfer (L,
 				   g_arg_info_get_ownership_transfer (*info));
-      if (strcmp (prop, "optional") == 0)
+      if (key == INFO_KEY_optional)
 	{
 	  lua_pushboolean (L, g_arg_info_is_optional (*info)
 			   || g_arg_info_may_be_null (*info));
@@ -455,12 +526,12 @@ info_index (lua_State *L)
 
   if (GI_IS_PROPERTY_INFO (*info))
     {
-      if (strcmp (prop, "flags") == 0)
+      if (key == INFO_KEY_flags)
 	{
 	  lua_pushinteger (L, g_property_info_get_flags (*info));
 	  return 1;
 	}
-      else if (strcmp (prop, "transfer") == 0)
+      else if (key == INFO_KEY_transfer)
 	return
 	  info_push_transfer (L,
 			      g_property_info_get_ownership_transfer (*info));
@@ -468,7 +539,7 @@ info_index (lua_State *L)
 
   if (GI_IS_FIELD_INFO (*info))
     {
-      if (strcmp (prop, "flags") == 0)
+      if (key == INFO_KEY_flags)
 	{
 	  GIFieldInfoFlags flags = g_field_info_get_flags (*info);
 	  lua_newtable (L);
@@ -484,12 +555,12 @@ info_index (lua_State *L)
 #undef H
 	      return 1;
 	}
-      else if (strcmp (prop, "size") == 0)
+      else if (key == INFO_KEY_size)
 	{
 	  lua_pushinteger (L, g_field_info_get_size (*info));
 	  return 1;
 	}
-      else if (strcmp (prop, "offset") == 0)
+      else if (key == INFO_KEY_offset)
 	{
 	  lua_pushinteger (L, g_field_info_get_offset (*info));
 	  return 1;
@@ -499,17 +570,17 @@ info_index (lua_State *L)
   if (GI_IS_TYPE_INFO (*info))
     {
       GITypeTag tag = g_type_info_get_tag (*info);
-      if (strcmp (prop, "tag") == 0)
+      if (key == INFO_KEY_tag)
 	{
 	  lua_pushstring (L, g_type_tag_to_string (tag));
 	  return 1;
 	}
-      else if (strcmp (prop, "is_basic") == 0)
+      else if (key == INFO_KEY_is_basic)
 	{
 	  lua_pushboolean (L, G_TYPE_TAG_IS_BASIC (tag));
 	  return 1;
 	}
-      else if (strcmp (prop, "params") == 0)
+      else if (key == INFO_KEY_params)
 	{
 	  if (tag == GI_TYPE_TAG_ARRAY || tag == GI_TYPE_TAG_GLIST ||
 	      tag == GI_TYPE_TAG_GSLIST || tag == GI_TYPE_TAG_GHASH)
@@ -525,12 +596,12 @@ info_index (lua_State *L)
 	      return 1;
 	    }
 	}
-      else if (strcmp (prop, "interface") == 0 && tag == GI_TYPE_TAG_INTERFACE)
+      else if (key == INFO_KEY_interface && tag == GI_TYPE_TAG_INTERFACE)
 	{
 	  lgi_gi_info_new (L, g_type_info_get_interface (*info));
 	  return 1;
 	}
-      else if (strcmp (prop, "array_type") == 0 && tag == GI_TYPE_TAG_ARRAY)
+      else if (key == INFO_KEY_array_type && tag == GI_TYPE_TAG_ARRAY)
 	{
 	  switch (g_type_info_get_array_type (*info))
 	    {
@@ -548,13 +619,13 @@ info_index (lua_State *L)
 	      g_assert_not_reached ();
 	    }
 	}
-      else if (strcmp (prop, "is_zero_terminated") == 0
+      else if (key == INFO_KEY_is_zero_terminated
 	       && tag == GI_TYPE_TAG_ARRAY)
 	{
 	  lua_pushboolean (L, g_type_info_is_zero_terminated (*info));
 	  return 1;
 	}
-      else if (strcmp (prop, "array_length") == 0)
+      else if (key == INFO_KEY_array_length)
 	{
 	  int len = g_type_info_get_array_length (*info);
 	  if (len >= 0)
@@ -563,7 +634,7 @@ info_index (lua_State *L)
 	      return 1;
 	    }
 	}
-      else if (strcmp (prop, "fixed_size") == 0)
+      else if (key == INFO_KEY_fixed_size)
 	{
 	  int size = g_type_info_get_array_fixed_size (*info);
 	  if (size >= 0)
@@ -572,7 +643,7 @@ info_index (lua_State *L)
 	      return 1;
 	    }
 	}
-      else if (strcmp (prop, "is_pointer") == 0)
+      else if (key == INFO_KEY_is_pointer)
 	{
 	  lua_pushboolean (L, g_type_info_is_pointer (*info));
 	  return 1;
@@ -605,7 +676,6 @@ info_gc (lua_State *L)
 
 static const luaL_Reg gi_info_reg[] = {
   { "__gc", info_gc },
-  { "__index", info_index },
   { "__eq", info_eq },
   { NULL, NULL }
 };
@@ -687,6 +757,11 @@ namespace_index (lua_State *L)
       lua_pushstring (L, ns);
       return 1;
     }
+  else if (strcmp (prop, "typelib_path") == 0)
+    {
+      lua_pushstring (L, g_irepository_get_typelib_path (NULL, ns));
+      return 1;
+    }
   else if (strcmp (prop, "resolve") == 0)
     {
       GITypelib **udata = lua_newuserdata (L, sizeof (GITypelib *));
@@ -757,6 +832,21 @@ gi_isinfo (lua_State *L)
   return 1;
 }
 
+/* Lua API: stamp = core.gi.stamp(path), returns string identifying
+   current state (modification time and size) of given file, or nil
+   if the file does not exist. */
+static int
+gi_stamp (lua_State *L)
+{
+  const gchar *path = luaL_checkstring (L, 1);
+  GStatBuf st;
+  if (g_stat (path, &st) != 0)
+    return 0;
+
+  lua_pushfstring (L, "%s:%d:%d", path, (int) st.st_mtime, (int) st.st_size);
+  return 1;
+}
+
 static int
 gi_index (lua_State *L)
 {
@@ -800,6 +890,7 @@ static const Reg gi_reg[] = {
 static const luaL_Reg gi_api_reg[] = {
   { "require", gi_require },
   { "isinfo", gi_isinfo },
+  { "stamp", gi_stamp },
   { NULL, NULL }
 };
 
@@ -807,6 +898,7 @@ void
 lgi_gi_init (lua_State *L)
 {
   const Reg *reg;
+  int key;
 
   /* Register metatables for userdata objects. */
   for (reg = gi_reg; reg->name; reg++)
@@ -816,6 +908,18 @@ lgi_gi_init (lua_State *L)
       lua_pop (L, 1);
     }
 
+  /* Install info_index with interned keys table as its upvalue. */
+  luaL_getmetatable (L, LGI_GI_INFO);
+  lua_createtable (L, 0, INFO_KEY_LAST);
+  for (key = INFO_KEY_UNKNOWN + 1; key < INFO_KEY_LAST; key++)
+    {
+      lua_pushinteger (L, key);
+      lua_setfield (L, -2, info_key_names[key]);
+    }
+  lua_pushcclosure (L, info_index, 1);
+  lua_setfield (L, -2, "__index");
+  lua_pop (L, 1);
+
   /* Register global API. */
   lua_newtable (L);
   luaL_register (L, NULL, gi_api_reg);
@@ -8,12 +8,16 @@
 --
 ------------------------------------------------------------------------------
 
-local assert, require, pcall, setmetatable, pairs, type, error, tostring,
-_VERSION, jit
-   = assert, require, pcall, setmetatable, pairs, type, error, tostring,
-_VERSION, rawget(_G, 'jit')
+local assert, require, pcall, setmetatable, pairs, ipairs, type, error,
+tostring, next, rawget, _VERSION, jit
+   = assert, require, pcall, setmetatable, pairs, ipairs, type, error,
+tostring, next, rawget, _VERSION, rawget(_G, 'jit')
+
+local coroutine = require 'coroutine'
 
 local package = require 'package'
+local table = require 'table'
+local math = require 'math'
 
 -- Require core lgi utilities, used during bootstrap.
 local core = require 'lgi.core'
@@ -22,7 +26,7 @@ local core = require 'lgi.core'
 local lgi = { _NAME = 'lgi', _VERSION = require 'lgi.version' }
 
 -- Forward selected core methods into external interface.
-for _, name in pairs { 'yield', 'lock', 'enter', 'leave' } do
+for _, name in pairs { 'yield', 'lock', 'enter', 'leave', 'lockstats' } do
    lgi[name] = core[name]
 end
 
@@ -64,6 +68,200 @@ function lgi.assert(cond, ...)
    error(err, 2)
 end
 
+-- Call profiler.  Collects call counts and times spent in individual
+-- phases of calls of all callables and callbacks.
+lgi.profile = {}
+
+function lgi.profile.start()
+   core.callable.profile('start')
+end
+
+function lgi.profile.stop()
+   core.callable.profile('stop')
+end
+
+-- Returns array of records describing profiled callables, sorted by
+-- total time, descending.  Records of callables with the same name
+-- are merged.
+function lgi.profile.report()
+   local records, byname = {}, {}
+   for _, entry in ipairs(core.callable.profile('report')) do
+      local record = byname[entry.name]
+      if not record then
+	 record = { name = entry.name, calls = 0, lock = 0, marshal_in = 0,
+		    call = 0, marshal_out = 0 }
+	 byname[entry.name] = record
+	 records[#records + 1] = record
+      end
+      for _, field in ipairs { 'calls', 'lock', 'marshal_in', 'call',
+			       'marshal_out' } do
+	 record[field] = record[field] + entry[field]
+      end
+   end
+   for _, record in ipairs(records) do
+      record.total = record.lock + record.marshal_in + record.call
+	 + record.marshal_out
+   end
+   table.sort(records, function(a, b) return a.total > b.total end)
+   return records
+end
+
+-- Calls function in the worker thread pool, suspending calling
+-- coroutine until the call returns.  The coroutine is resumed from
+-- thread-default main context of the caller, which must be iterated
+-- meanwhile; resuming the coroutine from elsewhere is an error.
+function lgi.offload(func, ...)
+   local coro, main = coroutine.running()
+   if not coro or main then
+      error('lgi.offload: called out of coroutine', 2)
+   end
+   local waiting = true
+   local offload = core.callable.offload(function(offload)
+	 if not waiting then return end
+	 waiting = false
+	 local ok, err = coroutine.resume(coro, offload)
+	 if not ok then error(err, 0) end
+   end, func, ...)
+   if coroutine.yield() ~= offload then
+      waiting = false
+      error('lgi.offload: coroutine resumed while the call is running', 2)
+   end
+   return offload:finish()
+end
+
+-- Resolves single symbol of the namespace, together with all elements
+-- of the component it names, so that their Callables are created and
+-- their lookups are cached.
+local function prewarm_symbol(ns, name, explicit)
+   local ok, component = pcall(function() return ns[name] end)
+   if not ok or component == nil then
+      if explicit then
+	 log.warning('prewarm: %s.%s not found', ns._name, name)
+      end
+      return
+   end
+   if type(component) ~= 'table' then return end
+   local resolve = component._resolve
+   if not resolve or not pcall(resolve, component, true) then return end
+   local element = component._element
+   for _, category in ipairs(component._categories or {}) do
+      local cat = rawget(component, category)
+      if type(cat) == 'table' then
+	 for symbol in pairs(cat) do
+	    if type(symbol) == 'string' and symbol:sub(1, 1) ~= '_' then
+	       pcall(element, component, nil, symbol)
+	    end
+	 end
+      end
+   end
+end
+
+-- Eagerly loads selected parts of namespaces, to avoid latency of
+-- lazy loading when the symbols are used for the first time.  'spec'
+-- maps namespace names either to '*' (whole namespace) or to arrays
+-- of symbol names.  If 'async' is given, loading is performed in
+-- short slices from low-priority idle handler of the default main
+-- context, and 'async' (if it is a function) is called when done.
+function lgi.prewarm(spec, async)
+   local items = {}
+   for nsname, symbols in pairs(spec) do
+      local ns = lgi.require(nsname)
+      if symbols == '*' then
+	 local gi_ns = core.gi[nsname]
+	 for i = 1, #gi_ns do
+	    items[#items + 1] = { ns, gi_ns[i].name }
+	 end
+      else
+	 if type(symbols) == 'string' then symbols = { symbols } end
+	 for _, name in ipairs(symbols) do
+	    items[#items + 1] = { ns, name, true }
+	 end
+      end
+   end
+
+   local index = 1
+   local function run(budget)
+      local GLib = repo.GLib
+      local limit = budget and GLib.get_monotonic_time() + budget
+      while items[index] do
+	 local item = items[index]
+	 prewarm_symbol(item[1], item[2], item[3])
+	 index = index + 1
+	 if limit and GLib.get_monotonic_time() >= limit then return true end
+      end
+      if type(async) == 'function' then async() end
+      return false
+   end
+
+   if not async then
+      run()
+   else
+      -- Each slice takes at most about 2 milliseconds.
+      local GLib = repo.GLib
+      GLib.idle_add(GLib.PRIORITY_LOW, function() return run(2000) end)
+   end
+end
+
+-- Reports memory held by live proxies and lgi caches.  Returns table
+-- with 'types' (statistics of live record and object proxies indexed
+-- by type name), 'records', 'objects' (totals of them), 'closures'
+-- (closure blocks and their executable memory) and 'cached' (number
+-- of entries in '_cached' tables of loaded components).  When 'top'
+-- is given, also logs that many types holding most bytes.
+function lgi.memstats(top)
+   local stats = {
+      types = {}, records = { count = 0, bytes = 0 },
+      objects = { count = 0, bytes = 0 },
+      closures = core.callable.stats(), cached = {},
+   }
+   local function account(types, totals, kind)
+      for name, entry in pairs(types) do
+	 entry.kind = kind
+	 stats.types[name] = entry
+	 for field, value in pairs(entry) do
+	    if type(value) == 'number' then
+	       totals[field] = (totals[field] or 0) + value
+	    end
+	 end
+      end
+   end
+   local records, uncached = core.record.stats()
+   account(records, stats.records, 'record')
+   for field, value in pairs(uncached) do stats.records[field] = value end
+   account(core.object.stats(), stats.objects, 'object')
+
+   -- Walk loaded namespaces and their components, without triggering
+   -- any lazy loading.
+   for nsname, ns in next, repo do
+      if type(ns) == 'table' then
+	 for name, component in next, ns do
+	    local cached = type(component) == 'table'
+	       and rawget(component, '_cached')
+	    if cached then
+	       local count = 0
+	       for _ in next, cached do count = count + 1 end
+	       stats.cached[nsname .. '.' .. name] = count
+	    end
+	 end
+      end
+   end
+
+   if top then
+      local sorted = {}
+      for name, entry in pairs(stats.types) do
+	 sorted[#sorted + 1] = { name = name, entry = entry }
+      end
+      table.sort(sorted, function(a, b)
+		    return a.entry.bytes > b.entry.bytes end)
+      for i = 1, math.min(top, #sorted) do
+	 local entry = sorted[i].entry
+	 log.message('memstats: %s %s: %d live, %d bytes', entry.kind,
+		     sorted[i].name, entry.count, entry.bytes)
+      end
+   end
+   return stats
+end
+
 -- Install metatable into repo table, so that on-demand loading works.
 setmetatable(repo, { __index = function(_, name)
 				  return lgi.require(name)
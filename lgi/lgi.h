@@ -72,11 +72,35 @@ GType lgi_type_get_gtype (lua_State *L, int narg);
    handler. Returns pointer to user_data stored inside guard. */
 gpointer *lgi_guard_create (lua_State *L, GDestroyNotify destroy);
 
+/* Allocates guard for temporary value which is not needed after the
+   currently marshalled call finishes.  Inside the call, the guard is
+   allocated from the per-thread scratch arena and destroyed when the
+   call leaves the arena, only a lightuserdata placeholder is pushed
+   to the stack.  Outside of it, behaves as lgi_guard_create(). */
+gpointer *lgi_scratch_guard (lua_State *L, GDestroyNotify destroy);
+
+/* Scratch arena frames, bracketing callable_call().  marker is
+   address of variable on the C stack of the call, narg is stack index
+   of a value (e.g. the callable) identifying the owning C function. */
+typedef struct _LgiScratch LgiScratch;
+LgiScratch *lgi_scratch_enter (lua_State *L, int narg, gconstpointer marker);
+void lgi_scratch_suspend (LgiScratch *scratch, gconstpointer marker);
+void lgi_scratch_resume (LgiScratch *scratch, gconstpointer marker);
+void lgi_scratch_leave (LgiScratch *scratch, gconstpointer marker);
+
 /* Creates cache table (optionally with given table __mode), stores it
    into registry to specified userdata address. */
 void
 lgi_cache_create (lua_State *L, gpointer key, const char *mode);
 
+/* Accounts single live instance occupying given amount of bytes into
+   memory statistics table at absolute stack index narg.  The entry is
+   keyed by the value popped from the top of the stack; its 'count'
+   and 'bytes' fields are increased, and if kind is not NULL, also
+   the counter named by it. */
+void
+lgi_stats_add (lua_State *L, int narg, const char *kind, size_t bytes);
+
 /* Initialization of modules. */
 void lgi_marshal_init (lua_State *L);
 void lgi_record_init (lua_State *L);
@@ -84,6 +108,7 @@ void lgi_object_init (lua_State *L);
 void lgi_callable_init (lua_State *L);
 void lgi_gi_init (lua_State *L);
 void lgi_buffer_init (lua_State *L);
+void lgi_variant_init (lua_State *L);
 
 /* Checks whether given argument is of specified udata - similar to
    luaL_testudata, which is missing in Lua 5.1 */
@@ -94,6 +119,51 @@ lgi_udata_test (lua_State *L, int narg, const char *name);
    http://permalink.gmane.org/gmane.comp.lang.lua.general/79288 */
 #define LGI_BYTES_BUFFER "bytes.bytearray"
 
+/* Metatable name of userdata for read-only views of byte buffers. */
+#define LGI_BYTES_VIEW "bytes.view"
+
+/* Creates read-only view of given memory block and pushes it to the
+   stack.  If owner is not NULL, it is destroyed using destroy function
+   when the view is collected. */
+void lgi_buffer_view_new (lua_State *L, gconstpointer data, gsize size,
+			  gpointer owner, GDestroyNotify destroy);
+
+/* Checks whether given argument is bytes view, if yes returns pointer
+   to its data and stores its size, otherwise returns NULL. */
+gconstpointer lgi_buffer_view_get (lua_State *L, int narg, gsize *size);
+
+/* Metatable name of userdata for typed numeric buffers. */
+#define LGI_TYPED_BUFFER "bytes.typedarray"
+
+/* Creates typed buffer of length elements of given numeric type tag
+   and pushes it to the stack.  If owner is NULL, data (if not NULL)
+   are copied into the buffer, otherwise the buffer points directly to
+   data and destroys owner when it is collected.  Returns FALSE if the
+   tag is not supported, nothing is pushed then. */
+gboolean lgi_buffer_typed_new (lua_State *L, GITypeTag tag, gpointer data,
+			       gsize length, gpointer owner,
+			       GDestroyNotify destroy);
+
+/* Checks whether given argument is typed buffer with elements of
+   given type tag, if yes returns pointer to its elements and stores
+   their count, otherwise returns NULL. */
+gpointer lgi_buffer_typed_get (lua_State *L, int narg, GITypeTag tag,
+			       gsize *length);
+
+/* Marks typed buffer at narg as read-only, used for buffers pointing
+   to immutable memory. */
+void lgi_buffer_typed_freeze (lua_State *L, int narg);
+
+/* Creates new floating GVariant of given type format from Lua value
+   at narg.  Raises Lua error if the format or the value is invalid. */
+GVariant *lgi_variant_2c (lua_State *L, const char *format, int narg);
+
+/* Pushes lazy Lua representation of the variant, taking over given
+   reference.  Basic values are pushed directly, fixed-size arrays as
+   zero-copy bytes views or read-only typed buffers, containers as
+   views decoding their children on demand. */
+void lgi_variant_2lua (lua_State *L, GVariant *variant);
+
 /* Metatable name of userdata - gi wrapped 'GIBaseInfo*' */
 #define LGI_GI_INFO "lgi.gi.info"
 
@@ -129,6 +199,19 @@ void lgi_state_leave (gpointer state_lock);
    the result should be marshalled. */
 #define LGI_PARENT_CALLER_ALLOC (G_MAXINT - 2)
 
+/* Special value for 'parent' argument of marshal_2lua, requesting
+   that owned uint8 arrays are marshalled as read-only bytes views
+   instead of copying them into Lua strings. */
+#define LGI_PARENT_BYTES_VIEW (G_MAXINT - 3)
+
+/* Similar to LGI_PARENT_BYTES_VIEW, but additionally marshals arrays
+   of other numeric elements as typed buffers. */
+#define LGI_PARENT_TYPED_BUFFER (G_MAXINT - 4)
+
+/* Requests that owned lists and hash tables are marshalled to lazy
+   container proxies instead of tables. */
+#define LGI_PARENT_LAZY_CONTAINER (G_MAXINT - 5)
+
 /* Marshalls single value from Lua to GLib/C. Returns number of temporary
    entries pushed to Lua stack, which should be popped before function call
    returns. */
@@ -136,6 +219,18 @@ int lgi_marshal_2c (lua_State *L, GITypeInfo *ti, GIArgInfo *ai,
 		    GITransfer xfer,  gpointer target, int narg,
 		    int parent, GICallableInfo *ci, void **args);
 
+/* Returns TRUE if values of given type tag are scalars (booleans,
+   numbers or gtypes), which can be marshalled by the _scalar variants
+   of marshallers below without consulting any typeinfo. */
+gboolean lgi_marshal_tag_is_scalar (GITypeTag tag);
+
+/* Marshalls scalar value of given type tag from Lua to C and from C
+   to Lua. */
+void lgi_marshal_2c_scalar (lua_State *L, GITypeTag tag, GIArgument *arg,
+			    int narg, gboolean optional, int parent);
+void lgi_marshal_2lua_scalar (lua_State *L, GITypeTag tag, GIArgument *arg,
+			      int parent);
+
 /* If given parameter is out:caller-allocates, tries to perform
    special 2c marshalling.  If not needed, returns FALSE, otherwise
    stores single value with value prepared to be returned to C. */
@@ -184,6 +279,18 @@ void lgi_closure_destroy (gpointer user_data);
    is on the stack, replaces it with newly created proxy. */
 gpointer lgi_record_new (lua_State *L, int count, gboolean alloc);
 
+/* Creates contiguous array of count records of the type given by
+   typetable on the top of the stack, replaces typetable with the
+   array.  Elements are copied from data if it is not NULL, otherwise
+   zero-initialized.  Returns address of the first element. */
+gpointer lgi_record_array_new (lua_State *L, gsize count, gconstpointer data);
+
+/* Checks whether given argument is record array with elements of the
+   type given by typetable on the top of the stack, which is popped.
+   If yes returns address of the elements and stores their count,
+   otherwise returns NULL. */
+gpointer lgi_record_array_get (lua_State *L, int narg, gsize *count);
+
 /* Creates Lua-side part of given record. Assumes that repotype table
    is on the stack, replaces it with newly created proxy. If parent
    not zero, it is stack index of record parent (i.e. record of which
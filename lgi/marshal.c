@@ -334,7 +334,7 @@ marshal_2c_array (lua_State *L, GITypeInfo *ti, GIArrayType atype,
     {
       /* Get element type info, create guard for it. */
       eti = g_type_info_get_param_type (ti, 0);
-      lgi_gi_info_new (L, eti);
+      *lgi_scratch_guard (L, (GDestroyNotify) g_base_info_unref) = eti;
       eti_guard = lua_gettop (L);
       esize = array_get_elt_size (eti, atype == GI_ARRAY_TYPE_PTR_ARRAY);
 
@@ -349,7 +349,11 @@ marshal_2c_array (lua_State *L, GITypeInfo *ti, GIArrayType atype,
 	  if (*out_array)
 	    size = lua_objlen (L, narg);
 	  else
-	    *out_array = (gpointer *) lua_tolstring (L, narg, &size);
+	    {
+	      *out_array = (gpointer) lgi_buffer_view_get (L, narg, &size);
+	      if (!*out_array)
+		*out_array = (gpointer *) lua_tolstring (L, narg, &size);
+	    }
 
 	  if (transfer != GI_TRANSFER_NOTHING)
 	    *out_array = lgi_memdup (*out_array, size);
@@ -357,6 +361,52 @@ marshal_2c_array (lua_State *L, GITypeInfo *ti, GIArrayType atype,
 	  *out_size = size;
 	}
 
+      /* Typed numeric buffers with matching element type are passed
+	 directly, or copied in a single block. */
+      if (!*out_array && lua_type (L, narg) == LUA_TUSERDATA
+	  && (atype == GI_ARRAY_TYPE_C || atype == GI_ARRAY_TYPE_ARRAY)
+	  && !g_type_info_is_pointer (eti))
+	{
+	  gsize length;
+	  gpointer data = lgi_buffer_typed_get (L, narg,
+						g_type_info_get_tag (eti),
+						&length);
+	  if (data == NULL
+	      && g_type_info_get_tag (eti) == GI_TYPE_TAG_INTERFACE)
+	    {
+	      /* Record arrays of the element type are accepted too. */
+	      GIBaseInfo *eii = g_type_info_get_interface (eti);
+	      lgi_makeabs (L, narg);
+	      lgi_type_get_repotype (L, G_TYPE_INVALID, eii);
+	      g_base_info_unref (eii);
+	      data = lgi_record_array_get (L, narg, &length);
+	    }
+	  if (data != NULL)
+	    {
+	      gssize fixed_size = g_type_info_get_array_fixed_size (ti);
+	      zero_terminated = g_type_info_is_zero_terminated (ti);
+	      luaL_argcheck (L, atype != GI_ARRAY_TYPE_C
+			     || fixed_size < 0 || (gsize) fixed_size <= length,
+			     narg, "buffer too short");
+	      *out_size = length;
+	      if (atype == GI_ARRAY_TYPE_C && transfer == GI_TRANSFER_NOTHING
+		  && !zero_terminated)
+		*out_array = data;
+	      else
+		{
+		  array = g_array_sized_new (zero_terminated, FALSE, esize,
+					     length);
+		  g_array_append_vals (array, data, length);
+		  *lgi_scratch_guard (L, (GDestroyNotify)
+				     (transfer == GI_TRANSFER_EVERYTHING
+				      ? array_detach : g_array_unref)) = array;
+		  vals = 1;
+		  *out_array = (atype == GI_ARRAY_TYPE_C)
+		    ? (gpointer) array->data : (gpointer) array;
+		}
+	    }
+	}
+
       if (!*out_array)
 	{
 	  /* Otherwise, we allow only tables. */
@@ -383,7 +433,7 @@ marshal_2c_array (lua_State *L, GITypeInfo *ti, GIArrayType atype,
 		  array = g_array_sized_new (zero_terminated, TRUE, esize,
 					     *out_size);
 		  g_array_set_size (array, *out_size);
-		  *lgi_guard_create (L, (GDestroyNotify)
+		  *lgi_scratch_guard (L, (GDestroyNotify)
 				     (transfer == GI_TRANSFER_EVERYTHING
 				      ? array_detach : g_array_unref)) = array;
 		  break;
@@ -392,7 +442,7 @@ marshal_2c_array (lua_State *L, GITypeInfo *ti, GIArrayType atype,
 		  parent = LGI_PARENT_FORCE_POINTER;
 		  array = (GArray *) g_ptr_array_sized_new (total_size);
 		  g_ptr_array_set_size ((GPtrArray *) array, total_size);
-		  *lgi_guard_create (L, (GDestroyNotify)
+		  *lgi_scratch_guard (L, (GDestroyNotify)
 				     (transfer == GI_TRANSFER_EVERYTHING
 				      ? ptr_array_detach :
 				      g_ptr_array_unref)) = array;
@@ -401,7 +451,7 @@ marshal_2c_array (lua_State *L, GITypeInfo *ti, GIArrayType atype,
 		case GI_ARRAY_TYPE_BYTE_ARRAY:
 		  array = (GArray *) g_byte_array_sized_new (total_size);
 		  g_byte_array_set_size ((GByteArray *) array, *out_size);
-		  *lgi_guard_create (L, (GDestroyNotify)
+		  *lgi_scratch_guard (L, (GDestroyNotify)
 				     (transfer == GI_TRANSFER_EVERYTHING
 				      ? byte_array_detach :
 				      g_byte_array_unref)) = array;
@@ -455,6 +505,26 @@ marshal_2c_array (lua_State *L, GITypeInfo *ti, GIArrayType atype,
   return vals;
 }
 
+/* If given element typeinfo is a structure or union with known
+   repotype, pushes the repotype and returns TRUE. */
+static gboolean
+array_record_repotype (lua_State *L, GITypeInfo *eti)
+{
+  GIBaseInfo *eii = g_type_info_get_interface (eti);
+  GIInfoType type = g_base_info_get_type (eii);
+  if (type == GI_INFO_TYPE_STRUCT || type == GI_INFO_TYPE_UNION)
+    {
+      lgi_type_get_repotype (L, G_TYPE_INVALID, eii);
+      g_base_info_unref (eii);
+      if (!lua_isnil (L, -1))
+	return TRUE;
+      lua_pop (L, 1);
+      return FALSE;
+    }
+  g_base_info_unref (eii);
+  return FALSE;
+}
+
 static void
 marshal_2lua_array (lua_State *L, GITypeInfo *ti, GIDirection dir,
 		    GIArrayType atype, GITransfer transfer,
@@ -464,10 +534,18 @@ marshal_2lua_array (lua_State *L, GITypeInfo *ti, GIDirection dir,
   gssize len = 0, esize;
   gint index, eti_guard;
   char *data = NULL;
+  gboolean view = FALSE, typed = FALSE;
 
   /* Avoid propagating return value marshaling flag to array elements. */
   if (parent == LGI_PARENT_IS_RETVAL)
     parent = 0;
+  else if (parent == LGI_PARENT_BYTES_VIEW
+	   || parent == LGI_PARENT_TYPED_BUFFER)
+    {
+      view = TRUE;
+      typed = (parent == LGI_PARENT_TYPED_BUFFER);
+      parent = 0;
+    }
 
   /* First of all, find out the length of the array. */
   if (atype == GI_ARRAY_TYPE_ARRAY)
@@ -513,7 +591,7 @@ marshal_2lua_array (lua_State *L, GITypeInfo *ti, GIDirection dir,
   /* Get array element type info, wrap it in the guard so that we
      don't leak it. */
   eti = g_type_info_get_param_type (ti, 0);
-  lgi_gi_info_new (L, eti);
+  *lgi_scratch_guard (L, (GDestroyNotify) g_base_info_unref) = eti;
   eti_guard = lua_gettop (L);
   esize = array_get_elt_size (eti, atype == GI_ARRAY_TYPE_PTR_ARRAY);
 
@@ -528,11 +606,43 @@ marshal_2lua_array (lua_State *L, GITypeInfo *ti, GIDirection dir,
       /* UINT8 arrays are marshalled as Lua strings. */
       if (len < 0)
 	len = data ? strlen(data) : 0;
-      if (data != NULL || len != 0)
+      if (view && data != NULL && transfer != GI_TRANSFER_NOTHING
+	  && atype != GI_ARRAY_TYPE_PTR_ARRAY)
+	{
+	  /* Hand the ownership of the array over to the view instead of
+	     copying its contents. */
+	  GDestroyNotify destroy =
+	    (atype == GI_ARRAY_TYPE_ARRAY) ? (GDestroyNotify) g_array_unref
+	    : (atype == GI_ARRAY_TYPE_BYTE_ARRAY)
+	    ? (GDestroyNotify) g_byte_array_unref : g_free;
+	  lgi_buffer_view_new (L, data, len, array, destroy);
+	  transfer = GI_TRANSFER_NOTHING;
+	}
+      else if (data != NULL || len != 0)
         lua_pushlstring (L, data, len);
       else
         lua_pushnil (L);
     }
+  else if (typed && data != NULL && len >= 0
+	   && (atype == GI_ARRAY_TYPE_C || atype == GI_ARRAY_TYPE_ARRAY)
+	   && !g_type_info_is_pointer (eti)
+	   && lgi_buffer_typed_new (L, g_type_info_get_tag (eti), data, len,
+				    (transfer != GI_TRANSFER_NOTHING)
+				    ? array : NULL,
+				    (atype == GI_ARRAY_TYPE_ARRAY)
+				    ? (GDestroyNotify) g_array_unref : g_free))
+    {
+      /* Numeric array was either copied in one block or its ownership
+	 was handed over to the typed buffer. */
+      transfer = GI_TRANSFER_NOTHING;
+    }
+  else if (typed && data != NULL && len >= 0
+	   && (atype == GI_ARRAY_TYPE_C || atype == GI_ARRAY_TYPE_ARRAY)
+	   && !g_type_info_is_pointer (eti)
+	   && g_type_info_get_tag (eti) == GI_TYPE_TAG_INTERFACE
+	   && array_record_repotype (L, eti))
+    /* Arrays of structures are copied into single record array. */
+    lgi_record_array_new (L, len, data);
   else
     {
       if (array == NULL)
@@ -612,12 +722,12 @@ marshal_2c_list (lua_State *L, GITypeInfo *ti, GITypeTag list_tag,
   /* Get list element type info, create guard for it so that we don't
      leak it. */
   eti = g_type_info_get_param_type (ti, 0);
-  lgi_gi_info_new (L, eti);
+  *lgi_scratch_guard (L, (GDestroyNotify) g_base_info_unref) = eti;
   eti_guard = lua_gettop (L);
 
   /* Go from back and prepend to the list, which is cheaper than
      appending. */
-  guard = (GSList **) lgi_guard_create (L, list_tag == GI_TYPE_TAG_GSLIST
+  guard = (GSList **) lgi_scratch_guard (L, list_tag == GI_TYPE_TAG_GSLIST
 					? (GDestroyNotify) g_slist_free
 					: (GDestroyNotify) g_list_free);
   while (index > 0)
@@ -646,17 +756,29 @@ marshal_2c_list (lua_State *L, GITypeInfo *ti, GITypeTag list_tag,
   return vals;
 }
 
+static void
+marshal_2lua_lazy (lua_State *L, GITypeInfo *ti, GIDirection dir,
+		   GITypeTag tag, GITransfer xfer, gpointer container);
+
 static int
 marshal_2lua_list (lua_State *L, GITypeInfo *ti, GIDirection dir,
-		   GITypeTag list_tag, GITransfer xfer, gpointer list)
+		   GITypeTag list_tag, GITransfer xfer, gpointer list,
+		   int parent)
 {
   GSList *i;
   GITypeInfo *eti;
   gint index, eti_guard;
 
+  /* Owned lists can be wrapped without conversion. */
+  if (parent == LGI_PARENT_LAZY_CONTAINER && xfer != GI_TRANSFER_NOTHING)
+    {
+      marshal_2lua_lazy (L, ti, dir, list_tag, xfer, list);
+      return 1;
+    }
+
   /* Get element type info, guard it so that we don't leak it. */
   eti = g_type_info_get_param_type (ti, 0);
-  lgi_gi_info_new (L, eti);
+  *lgi_scratch_guard (L, (GDestroyNotify) g_base_info_unref) = eti;
   eti_guard = lua_gettop (L);
 
   /* Create table to which we will deserialize the list. */
@@ -715,13 +837,13 @@ marshal_2c_hash (lua_State *L, GITypeInfo *ti, GHashTable **table, int narg,
       for (i = 0; i < 2; i++)
 	{
 	  eti[i] = g_type_info_get_param_type (ti, i);
-	  lgi_gi_info_new (L, eti[i]);
+	  *lgi_scratch_guard (L, (GDestroyNotify) g_base_info_unref) = eti[i];
 	}
 
       /* Create the hashtable and guard it so that it is destroyed in
 	 case something goes wrong during marshalling. */
       guarded_table = (GHashTable **)
-	lgi_guard_create (L, (GDestroyNotify) g_hash_table_destroy);
+	lgi_scratch_guard (L, (GDestroyNotify) g_hash_table_destroy);
       vals++;
 
       /* Find out which hash_func and equal_func should be used,
@@ -784,7 +906,7 @@ marshal_2c_hash (lua_State *L, GITypeInfo *ti, GHashTable **table, int narg,
 
 static void
 marshal_2lua_hash (lua_State *L, GITypeInfo *ti, GIDirection dir,
-		   GITransfer xfer, GHashTable *hash_table)
+		   GITransfer xfer, GHashTable *hash_table, int parent)
 {
   GHashTableIter iter;
   GITypeInfo *eti[2];
@@ -794,6 +916,8 @@ marshal_2lua_hash (lua_State *L, GITypeInfo *ti, GIDirection dir,
   /* Check for 'NULL' table, represent it simply as nil. */
   if (hash_table == NULL)
     lua_pushnil (L);
+  else if (parent == LGI_PARENT_LAZY_CONTAINER && xfer != GI_TRANSFER_NOTHING)
+    marshal_2lua_lazy (L, ti, dir, GI_TYPE_TAG_GHASH, xfer, hash_table);
   else
     {
       /* Get key and value type infos, guard them so that we don't
@@ -802,7 +926,7 @@ marshal_2lua_hash (lua_State *L, GITypeInfo *ti, GIDirection dir,
       for (i = 0; i < 2; i++)
 	{
 	  eti[i] = g_type_info_get_param_type (ti, i);
-	  lgi_gi_info_new (L, eti[i]);
+	  *lgi_scratch_guard (L, (GDestroyNotify) g_base_info_unref) = eti[i];
 	}
 
       /* Create table to which we will deserialize the hashtable. */
@@ -831,6 +955,327 @@ marshal_2lua_hash (lua_State *L, GITypeInfo *ti, GIDirection dir,
     }
 }
 
+/* Lazy proxy of owned GList, GSList or GHashTable.  Elements are
+   marshalled only when accessed and remembered in the env table of
+   the proxy. */
+typedef struct _LazyContainer
+{
+  gpointer container;
+  GITypeInfo *eti[2];
+  guint tag : 5;
+  guint dir : 2;
+  guint transfer : 2;
+
+  /* Lists only: cached length (-1 when not known yet) and the last
+     visited node with its 1-based index, so that sequential access
+     does not walk the list from the beginning. */
+  gint length;
+  GSList *cursor;
+  gint cursor_index;
+} LazyContainer;
+#define UD_LAZY_CONTAINER "lgi.container"
+
+static LazyContainer *
+lazy_check (lua_State *L, int narg)
+{
+  return luaL_checkudata (L, narg, UD_LAZY_CONTAINER);
+}
+
+static void
+marshal_2lua_lazy (lua_State *L, GITypeInfo *ti, GIDirection dir,
+		   GITypeTag tag, GITransfer xfer, gpointer container)
+{
+  LazyContainer *lazy = lua_newuserdata (L, sizeof (LazyContainer));
+  lazy->container = container;
+  lazy->eti[0] = g_type_info_get_param_type (ti, 0);
+  lazy->eti[1] = (tag == GI_TYPE_TAG_GHASH)
+    ? g_type_info_get_param_type (ti, 1) : NULL;
+  lazy->tag = tag;
+  lazy->dir = dir;
+  lazy->transfer = xfer;
+  lazy->length = -1;
+  lazy->cursor = NULL;
+  lazy->cursor_index = 0;
+  luaL_getmetatable (L, UD_LAZY_CONTAINER);
+  lua_setmetatable (L, -2);
+  lua_newtable (L);
+  lua_setfenv (L, -2);
+}
+
+/* Finds 1-based index-th node of the list, or NULL. */
+static GSList *
+lazy_list_node (LazyContainer *lazy, lua_Integer index)
+{
+  GSList *node = lazy->container;
+  lua_Integer i = 1;
+  if (index < 1 || (lazy->length >= 0 && index > lazy->length))
+    return NULL;
+  if (lazy->cursor != NULL && lazy->cursor_index <= index)
+    {
+      node = lazy->cursor;
+      i = lazy->cursor_index;
+    }
+  for (; node != NULL && i < index; i++)
+    node = g_slist_next (node);
+  if (node != NULL)
+    {
+      lazy->cursor = node;
+      lazy->cursor_index = index;
+    }
+  return node;
+}
+
+/* Pushes value of the list element, marshalling it when not
+   remembered yet.  Expects env table of the proxy at the top of the
+   stack. */
+static void
+lazy_list_push (lua_State *L, LazyContainer *lazy, lua_Integer index)
+{
+  GSList *node;
+  lua_rawgeti (L, -1, index);
+  if (!lua_isnil (L, -1))
+    return;
+
+  lua_pop (L, 1);
+  node = lazy_list_node (lazy, index);
+  if (node == NULL)
+    {
+      lua_pushnil (L);
+      return;
+    }
+
+  /* Owned element is taken over by the marshalled value, so clear it
+     in the list; it is not released again when the proxy is
+     collected. */
+  lgi_marshal_2lua (L, lazy->eti[0], NULL, lazy->dir,
+		    lazy->transfer == GI_TRANSFER_EVERYTHING
+		    ? GI_TRANSFER_EVERYTHING : GI_TRANSFER_NOTHING,
+		    &node->data, LGI_PARENT_FORCE_POINTER, NULL, NULL);
+  if (lazy->transfer == GI_TRANSFER_EVERYTHING)
+    node->data = NULL;
+  lua_pushvalue (L, -1);
+  lua_rawseti (L, -3, index);
+}
+
+static int
+lazy_index (lua_State *L)
+{
+  LazyContainer *lazy = lazy_check (L, 1);
+  lua_getfenv (L, 1);
+  if (lazy->tag != GI_TYPE_TAG_GHASH)
+    {
+      if (lua_type (L, 2) != LUA_TNUMBER)
+	return 0;
+      lazy_list_push (L, lazy, lua_tointeger (L, 2));
+      return 1;
+    }
+  else
+    {
+      GIArgument key;
+      gpointer value;
+      int vals;
+
+      /* Return remembered value, if available. */
+      lua_pushvalue (L, 2);
+      lua_rawget (L, -2);
+      if (!lua_isnil (L, -1) || lua_isnil (L, 2))
+	return 1;
+      lua_pop (L, 1);
+
+      /* Marshal the key and look it up. */
+      vals = lgi_marshal_2c (L, lazy->eti[0], NULL, GI_TRANSFER_NOTHING,
+			     &key, 2, LGI_PARENT_FORCE_POINTER, NULL, NULL);
+      if (!g_hash_table_lookup_extended (lazy->container, key.v_pointer,
+					 NULL, &value))
+	{
+	  lua_pop (L, vals);
+	  return 0;
+	}
+      lua_pop (L, vals);
+      lgi_marshal_2lua (L, lazy->eti[1], NULL, lazy->dir,
+			GI_TRANSFER_NOTHING, &value,
+			LGI_PARENT_FORCE_POINTER, NULL, NULL);
+      lua_pushvalue (L, 2);
+      lua_pushvalue (L, -2);
+      lua_rawset (L, -4);
+      return 1;
+    }
+}
+
+static int
+lazy_len (lua_State *L)
+{
+  LazyContainer *lazy = lazy_check (L, 1);
+  if (lazy->tag == GI_TYPE_TAG_GHASH)
+    lua_pushinteger (L, g_hash_table_size (lazy->container));
+  else
+    {
+      if (lazy->length < 0)
+	lazy->length = g_slist_length (lazy->container);
+      lua_pushinteger (L, lazy->length);
+    }
+  return 1;
+}
+
+/* Releases owned list element directly according to its type,
+   returns FALSE if the type cannot be released this way. */
+static gboolean
+lazy_element_free (GITypeInfo *eti, gpointer data)
+{
+  gboolean freed = TRUE;
+  switch (g_type_info_get_tag (eti))
+    {
+    case GI_TYPE_TAG_UTF8:
+    case GI_TYPE_TAG_FILENAME:
+      g_free (data);
+      break;
+
+    case GI_TYPE_TAG_INTERFACE:
+      {
+	GIBaseInfo *ii = g_type_info_get_interface (eti);
+	GType gtype;
+	switch (g_base_info_get_type (ii))
+	  {
+	  case GI_INFO_TYPE_OBJECT:
+	  case GI_INFO_TYPE_INTERFACE:
+	    gtype = G_TYPE_FROM_INSTANCE (data);
+	    if (G_TYPE_IS_OBJECT (gtype))
+	      g_object_unref (data);
+	    else if (G_TYPE_FUNDAMENTAL (gtype) == G_TYPE_PARAM)
+	      g_param_spec_unref (data);
+	    else
+	      freed = FALSE;
+	    break;
+
+	  case GI_INFO_TYPE_STRUCT:
+	  case GI_INFO_TYPE_UNION:
+	  case GI_INFO_TYPE_BOXED:
+	    gtype = g_registered_type_info_get_g_type (ii);
+	    if (gtype == G_TYPE_VARIANT)
+	      g_variant_unref (data);
+	    else if (G_TYPE_IS_BOXED (gtype))
+	      g_boxed_free (gtype, data);
+	    else
+	      freed = FALSE;
+	    break;
+
+	  default:
+	    freed = FALSE;
+	  }
+	g_base_info_unref (ii);
+	break;
+      }
+
+    default:
+      freed = FALSE;
+    }
+  return freed;
+}
+
+static int
+lazy_gc (lua_State *L)
+{
+  LazyContainer *lazy = lazy_check (L, 1);
+  GSList *node;
+  if (lazy->tag == GI_TYPE_TAG_GHASH)
+    g_hash_table_unref (lazy->container);
+  else
+    {
+      /* Release owned elements which were never accessed.  Elements
+	 of types which cannot be freed directly (custom fundamental
+	 objects, nested containers) are marshalled with full transfer
+	 and the result is dropped. */
+      if (lazy->transfer == GI_TRANSFER_EVERYTHING)
+	for (node = lazy->container; node != NULL; node = g_slist_next (node))
+	  if (node->data != NULL && !lazy_element_free (lazy->eti[0],
+							node->data))
+	    {
+	      lgi_marshal_2lua (L, lazy->eti[0], NULL, lazy->dir,
+				GI_TRANSFER_EVERYTHING, &node->data,
+				LGI_PARENT_FORCE_POINTER, NULL, NULL);
+	      lua_pop (L, 1);
+	    }
+      if (lazy->tag == GI_TYPE_TAG_GSLIST)
+	g_slist_free (lazy->container);
+      else
+	g_list_free (lazy->container);
+    }
+  lazy->container = NULL;
+  g_base_info_unref (lazy->eti[0]);
+  if (lazy->eti[1] != NULL)
+    g_base_info_unref (lazy->eti[1]);
+  return 0;
+}
+
+static int
+lazy_tostring (lua_State *L)
+{
+  LazyContainer *lazy = lazy_check (L, 1);
+  lua_pushfstring (L, "lgi.container %s: %p",
+		   g_type_tag_to_string (lazy->tag), lazy->container);
+  return 1;
+}
+
+/* Iterator over the proxy, yields index and element for lists, key
+   and value for hash tables. */
+static int
+lazy_next (lua_State *L)
+{
+  LazyContainer *lazy = lazy_check (L, 1);
+  if (lazy->tag != GI_TYPE_TAG_GHASH)
+    {
+      lua_Integer index = lua_tointeger (L, 2) + 1;
+      if (lazy_list_node (lazy, index) == NULL)
+	return 0;
+      lua_pushinteger (L, index);
+      lua_getfenv (L, 1);
+      lazy_list_push (L, lazy, index);
+      lua_remove (L, -2);
+      return 2;
+    }
+  else
+    {
+      GHashTableIter *iter = lua_touserdata (L, lua_upvalueindex (1));
+      GIArgument eval[2];
+      int i;
+      if (!g_hash_table_iter_next (iter, &eval[0].v_pointer,
+				   &eval[1].v_pointer))
+	return 0;
+      for (i = 0; i < 2; i++)
+	lgi_marshal_2lua (L, lazy->eti[i], NULL, lazy->dir,
+			  GI_TRANSFER_NOTHING, &eval[i],
+			  LGI_PARENT_FORCE_POINTER, NULL, NULL);
+      return 2;
+    }
+}
+
+static int
+lazy_pairs (lua_State *L)
+{
+  LazyContainer *lazy = lazy_check (L, 1);
+  if (lazy->tag == GI_TYPE_TAG_GHASH)
+    {
+      GHashTableIter *iter = lua_newuserdata (L, sizeof (GHashTableIter));
+      g_hash_table_iter_init (iter, lazy->container);
+      lua_pushcclosure (L, lazy_next, 1);
+    }
+  else
+    lua_pushcfunction (L, lazy_next);
+  lua_pushvalue (L, 1);
+  lua_pushinteger (L, 0);
+  return 3;
+}
+
+static const struct luaL_Reg lazy_mt_reg[] = {
+  { "__index", lazy_index },
+  { "__len", lazy_len },
+  { "__gc", lazy_gc },
+  { "__tostring", lazy_tostring },
+  { "__pairs", lazy_pairs },
+  { "__ipairs", lazy_pairs },
+  { NULL, NULL }
+};
+
 static void
 marshal_2lua_error (lua_State *L, GITransfer xfer, GError *err)
 {
@@ -912,7 +1357,7 @@ marshal_2c_callable (lua_State *L, GICallableInfo *ci, GIArgInfo *ai,
       user_data = lgi_closure_allocate (L, 1);
       if (scope == GI_SCOPE_TYPE_CALL)
 	{
-	  *lgi_guard_create (L, lgi_closure_destroy) = user_data;
+	  *lgi_scratch_guard (L, lgi_closure_destroy) = user_data;
 	  nret++;
 	}
       else
@@ -926,24 +1371,38 @@ marshal_2c_callable (lua_State *L, GICallableInfo *ci, GIArgInfo *ai,
   return nret;
 }
 
-/* Marshalls single value from Lua to GLib/C. */
-int
-lgi_marshal_2c (lua_State *L, GITypeInfo *ti, GIArgInfo *ai,
-		GITransfer transfer, gpointer target, int narg,
-		int parent, GICallableInfo *ci, void **args)
+/* Checks whether given tag denotes scalar type. */
+gboolean
+lgi_marshal_tag_is_scalar (GITypeTag tag)
 {
-  int nret = 0;
-  gboolean optional = (parent == LGI_PARENT_CALLER_ALLOC) ||
-    (ai == NULL || (g_arg_info_is_optional (ai) ||
-		       g_arg_info_may_be_null (ai)));
-  GITypeTag tag = g_type_info_get_tag (ti);
-  GIArgument *arg = target;
+  switch (tag)
+    {
+    case GI_TYPE_TAG_BOOLEAN:
+    case GI_TYPE_TAG_INT8:
+    case GI_TYPE_TAG_UINT8:
+    case GI_TYPE_TAG_INT16:
+    case GI_TYPE_TAG_UINT16:
+    case GI_TYPE_TAG_INT32:
+    case GI_TYPE_TAG_UINT32:
+    case GI_TYPE_TAG_INT64:
+    case GI_TYPE_TAG_UINT64:
+    case GI_TYPE_TAG_FLOAT:
+    case GI_TYPE_TAG_DOUBLE:
+    case GI_TYPE_TAG_GTYPE:
+    case GI_TYPE_TAG_UNICHAR:
+      return TRUE;
 
-  /* Convert narg stack position to absolute one, because during
-     marshalling some temporary items might be pushed to the stack,
-     which would disrupt relative stack addressing of the value. */
-  lgi_makeabs(L, narg);
+    default:
+      return FALSE;
+    }
+}
 
+/* Marshalls scalar (boolean, numeric or gtype) value from Lua to
+   GLib/C. */
+void
+lgi_marshal_2c_scalar (lua_State *L, GITypeTag tag, GIArgument *arg,
+		       int narg, gboolean optional, int parent)
+{
   switch (tag)
     {
     case GI_TYPE_TAG_BOOLEAN:
@@ -970,7 +1429,7 @@ lgi_marshal_2c (lua_State *L, GITypeInfo *ti, GIArgInfo *ai,
 	  ? 0 : luaL_checknumber (L, narg);
 
 	/* Marshalling float/double into pointer target is not possible. */
-	g_return_val_if_fail (parent != LGI_PARENT_FORCE_POINTER, 0);
+	g_return_if_fail (parent != LGI_PARENT_FORCE_POINTER);
 
 	/* Store read value into chosen target. */
 	if (tag == GI_TYPE_TAG_FLOAT)
@@ -980,6 +1439,31 @@ lgi_marshal_2c (lua_State *L, GITypeInfo *ti, GIArgInfo *ai,
 	break;
       }
 
+    default:
+      marshal_2c_int (L, tag, arg, narg, optional, parent);
+    }
+}
+
+/* Marshalls single value from Lua to GLib/C. */
+int
+lgi_marshal_2c (lua_State *L, GITypeInfo *ti, GIArgInfo *ai,
+		GITransfer transfer, gpointer target, int narg,
+		int parent, GICallableInfo *ci, void **args)
+{
+  int nret = 0;
+  gboolean optional = (parent == LGI_PARENT_CALLER_ALLOC) ||
+    (ai == NULL || (g_arg_info_is_optional (ai) ||
+		       g_arg_info_may_be_null (ai)));
+  GITypeTag tag = g_type_info_get_tag (ti);
+  GIArgument *arg = target;
+
+  /* Convert narg stack position to absolute one, because during
+     marshalling some temporary items might be pushed to the stack,
+     which would disrupt relative stack addressing of the value. */
+  lgi_makeabs(L, narg);
+
+  switch (tag)
+    {
     case GI_TYPE_TAG_UTF8:
     case GI_TYPE_TAG_FILENAME:
       {
@@ -1005,7 +1489,7 @@ lgi_marshal_2c (lua_State *L, GITypeInfo *ti, GIArgInfo *ai,
 		  {
 		    /* Create temporary object on the stack which will
 		       destroy the allocated temporary filename. */
-		    *lgi_guard_create (L, g_free) = (gpointer) str;
+		    *lgi_scratch_guard (L, g_free) = (gpointer) str;
 		    nret = 1;
 		  }
 	      }
@@ -1024,7 +1508,7 @@ lgi_marshal_2c (lua_State *L, GITypeInfo *ti, GIArgInfo *ai,
 	GIBaseInfo *info = g_type_info_get_interface (ti);
 	GIInfoType type = g_base_info_get_type (info);
 	int info_guard;
-	lgi_gi_info_new (L, info);
+	*lgi_scratch_guard (L, (GDestroyNotify) g_base_info_unref) = info;
 	info_guard = lua_gettop (L);
 	switch (type)
 	  {
@@ -1157,7 +1641,7 @@ lgi_marshal_2c (lua_State *L, GITypeInfo *ti, GIArgInfo *ai,
       break;
 
     default:
-      marshal_2c_int (L, tag, arg, narg, optional, parent);
+      lgi_marshal_2c_scalar (L, tag, arg, narg, optional, parent);
     }
 
   return nret;
@@ -1206,7 +1690,7 @@ lgi_marshal_2c_caller_alloc (lua_State *L, GITypeInfo *ti, GIArgument *val,
 		/* Allocate underlying array.  It is temporary,
 		   existing only for the duration of the call. */
 		array_guard =
-		  lgi_guard_create (L, (GDestroyNotify) g_array_unref);
+		  lgi_scratch_guard (L, (GDestroyNotify) g_array_unref);
 		*array_guard = g_array_sized_new (FALSE, FALSE, elt_size, size);
 		g_array_set_size (*array_guard, size);
 	      }
@@ -1249,6 +1733,35 @@ lgi_marshal_2c_caller_alloc (lua_State *L, GITypeInfo *ti, GIArgument *val,
   return handled;
 }
 
+/* Marshalls scalar (boolean, numeric or gtype) value from GLib/C to
+   Lua. */
+void
+lgi_marshal_2lua_scalar (lua_State *L, GITypeTag tag, GIArgument *arg,
+			 int parent)
+{
+  switch (tag)
+    {
+    case GI_TYPE_TAG_BOOLEAN:
+      if (parent == LGI_PARENT_IS_RETVAL)
+	{
+	  ReturnUnion *ru = (ReturnUnion *) arg;
+	  ru->arg.v_boolean = ru->s;
+	}
+      lua_pushboolean (L, arg->v_boolean);
+      break;
+
+    case GI_TYPE_TAG_FLOAT:
+    case GI_TYPE_TAG_DOUBLE:
+      g_return_if_fail (parent != LGI_PARENT_FORCE_POINTER);
+      lua_pushnumber (L, (tag == GI_TYPE_TAG_FLOAT)
+		      ? arg->v_float : arg->v_double);
+      break;
+
+    default:
+      marshal_2lua_int (L, tag, arg, parent);
+    }
+}
+
 /* Marshalls single value from GLib/C to Lua.  Returns 1 if something
    was pushed to the stack. */
 void
@@ -1274,22 +1787,6 @@ lgi_marshal_2lua (lua_State *L, GITypeInfo *ti, GIArgInfo *ai, GIDirection dir,
 	lua_pushnil (L);
       break;
 
-    case GI_TYPE_TAG_BOOLEAN:
-      if (parent == LGI_PARENT_IS_RETVAL)
-	{
-	  ReturnUnion *ru = (ReturnUnion *) arg;
-	  ru->arg.v_boolean = ru->s;
-	}
-      lua_pushboolean (L, arg->v_boolean);
-      break;
-
-    case GI_TYPE_TAG_FLOAT:
-    case GI_TYPE_TAG_DOUBLE:
-      g_return_if_fail (parent != LGI_PARENT_FORCE_POINTER);
-      lua_pushnumber (L, (tag == GI_TYPE_TAG_FLOAT)
-		      ? arg->v_float : arg->v_double);
-      break;
-
     case GI_TYPE_TAG_UTF8:
     case GI_TYPE_TAG_FILENAME:
       {
@@ -1313,7 +1810,7 @@ lgi_marshal_2lua (lua_State *L, GITypeInfo *ti, GIArgInfo *ai, GIDirection dir,
 	GIBaseInfo *info = g_type_info_get_interface (ti);
 	GIInfoType type = g_base_info_get_type (info);
 	int info_guard;
-	lgi_gi_info_new (L, info);
+	*lgi_scratch_guard (L, (GDestroyNotify) g_base_info_unref) = info;
 	info_guard = lua_gettop (L);
 	switch (type)
 	  {
@@ -1394,11 +1891,11 @@ lgi_marshal_2lua (lua_State *L, GITypeInfo *ti, GIArgInfo *ai, GIDirection dir,
 
     case GI_TYPE_TAG_GSLIST:
     case GI_TYPE_TAG_GLIST:
-      marshal_2lua_list (L, ti, dir, tag, transfer, arg->v_pointer);
+      marshal_2lua_list (L, ti, dir, tag, transfer, arg->v_pointer, parent);
       break;
 
     case GI_TYPE_TAG_GHASH:
-      marshal_2lua_hash (L, ti, dir, transfer, arg->v_pointer);
+      marshal_2lua_hash (L, ti, dir, transfer, arg->v_pointer, parent);
       break;
 
     case GI_TYPE_TAG_ERROR:
@@ -1406,7 +1903,31 @@ lgi_marshal_2lua (lua_State *L, GITypeInfo *ti, GIArgInfo *ai, GIDirection dir,
       break;
 
     default:
-      marshal_2lua_int (L, tag, arg, parent);
+      lgi_marshal_2lua_scalar (L, tag, arg, parent);
+    }
+}
+
+/* Kind of field descriptor compiled by marshal.field() for scalar
+   fields, handled without consulting any typeinfo. */
+#define FIELD_KIND_SCALAR 4
+
+/* Verifies that field with given flags can be read or written (as
+   requested by getmode), unless the typetable disables access checks
+   completely. */
+static void
+marshal_field_check_access (lua_State *L, int typetable, int flags,
+			    gboolean getmode, const char *name)
+{
+  if ((flags & (getmode ? GI_FIELD_IS_READABLE : GI_FIELD_IS_WRITABLE)) == 0)
+    {
+      lua_getfield (L, typetable, "_allow");
+      if (!lua_toboolean (L, -1))
+	{
+	  lua_getfield (L, typetable, "_name");
+	  luaL_error (L, "%s: field `%s' is not %s", lua_tostring (L, -1),
+		      name, getmode ? "readable" : "writable");
+	}
+      lua_pop (L, 1);
     }
 }
 
@@ -1428,25 +1949,8 @@ lgi_marshal_field (lua_State *L, gpointer object, gboolean getmode,
 
       /* Check, whether field is readable/writable. */
       flags = g_field_info_get_flags (*fi);
-      if ((flags & (getmode ? GI_FIELD_IS_READABLE
-		    : GI_FIELD_IS_WRITABLE)) == 0)
-	{
-	  /* Check,  whether  parent  did not disable  access  checks
-	     completely. */
-	  lua_getfield (L, -1, "_allow");
-	  if (!lua_toboolean (L, -1))
-	    {
-	      /* Prepare proper error message. */
-	      lua_concat (L,
-			  lgi_type_get_name (L,
-					     g_base_info_get_container (*fi)));
-	      return luaL_error (L, "%s: field `%s' is not %s",
-				 lua_tostring (L, -1),
-				 g_base_info_get_name (*fi),
-				 getmode ? "readable" : "writable");
-	    }
-	  lua_pop (L, 1);
-	}
+      marshal_field_check_access (L, lua_gettop (L), flags, getmode,
+				  g_base_info_get_name (*fi));
 
       /* Map GIArgument to proper memory location, get typeinfo of the
 	 field and perform actual marshalling. */
@@ -1467,6 +1971,28 @@ lgi_marshal_field (lua_State *L, gpointer object, gboolean getmode,
       kind = lua_tointeger (L, -1);
       lua_pop (L, 2);
 
+      /* Compiled scalar fields need neither typeinfo nor any
+	 temporary. */
+      if (kind == FIELD_KIND_SCALAR)
+	{
+	  GITypeTag tag;
+	  int typetable = lua_gettop (L);
+	  lua_rawgeti (L, field_arg, 3);
+	  lua_rawgeti (L, field_arg, 4);
+	  lua_rawgeti (L, field_arg, 5);
+	  tag = lua_tointeger (L, -3);
+	  marshal_field_check_access (L, typetable, lua_tointeger (L, -2),
+				      getmode, lua_tostring (L, -1));
+	  lua_pop (L, 3);
+	  if (getmode)
+	    {
+	      lgi_marshal_2lua_scalar (L, tag, field_addr, 0);
+	      return 1;
+	    }
+	  lgi_marshal_2c_scalar (L, tag, field_addr, val_arg, TRUE, 0);
+	  return 0;
+	}
+
       /* Load type information from the table and decide how to handle
 	 it according to 'kind' */
       lua_rawgeti (L, field_arg, 3);
@@ -1645,14 +2171,14 @@ marshal_container_marshaller (lua_State *L)
     case GI_TYPE_TAG_GSLIST:
     case GI_TYPE_TAG_GLIST:
       if (get_mode)
-	marshal_2lua_list (L, *ti, GI_DIRECTION_OUT, tag, transfer, data);
+	marshal_2lua_list (L, *ti, GI_DIRECTION_OUT, tag, transfer, data, 0);
       else
 	nret = marshal_2c_list (L, *ti, tag, &data, 3, transfer);
       break;
 
     case GI_TYPE_TAG_GHASH:
       if (get_mode)
-	marshal_2lua_hash (L, *ti, GI_DIRECTION_OUT, transfer, data);
+	marshal_2lua_hash (L, *ti, GI_DIRECTION_OUT, transfer, data, 0);
       else
 	nret = marshal_2c_hash (L, *ti, (GHashTable **) &data, 3, FALSE,
 				transfer);
@@ -1910,6 +2436,498 @@ marshal_closure_set_marshal (lua_State *L)
   return 0;
 }
 
+/* Kinds of values handled by native signal closures. */
+typedef enum _SignalValueKind
+  {
+    SIGNAL_VALUE_NONE,
+    SIGNAL_VALUE_SCALAR,
+    SIGNAL_VALUE_ENUM,
+    SIGNAL_VALUE_STRING,
+    SIGNAL_VALUE_OBJECT,
+    SIGNAL_VALUE_BOXED,
+    SIGNAL_VALUE_POINTER
+  } SignalValueKind;
+
+/* Compiled marshalling plan of single value of the signal. */
+typedef struct _SignalValue
+{
+  /* Type of the GValue holding the value. */
+  GType gtype;
+
+  /* Kind of the value, one of SignalValueKind. */
+  guint kind : 3;
+
+  /* Type tag for SIGNAL_VALUE_SCALAR kinds. */
+  guint tag : 5;
+} SignalValue;
+
+/* Marshalling plan of the signal, compiled from GISignalInfo.  Kept
+   in the signal plan cache, indexed by the signal id. */
+typedef struct _SignalPlan
+{
+  /* Return value. */
+  SignalValue ret;
+
+  /* Number of parameters, including the instance. */
+  guint n_params;
+
+  /* Variable-length array of parameters. */
+  SignalValue params[1];
+} SignalPlan;
+
+/* lightuserdata key to the cache of compiled signal plans. */
+static int signal_plan_cache;
+
+/* GClosure invoking Lua target directly with compiled signal plan. */
+typedef struct _SignalClosure
+{
+  GClosure closure;
+
+  /* Thread in which the target is invoked, with its reference and
+     the lock of the state. */
+  lua_State *L;
+  int thread_ref;
+  gpointer state_lock;
+
+  /* References to invoked target and to the plan userdata. */
+  int target_ref;
+  int plan_ref;
+  SignalPlan *plan;
+} SignalClosure;
+
+/* Compiles single value of the signal.  Returns FALSE if the value
+   cannot be marshalled natively and generic marshalling has to be
+   used instead. */
+static gboolean
+signal_value_compile (lua_State *L, SignalValue *value, GType gtype,
+		      GITypeInfo *ti, gboolean is_return)
+{
+  GITypeTag tag = ti ? g_type_info_get_tag (ti) : GI_TYPE_TAG_INTERFACE;
+  if (tag == GI_TYPE_TAG_ARRAY || tag == GI_TYPE_TAG_GLIST
+      || tag == GI_TYPE_TAG_GSLIST || tag == GI_TYPE_TAG_GHASH
+      || tag == GI_TYPE_TAG_ERROR || tag == GI_TYPE_TAG_GTYPE)
+    return FALSE;
+
+  value->gtype = gtype;
+  value->kind = SIGNAL_VALUE_SCALAR;
+  switch (G_TYPE_FUNDAMENTAL (gtype))
+    {
+    case G_TYPE_NONE:
+      value->kind = SIGNAL_VALUE_NONE;
+      return is_return;
+
+#define HANDLE_SCALAR(fundamental, stag)	\
+      case G_TYPE_ ## fundamental:		\
+	value->tag = GI_TYPE_TAG_ ## stag;	\
+	return TRUE;
+
+      HANDLE_SCALAR (BOOLEAN, BOOLEAN)
+      HANDLE_SCALAR (CHAR, INT8)
+      HANDLE_SCALAR (UCHAR, UINT8)
+      HANDLE_SCALAR (INT, INT32)
+      HANDLE_SCALAR (UINT, UINT32)
+      HANDLE_SCALAR (LONG, INT64)
+      HANDLE_SCALAR (ULONG, UINT64)
+      HANDLE_SCALAR (INT64, INT64)
+      HANDLE_SCALAR (UINT64, UINT64)
+      HANDLE_SCALAR (FLOAT, FLOAT)
+      HANDLE_SCALAR (DOUBLE, DOUBLE)
+#undef HANDLE_SCALAR
+
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+      value->kind = SIGNAL_VALUE_ENUM;
+      return TRUE;
+
+    case G_TYPE_STRING:
+      value->kind = SIGNAL_VALUE_STRING;
+      return TRUE;
+
+    case G_TYPE_OBJECT:
+    case G_TYPE_INTERFACE:
+      value->kind = SIGNAL_VALUE_OBJECT;
+      return TRUE;
+
+    case G_TYPE_PARAM:
+      value->kind = SIGNAL_VALUE_OBJECT;
+      return !is_return;
+
+    case G_TYPE_BOXED:
+      {
+	/* Only boxed types with known repotype are handled. */
+	gboolean known;
+	if (is_return || gtype == G_TYPE_STRV)
+	  return FALSE;
+	lgi_type_get_repotype (L, gtype, NULL);
+	known = !lua_isnil (L, -1);
+	lua_pop (L, 1);
+	value->kind = SIGNAL_VALUE_BOXED;
+	return known;
+      }
+
+    case G_TYPE_POINTER:
+      value->kind = SIGNAL_VALUE_POINTER;
+      return !is_return && gtype == G_TYPE_POINTER;
+
+    default:
+      return FALSE;
+    }
+}
+
+/* Compiles plan for given GISignalInfo and pushes it to the stack.
+   Pushes false if the signal cannot be marshalled natively. */
+static void
+signal_plan_compile (lua_State *L, GISignalInfo *info, guint signal_id)
+{
+  GSignalQuery query;
+  SignalPlan *plan;
+  GITypeInfo *ti;
+  GIArgInfo *ai;
+  gboolean ok;
+  guint i;
+
+  g_signal_query (signal_id, &query);
+  if (query.signal_id == 0
+      || query.n_params != (guint) g_callable_info_get_n_args (info))
+    {
+      lua_pushboolean (L, 0);
+      return;
+    }
+
+  plan = lua_newuserdata (L, G_STRUCT_OFFSET (SignalPlan, params)
+			  + (query.n_params + 1) * sizeof (SignalValue));
+  plan->n_params = query.n_params + 1;
+
+  /* Instance and return value. */
+  ok = signal_value_compile (L, &plan->params[0], query.itype, NULL, FALSE);
+  if (ok)
+    {
+      ti = g_callable_info_get_return_type (info);
+      ok = signal_value_compile (L, &plan->ret, query.return_type
+				 & ~G_SIGNAL_TYPE_STATIC_SCOPE, ti, TRUE);
+      g_base_info_unref (ti);
+    }
+
+  /* Arguments. */
+  for (i = 0; ok && i < query.n_params; i++)
+    {
+      ai = g_callable_info_get_arg (info, i);
+      ti = g_arg_info_get_type (ai);
+      ok = g_arg_info_get_direction (ai) == GI_DIRECTION_IN
+	&& signal_value_compile (L, &plan->params[i + 1],
+				 query.param_types[i]
+				 & ~G_SIGNAL_TYPE_STATIC_SCOPE, ti, FALSE);
+      g_base_info_unref (ti);
+      g_base_info_unref (ai);
+    }
+
+  if (!ok)
+    {
+      lua_pop (L, 1);
+      lua_pushboolean (L, 0);
+    }
+}
+
+/* Pushes value of the GValue to the stack according to the plan. */
+static void
+signal_value_2lua (lua_State *L, SignalValue *plan, const GValue *value)
+{
+  GIArgument arg;
+  switch (plan->kind)
+    {
+    case SIGNAL_VALUE_SCALAR:
+      switch (G_TYPE_FUNDAMENTAL (plan->gtype))
+	{
+	case G_TYPE_BOOLEAN: arg.v_boolean = g_value_get_boolean (value); break;
+	case G_TYPE_CHAR: arg.v_int8 = g_value_get_schar (value); break;
+	case G_TYPE_UCHAR: arg.v_uint8 = g_value_get_uchar (value); break;
+	case G_TYPE_INT: arg.v_int32 = g_value_get_int (value); break;
+	case G_TYPE_UINT: arg.v_uint32 = g_value_get_uint (value); break;
+	case G_TYPE_LONG: arg.v_int64 = g_value_get_long (value); break;
+	case G_TYPE_ULONG: arg.v_uint64 = g_value_get_ulong (value); break;
+	case G_TYPE_INT64: arg.v_int64 = g_value_get_int64 (value); break;
+	case G_TYPE_UINT64: arg.v_uint64 = g_value_get_uint64 (value); break;
+	case G_TYPE_FLOAT: arg.v_float = g_value_get_float (value); break;
+	case G_TYPE_DOUBLE: arg.v_double = g_value_get_double (value); break;
+	default: g_assert_not_reached ();
+	}
+      lgi_marshal_2lua_scalar (L, plan->tag, &arg, 0);
+      break;
+
+    case SIGNAL_VALUE_ENUM:
+      /* Convert to symbolic form using the repotype, if available. */
+      lgi_type_get_repotype (L, G_VALUE_TYPE (value), NULL);
+      if (G_TYPE_FUNDAMENTAL (plan->gtype) == G_TYPE_ENUM)
+	lua_pushinteger (L, g_value_get_enum (value));
+      else
+	lua_pushinteger (L, g_value_get_flags (value));
+      if (!lua_isnil (L, -2))
+	lua_gettable (L, -2);
+      lua_replace (L, -2);
+      break;
+
+    case SIGNAL_VALUE_STRING:
+      lua_pushstring (L, g_value_get_string (value));
+      break;
+
+    case SIGNAL_VALUE_OBJECT:
+      lgi_object_2lua (L, g_value_peek_pointer (value), FALSE, FALSE);
+      break;
+
+    case SIGNAL_VALUE_BOXED:
+      lgi_type_get_repotype (L, G_VALUE_TYPE (value), NULL);
+      lgi_record_2lua (L, g_value_get_boxed (value), FALSE, 0);
+      break;
+
+    case SIGNAL_VALUE_POINTER:
+      lua_pushlightuserdata (L, g_value_get_pointer (value));
+      break;
+
+    default:
+      lua_pushnil (L);
+    }
+}
+
+/* Stores Lua value at narg into the GValue according to the plan. */
+static void
+signal_value_2c (lua_State *L, SignalValue *plan, GValue *value, int narg)
+{
+  GIArgument arg;
+  lgi_makeabs (L, narg);
+  switch (plan->kind)
+    {
+    case SIGNAL_VALUE_SCALAR:
+      lgi_marshal_2c_scalar (L, plan->tag, &arg, narg, FALSE, 0);
+      switch (G_TYPE_FUNDAMENTAL (plan->gtype))
+	{
+	case G_TYPE_BOOLEAN: g_value_set_boolean (value, arg.v_boolean); break;
+	case G_TYPE_CHAR: g_value_set_schar (value, arg.v_int8); break;
+	case G_TYPE_UCHAR: g_value_set_uchar (value, arg.v_uint8); break;
+	case G_TYPE_INT: g_value_set_int (value, arg.v_int32); break;
+	case G_TYPE_UINT: g_value_set_uint (value, arg.v_uint32); break;
+	case G_TYPE_LONG: g_value_set_long (value, arg.v_int64); break;
+	case G_TYPE_ULONG: g_value_set_ulong (value, arg.v_uint64); break;
+	case G_TYPE_INT64: g_value_set_int64 (value, arg.v_int64); break;
+	case G_TYPE_UINT64: g_value_set_uint64 (value, arg.v_uint64); break;
+	case G_TYPE_FLOAT: g_value_set_float (value, arg.v_float); break;
+	case G_TYPE_DOUBLE: g_value_set_double (value, arg.v_double); break;
+	default: g_assert_not_reached ();
+	}
+      break;
+
+    case SIGNAL_VALUE_ENUM:
+      {
+	lua_Integer val;
+	if (lua_type (L, narg) == LUA_TNUMBER)
+	  val = lua_tointeger (L, narg);
+	else
+	  {
+	    /* Convert symbolic value using the repotype. */
+	    lgi_type_get_repotype (L, G_VALUE_TYPE (value), NULL);
+	    lua_pushvalue (L, narg);
+	    lua_call (L, 1, 1);
+	    val = luaL_checkinteger (L, -1);
+	    lua_pop (L, 1);
+	  }
+	if (G_TYPE_FUNDAMENTAL (plan->gtype) == G_TYPE_ENUM)
+	  g_value_set_enum (value, val);
+	else
+	  g_value_set_flags (value, val);
+	break;
+      }
+
+    case SIGNAL_VALUE_STRING:
+      g_value_set_string (value, lua_tostring (L, narg));
+      break;
+
+    case SIGNAL_VALUE_OBJECT:
+      g_value_set_object (value, lgi_object_2c (L, narg, G_VALUE_TYPE (value),
+						TRUE, FALSE, FALSE));
+      break;
+
+    default:
+      break;
+    }
+}
+
+/* Protected part of the signal closure invocation.  Lua prototype:
+   signal_closure_call(closure, retval, n_params, params) */
+static int
+signal_closure_call (lua_State *L)
+{
+  SignalClosure *sc = lua_touserdata (L, 1);
+  GValue *retval = lua_touserdata (L, 2);
+  guint i, n_params = lua_tointeger (L, 3);
+  const GValue *params = lua_touserdata (L, 4);
+  SignalPlan *plan = sc->plan;
+  gboolean has_ret = (retval != NULL && G_IS_VALUE (retval)
+		      && plan->ret.kind != SIGNAL_VALUE_NONE);
+
+  if (n_params > plan->n_params)
+    n_params = plan->n_params;
+  luaL_checkstack (L, n_params + 1, "");
+  lua_rawgeti (L, LUA_REGISTRYINDEX, sc->target_ref);
+  for (i = 0; i < n_params; i++)
+    signal_value_2lua (L, &plan->params[i], &params[i]);
+  lua_call (L, n_params, has_ret ? 1 : 0);
+  if (has_ret)
+    signal_value_2c (L, &plan->ret, retval, -1);
+  return 0;
+}
+
+static void
+signal_closure_marshal (GClosure *closure, GValue *retval, guint n_params,
+			const GValue *params, gpointer invocation_hint,
+			gpointer marshal_data)
+{
+  SignalClosure *sc = (SignalClosure *) closure;
+  lua_State *L;
+  int top;
+  (void) invocation_hint;
+  (void) marshal_data;
+
+  /* Get access to proper Lua context. */
+  lgi_state_enter (sc->state_lock);
+  lua_rawgeti (sc->L, LUA_REGISTRYINDEX, sc->thread_ref);
+  L = lua_tothread (sc->L, -1);
+  lua_pop (sc->L, 1);
+  if (lua_status (L) != 0)
+    {
+      /* Thread is suspended, switch the closure to the new one, see
+	 closure_callback() in callable.c for details. */
+      lua_State *newL = lua_newthread (L);
+      lua_rawseti (L, LUA_REGISTRYINDEX, sc->thread_ref);
+      L = newL;
+    }
+  sc->L = L;
+
+  /* Invoke the target in protected mode, so that errors are not
+     propagated through C code emitting the signal. */
+  top = lua_gettop (L);
+  lua_pushcfunction (L, signal_closure_call);
+  lua_pushlightuserdata (L, sc);
+  lua_pushlightuserdata (L, retval);
+  lua_pushinteger (L, n_params);
+  lua_pushlightuserdata (L, (gpointer) params);
+  if (lua_pcall (L, 4, 0, 0) != 0)
+    g_warning ("Error raised while calling signal handler: %s",
+	       lua_tostring (L, -1));
+  lua_settop (L, top);
+  lgi_state_leave (sc->state_lock);
+}
+
+static void
+signal_closure_finalize (gpointer user_data, GClosure *closure)
+{
+  SignalClosure *sc = (SignalClosure *) closure;
+  (void) user_data;
+  lgi_state_enter (sc->state_lock);
+  luaL_unref (sc->L, LUA_REGISTRYINDEX, sc->target_ref);
+  luaL_unref (sc->L, LUA_REGISTRYINDEX, sc->plan_ref);
+  luaL_unref (sc->L, LUA_REGISTRYINDEX, sc->thread_ref);
+  lgi_state_leave (sc->state_lock);
+}
+
+/* Creates GClosure for given signal, invoking target with natively
+   marshalled arguments.  Returns nil if the signal cannot be
+   marshalled natively.  Lua prototype:
+   closure = marshal.signal_closure(target, signal_info) */
+static int
+marshal_signal_closure (lua_State *L)
+{
+  GIBaseInfo **info = lgi_udata_test (L, 2, LGI_GI_INFO);
+  GIBaseInfo *container;
+  SignalClosure *sc;
+  GType gtype;
+  guint signal_id;
+
+  /* Find out the signal id. */
+  if (info == NULL || !GI_IS_SIGNAL_INFO (*info))
+    return 0;
+  container = g_base_info_get_container (*info);
+  if (container == NULL || !GI_IS_REGISTERED_TYPE_INFO (container))
+    return 0;
+  gtype = g_registered_type_info_get_g_type (container);
+  if (gtype == G_TYPE_INVALID || gtype == G_TYPE_NONE)
+    return 0;
+  signal_id = g_signal_lookup (g_base_info_get_name (*info), gtype);
+  if (signal_id == 0)
+    return 0;
+
+  /* Get the plan from the cache or compile it. */
+  lua_pushlightuserdata (L, &signal_plan_cache);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_pushinteger (L, signal_id);
+  lua_rawget (L, -2);
+  if (lua_isnil (L, -1))
+    {
+      lua_pop (L, 1);
+      signal_plan_compile (L, *info, signal_id);
+      lua_pushinteger (L, signal_id);
+      lua_pushvalue (L, -2);
+      lua_rawset (L, -4);
+    }
+  if (!lua_toboolean (L, -1))
+    return 0;
+
+  /* Create the closure. */
+  sc = (SignalClosure *) g_closure_new_simple (sizeof (SignalClosure), NULL);
+  sc->plan = lua_touserdata (L, -1);
+  sc->plan_ref = luaL_ref (L, LUA_REGISTRYINDEX);
+  lua_pushvalue (L, 1);
+  sc->target_ref = luaL_ref (L, LUA_REGISTRYINDEX);
+  sc->L = L;
+  lua_pushthread (L);
+  sc->thread_ref = luaL_ref (L, LUA_REGISTRYINDEX);
+  sc->state_lock = lgi_state_get_lock (L);
+  g_closure_set_marshal (&sc->closure, signal_closure_marshal);
+  g_closure_add_finalize_notifier (&sc->closure, NULL,
+				   signal_closure_finalize);
+  g_closure_ref (&sc->closure);
+  g_closure_sink (&sc->closure);
+
+  /* Wrap it into GObject.Closure record. */
+  lgi_type_get_repotype (L, G_TYPE_CLOSURE, NULL);
+  lgi_record_2lua (L, &sc->closure, TRUE, 0);
+  return 1;
+}
+
+/* Compiles field info into compact descriptor for lgi_marshal_field,
+   if the field is scalar, otherwise returns the field info itself.
+   descriptor = marshal.field(fieldinfo) */
+static int
+marshal_field (lua_State *L)
+{
+  GIFieldInfo **fi = luaL_checkudata (L, 1, LGI_GI_INFO);
+  GITypeInfo *ti;
+  GITypeTag tag;
+  gboolean scalar;
+
+  luaL_argcheck (L, GI_IS_FIELD_INFO (*fi), 1, "field info expected");
+  ti = g_field_info_get_type (*fi);
+  tag = g_type_info_get_tag (ti);
+  scalar = lgi_marshal_tag_is_scalar (tag) && !g_type_info_is_pointer (ti);
+  g_base_info_unref (ti);
+  if (!scalar)
+    {
+      lua_pushvalue (L, 1);
+      return 1;
+    }
+
+  lua_createtable (L, 5, 0);
+  lua_pushinteger (L, g_field_info_get_offset (*fi));
+  lua_rawseti (L, -2, 1);
+  lua_pushinteger (L, FIELD_KIND_SCALAR);
+  lua_rawseti (L, -2, 2);
+  lua_pushinteger (L, tag);
+  lua_rawseti (L, -2, 3);
+  lua_pushinteger (L, g_field_info_get_flags (*fi));
+  lua_rawseti (L, -2, 4);
+  lua_pushstring (L, g_base_info_get_name (*fi));
+  lua_rawseti (L, -2, 5);
+  return 1;
+}
+
 /* Calculates size and alignment of specified type.
    size, align = marshal.typeinfo(tiinfo) */
 static int
@@ -1960,7 +2978,10 @@ static const struct luaL_Reg marshal_api_reg[] = {
   { "callback", marshal_callback },
   { "closure_set_marshal", marshal_closure_set_marshal },
   { "closure_invoke", marshal_closure_invoke },
+  { "signal_closure", marshal_signal_closure },
   { "typeinfo", marshal_typeinfo },
+  { "field", marshal_field },
+  { "pairs", lazy_pairs },
   { NULL, NULL }
 };
 
@@ -1971,4 +2992,12 @@ lgi_marshal_init (lua_State *L)
   lua_newtable (L);
   luaL_register (L, NULL, marshal_api_reg);
   lua_setfield (L, -2, "marshal");
+
+  /* Create cache of compiled signal plans. */
+  lgi_cache_create (L, &signal_plan_cache, NULL);
+
+  /* Register metatable of lazy container proxies. */
+  luaL_newmetatable (L, UD_LAZY_CONTAINER);
+  luaL_register (L, NULL, lazy_mt_reg);
+  lua_pop (L, 1);
 }
@@ -0,0 +1,158 @@
+------------------------------------------------------------------------------
+--
+--  lgi Persistent cache of category name maps
+--
+--  Copyright (c) 2026 lgi contributors
+--  Licensed under the MIT license:
+--  http://www.opensource.org/licenses/mit-license.php
+--
+------------------------------------------------------------------------------
+
+local pairs, pcall, setmetatable, getmetatable, tostring, newproxy
+   = pairs, pcall, setmetatable, getmetatable, tostring,
+   rawget(_G, 'newproxy')
+
+local io = require 'io'
+local os = require 'os'
+local math = require 'math'
+local table = require 'table'
+local package = require 'package'
+local core = require 'lgi.core'
+
+-- The cache stores ordered lists of element names of categories
+-- (e.g. methods of a class), so that component.get_category can map
+-- names to indices without instantiating every child info.  One file
+-- is kept per namespace in the directory specified by LGI_NAMECACHE_DIR
+-- environment variable; caching is disabled when it is not set.  Each
+-- file starts with a stamp line, which covers lgi version, typelib
+-- file and the override of the namespace.  If the stamp does not
+-- match, the file is ignored and rewritten.  Every following line
+-- contains category key and tab-separated list of element names.
+local namecache = { dir = os.getenv('LGI_NAMECACHE_DIR') }
+
+local header = 'lgi-namecache 1 '
+
+-- Loaded caches, indexed by namespace name; false when the namespace
+-- cannot be cached.
+local caches = {}
+
+-- Computes stamp of the specified namespace, or nil if the namespace
+-- is not backed by typelib file.
+local function stamp(ns)
+   local gi_ns = core.gi[ns]
+   local typelib = gi_ns and gi_ns.typelib_path
+   typelib = typelib and core.gi.stamp(typelib)
+   if not typelib then return nil end
+   local override = package.searchpath
+      and package.searchpath('lgi.override.' .. ns, package.path)
+   override = override and core.gi.stamp(override) or 'none'
+   return table.concat({ require 'lgi.version', typelib, override }, '|'),
+   gi_ns.version
+end
+
+-- Loads cache of given namespace.  Only raw lines are read, lists of
+-- names are split from them when the category is requested.
+local function load(ns)
+   local ns_stamp, version = stamp(ns)
+   if not ns_stamp then return false end
+   local cache = {
+      file = namecache.dir .. '/' .. ns .. '-' .. version .. '.namecache',
+      stamp = ns_stamp, lines = {}, names = {}, dirty = false,
+   }
+   local f = io.open(cache.file, 'rb')
+   if f then
+      if f:read('*l') == header .. ns_stamp then
+	 for line in f:lines() do
+	    local key, names = line:match('^([^\t]+)\t(.*)$')
+	    if key then cache.lines[key] = names end
+	 end
+      end
+      f:close()
+   end
+   return cache
+end
+
+-- Writes single cache into its file.  The file is first written under
+-- name unique to this state, so that concurrent writers do not
+-- interleave, and then renamed over the cache; if renaming fails, the
+-- existing cache is kept.
+local function save(cache)
+   local tmp = ('%s.%s%s%d.tmp'):format(
+      cache.file, tostring(cache):match('(%x+)$') or '',
+      os.time(), math.random(0, 0x7fffffff))
+   local f = io.open(tmp, 'wb')
+   if not f then return end
+   f:write(header, cache.stamp, '\n')
+   for key, names in pairs(cache.lines) do
+      f:write(key, '\t', names, '\n')
+   end
+   f:close()
+   if not os.rename(tmp, cache.file) then os.remove(tmp) end
+   cache.dirty = false
+end
+
+-- Writes all modified caches to the disk.
+function namecache.flush()
+   for _, cache in pairs(caches) do
+      if cache and cache.dirty then pcall(save, cache) end
+   end
+end
+
+-- Returns array of names of all elements of 'children', key is
+-- 'Namespace.Type:category' string identifying the category.  Returns
+-- nil if caching is disabled.
+function namecache.names(key, children)
+   if not namecache.dir then return nil end
+   local ns, entry = key:match('^([^.]+)%.(.+)$')
+   local cache = caches[ns]
+   if cache == nil then
+      cache = load(ns)
+      caches[ns] = cache
+   end
+   if not cache then return nil end
+
+   -- Check already materialized lists.
+   local names = cache.names[entry]
+   if names then return names end
+
+   -- Split the list from the loaded line, verify that it is still
+   -- consistent with the typelib.
+   local count, line = #children, cache.lines[entry]
+   if line then
+      names = {}
+      for name in line:gmatch('[^\t]+') do names[#names + 1] = name end
+      if #names ~= count then names = nil end
+   end
+
+   -- Build the list from the infos and schedule the cache for saving.
+   if not names then
+      names = {}
+      for i = 1, count do names[i] = children[i].name end
+      cache.lines[entry] = table.concat(names, '\t')
+      cache.dirty = true
+   end
+   cache.names[entry] = names
+   return names
+end
+
+-- Drops list of names of given category, e.g. when it was found
+-- inconsistent with the typelib; it is rebuilt on the next request.
+function namecache.invalidate(key)
+   local ns, entry = key:match('^([^.]+)%.(.+)$')
+   local cache = caches[ns]
+   if cache then
+      cache.lines[entry] = nil
+      cache.names[entry] = nil
+      cache.dirty = true
+   end
+end
+
+-- Flush caches when the module (i.e. the Lua state) is collected.
+if newproxy then
+   namecache._sentinel = newproxy(true)
+   getmetatable(namecache._sentinel).__gc = namecache.flush
+else
+   namecache._sentinel = setmetatable({}, { __gc = namecache.flush })
+end
+
+return namecache
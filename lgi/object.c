@@ -15,6 +15,42 @@
    cache of known objects. */
 static int cache;
 
+/* lightuserdata key to registry, containing ObjectProxies userdata.
+   Its env table is weak table of proxies of GObject instances indexed
+   by integer references, reference of the proxy is stored directly in
+   the GObject's qdata, so that lookup does not need the cache. */
+static int proxies;
+
+/* lightuserdata key to registry, containing table which maps
+   lightuserdata(gtype) -> ObjectTypeFuncs userdata for non-GObject
+   fundamental types. */
+static int type_funcs;
+
+/* Resolved ref and unref functions of single non-GObject type. */
+typedef struct _ObjectTypeFuncs
+{
+  gpointer (*ref) (gpointer);
+  void (*unref) (gpointer);
+} ObjectTypeFuncs;
+
+/* lightuserdata key to registry, containing table which maps
+   lightuserdata(gtype) -> table of ObjectProperty userdata (or false
+   for properties which are not handled natively) indexed by property
+   name. */
+static int properties;
+
+/* lightuserdata key to registry for metatable of ObjectProperty. */
+static int property_mt;
+
+/* Resolved property of fundamental type, which can be marshalled
+   directly between Lua and stack-allocated GValue. */
+typedef struct _ObjectProperty
+{
+  GParamSpec *pspec;
+  GType fundamental;
+  GITypeTag tag;
+} ObjectProperty;
+
 /* lightuserdata key to registry for metatable of objects. */
 static int object_mt;
 
@@ -37,6 +73,25 @@ typedef struct _ObjectData
   lua_State *L;
 } ObjectData;
 
+/* Per-state bookkeeping of proxy references.  Freed slots of the
+   proxies table form a linked list starting at 'free', containing
+   index of the next free slot. */
+typedef struct _ObjectProxies
+{
+  GQuark quark;
+  int free;
+  int top;
+} ObjectProxies;
+
+/* Proxy userdata; object pointer has to be the first member.  'ref'
+   is index in the proxies table, 0 when the proxy is stored in the
+   cache instead. */
+typedef struct _ObjectProxy
+{
+  gpointer object;
+  int ref;
+} ObjectProxy;
+
 /* lightuserdata key to registry, containing metatable for object env
    guard. */
 static int env_mt;
@@ -171,11 +226,63 @@ object_load_function (lua_State *L, GType gtype, const gchar *name)
   return func;
 }
 
+/* Retrieves ref/unref functions of given non-GObject type, resolving
+   them on the first request.  Fundamental ref/unref functions from
+   the typelib take precedence, custom _refsink and _unref methods of
+   the typetable are used as the fallback. */
+static ObjectTypeFuncs *
+object_type_funcs (lua_State *L, GType gtype)
+{
+  ObjectTypeFuncs *funcs;
+  GIObjectInfo *info;
+
+  luaL_checkstack (L, 4, "");
+  lua_pushlightuserdata (L, &type_funcs);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_pushlightuserdata (L, (gpointer) gtype);
+  lua_rawget (L, -2);
+  funcs = lua_touserdata (L, -1);
+  if (funcs != NULL)
+    {
+      lua_pop (L, 2);
+      return funcs;
+    }
+
+  /* Resolve and remember functions for the type. */
+  lua_pop (L, 1);
+  lua_pushlightuserdata (L, (gpointer) gtype);
+  funcs = lua_newuserdata (L, sizeof (ObjectTypeFuncs));
+  funcs->ref = NULL;
+  funcs->unref = NULL;
+  info = g_irepository_find_by_gtype (NULL, gtype);
+  if (info == NULL)
+    info = g_irepository_find_by_gtype (NULL, G_TYPE_FUNDAMENTAL (gtype));
+  if (info != NULL)
+    {
+      if (g_object_info_get_fundamental (info))
+	{
+	  funcs->ref = lgi_object_get_function_ptr
+	    (info, g_object_info_get_ref_function);
+	  funcs->unref = lgi_object_get_function_ptr
+	    (info, g_object_info_get_unref_function);
+	}
+      g_base_info_unref (info);
+    }
+  if (funcs->ref == NULL)
+    funcs->ref = object_load_function (L, gtype, "_refsink");
+  if (funcs->unref == NULL)
+    funcs->unref = object_load_function (L, gtype, "_unref");
+  lua_rawset (L, -3);
+  lua_pop (L, 1);
+  return funcs;
+}
+
 /* Adds one reference to the object, returns TRUE if succeded. */
 static gboolean
 object_refsink (lua_State *L, gpointer obj, gboolean no_sink)
 {
   GType gtype = G_TYPE_FROM_INSTANCE (obj);
+  ObjectTypeFuncs *funcs;
   if (G_TYPE_IS_OBJECT (gtype))
     {
       if (G_UNLIKELY (no_sink))
@@ -185,29 +292,12 @@ object_refsink (lua_State *L, gpointer obj, gboolean no_sink)
       return TRUE;
     }
 
-  /* Check whether object has registered fundamental 'ref'
-     function. */
-  GIObjectInfo *info = g_irepository_find_by_gtype (NULL, gtype);
-  if (info == NULL)
-    info = g_irepository_find_by_gtype (NULL, G_TYPE_FUNDAMENTAL (gtype));
-  if (info != NULL && g_object_info_get_fundamental (info))
-    {
-      GIObjectInfoRefFunction ref =
-	lgi_object_get_function_ptr (info, g_object_info_get_ref_function);
-      g_base_info_unref (info);
-      if (ref != NULL)
-	{
-	  ref (obj);
-	  return TRUE;
-	}
-    }
-
-  /* Finally check custom _refsink method in typetable. */
-  gpointer (*refsink_func)(gpointer) =
-    object_load_function (L, gtype, "_refsink");
-  if (refsink_func)
+  /* Use registered fundamental 'ref' function or custom _refsink
+     method in typetable. */
+  funcs = object_type_funcs (L, gtype);
+  if (funcs->ref != NULL)
     {
-      refsink_func (obj);
+      funcs->ref (obj);
       return TRUE;
     }
 
@@ -227,33 +317,19 @@ static void
 object_unref (lua_State *L, gpointer obj)
 {
   GType gtype = G_TYPE_FROM_INSTANCE (obj);
+  ObjectTypeFuncs *funcs;
   if (G_TYPE_IS_OBJECT (gtype))
     {
       g_object_unref (obj);
       return;
     }
 
-  /* Some other fundamental type, check, whether it has registered
-     custom unref method. */
-  GIObjectInfo *info = g_irepository_find_by_gtype (NULL, gtype);
-  if (info == NULL)
-    info = g_irepository_find_by_gtype (NULL, G_TYPE_FUNDAMENTAL (gtype));
-  if (info != NULL && g_object_info_get_fundamental (info))
+  /* Some other fundamental type, use its registered or custom unref
+     method. */
+  funcs = object_type_funcs (L, gtype);
+  if (funcs->unref != NULL)
     {
-      GIObjectInfoUnrefFunction unref =
-	lgi_object_get_function_ptr (info, g_object_info_get_unref_function);
-      g_base_info_unref (info);
-      if (unref != NULL)
-	{
-	  unref (obj);
-	  return;
-	}
-    }
-
-  void (*unref_func)(gpointer) = object_load_function (L, gtype, "_unref");
-  if (unref_func)
-    {
-      unref_func (obj);
+      funcs->unref (obj);
       return;
     }
 
@@ -262,10 +338,47 @@ object_unref (lua_State *L, gpointer obj)
 #endif
 }
 
+/* Pushes proxies table to the stack and returns its bookkeeping. */
+static ObjectProxies *
+object_proxies (lua_State *L)
+{
+  ObjectProxies *p;
+  lua_pushlightuserdata (L, &proxies);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  p = lua_touserdata (L, -1);
+  lua_getfenv (L, -1);
+  lua_replace (L, -2);
+  return p;
+}
+
+/* Detaches the proxy from its object's qdata and releases its slot
+   in the proxies table. */
+static void
+object_proxy_release (lua_State *L, ObjectProxy *proxy)
+{
+  ObjectProxies *p = object_proxies (L);
+
+  /* The object might already be represented by newer proxy, created
+     while this one was waiting for finalization. */
+  if (g_object_get_qdata (proxy->object, p->quark)
+      == GINT_TO_POINTER (proxy->ref))
+    g_object_set_qdata (proxy->object, p->quark, NULL);
+
+  lua_pushinteger (L, p->free);
+  lua_rawseti (L, -2, proxy->ref);
+  p->free = proxy->ref;
+  proxy->ref = 0;
+  lua_pop (L, 1);
+}
+
 static int
 object_gc (lua_State *L)
 {
-  object_unref (L, object_get (L, 1));
+  gpointer obj = object_get (L, 1);
+  ObjectProxy *proxy = lua_touserdata (L, 1);
+  if (proxy->ref != 0)
+    object_proxy_release (L, proxy);
+  object_unref (L, obj);
 
   /* Unset the metatable / make the object unusable */
   lua_pushnil (L);
@@ -320,6 +433,22 @@ lgi_object_2c (lua_State *L, int narg, GType gtype, gboolean optional,
   return obj;
 }
 
+/* Creates new proxy userdata for the object and pushes it to the
+   stack. */
+static ObjectProxy *
+object_proxy_new (lua_State *L, gpointer obj)
+{
+  ObjectProxy *proxy = lua_newuserdata (L, sizeof (ObjectProxy));
+  proxy->object = obj;
+  proxy->ref = 0;
+  lua_pushlightuserdata (L, &object_mt);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_setmetatable (L, -2);
+  object_type (L, G_TYPE_FROM_INSTANCE (obj));
+  lua_setfenv (L, -2);
+  return proxy;
+}
+
 int
 lgi_object_2lua (lua_State *L, gpointer obj, gboolean own, gboolean no_sink)
 {
@@ -330,42 +459,78 @@ lgi_object_2lua (lua_State *L, gpointer obj, gboolean own, gboolean no_sink)
       return 1;
     }
 
-  /* Check, whether the object is already created (in the cache). */
   luaL_checkstack (L, 6, "");
-  lua_pushlightuserdata (L, &cache);
-  lua_rawget (L, LUA_REGISTRYINDEX);
-  lua_pushlightuserdata (L, obj);
-  lua_rawget (L, -2);
-  if (!lua_isnil (L, -1))
+  if (G_IS_OBJECT (obj))
     {
-      /* Use the object from the cache. */
-      lua_replace (L, -2);
+      /* GObject instances know their proxy reference from qdata. */
+      ObjectProxies *p = object_proxies (L);
+      ObjectProxy *proxy;
+      int ref = GPOINTER_TO_INT (g_object_get_qdata (obj, p->quark));
+      if (ref != 0)
+	{
+	  lua_rawgeti (L, -1, ref);
+	  if (lua_isuserdata (L, -1))
+	    {
+	      lua_replace (L, -2);
+	      if (own)
+		object_unref (L, obj);
+	      return 1;
+	    }
+	  lua_pop (L, 1);
+	}
 
-      /* If the object was already owned, remove one reference,
-	 because our proxy always keeps only one reference, which we
-	 already have. */
-      if (own)
-	object_unref (L, obj);
-      return 1;
-    }
+      /* Allocate slot for the new proxy, either from the freelist or
+	 from the top of the table. */
+      if (p->free != 0)
+	{
+	  ref = p->free;
+	  lua_rawgeti (L, -1, ref);
+	  p->free = lua_tointeger (L, -1);
+	  lua_pop (L, 1);
+	}
+      else
+	ref = ++p->top;
 
-  /* Create new userdata object. */
-  *(gpointer *) lua_newuserdata (L, sizeof (obj)) = obj;
-  lua_pushlightuserdata (L, &object_mt);
-  lua_rawget (L, LUA_REGISTRYINDEX);
-  lua_setmetatable (L, -2);
-  object_type (L, G_TYPE_FROM_INSTANCE (obj));
-  lua_setfenv (L, -2);
+      /* Create the proxy and store it into the slot. */
+      proxy = object_proxy_new (L, obj);
+      proxy->ref = ref;
+      lua_pushvalue (L, -1);
+      lua_rawseti (L, -3, ref);
+      lua_replace (L, -2);
+      g_object_set_qdata (obj, p->quark, GINT_TO_POINTER (ref));
+    }
+  else
+    {
+      /* Check, whether the object is already created (in the cache). */
+      lua_pushlightuserdata (L, &cache);
+      lua_rawget (L, LUA_REGISTRYINDEX);
+      lua_pushlightuserdata (L, obj);
+      lua_rawget (L, -2);
+      if (!lua_isnil (L, -1))
+	{
+	  /* Use the object from the cache. */
+	  lua_replace (L, -2);
+
+	  /* If the object was already owned, remove one reference,
+	     because our proxy always keeps only one reference, which we
+	     already have. */
+	  if (own)
+	    object_unref (L, obj);
+	  return 1;
+	}
 
+      /* Create new userdata object. */
+      object_proxy_new (L, obj);
 
-  /* Store newly created userdata proxy into cache. */
-  lua_pushlightuserdata (L, obj);
-  lua_pushvalue (L, -2);
-  lua_rawset (L, -5);
+      /* Store newly created userdata proxy into cache. */
+      lua_pushlightuserdata (L, obj);
+      lua_pushvalue (L, -2);
+      lua_rawset (L, -5);
 
-  /* Stack cleanup, remove unnecessary cache and nil under userdata. */
-  lua_replace (L, -3);
-  lua_pop (L, 1);
+      /* Stack cleanup, remove unnecessary cache and nil under userdata. */
+      lua_replace (L, -3);
+      lua_pop (L, 1);
+    }
 
   /* If we don't own the object, take its ownership (and also remove
      floating reference if there is any). */
@@ -401,14 +566,27 @@ static const luaL_Reg object_mt_reg[] = {
 static const char *const query_mode[] = { "addr", "repo", NULL };
 
 /* Queries for assorted instance properties. Lua-side prototype:
-   res = object.query(objectinstance, mode [, iface-gtype])
+   res = object.query(objectinstance, mode [, iface-gtype[, optional]])
    Supported mode strings are:
    'repo':  returns repotable for this instance.
-   'addr':  returns lightuserdata with pointer to the object. */
+   'addr':  returns lightuserdata with pointer to the object.  When
+	    iface-gtype is given, raises an error if the instance is not
+	    of this type; nil is then accepted only if optional is
+	    true. */
 static int
 object_query (lua_State *L)
 {
-  gpointer object = object_check (L, 1);
+  gpointer object;
+  if (!lua_isnoneornil (L, 3)
+      && luaL_checkoption (L, 2, query_mode[0], query_mode) == 0)
+    {
+      lua_pushlightuserdata (L, lgi_object_2c (L, 1, lgi_type_get_gtype (L, 3),
+					       lua_toboolean (L, 4),
+					       FALSE, FALSE));
+      return 1;
+    }
+
+  object = object_check (L, 1);
   if (object)
     {
       int mode = luaL_checkoption (L, 2, query_mode[0], query_mode);
@@ -578,12 +756,371 @@ object_new (lua_State *L)
     }
 }
 
+static int
+object_property_gc (lua_State *L)
+{
+  ObjectProperty *prop = lua_touserdata (L, 1);
+  g_param_spec_unref (prop->pspec);
+  return 0;
+}
+
+/* Maps fundamental type of the property to typetag used for its
+   marshalling, GI_TYPE_TAG_VOID if the type is not handled natively. */
+static GITypeTag
+object_property_tag (GType fundamental)
+{
+  switch (fundamental)
+    {
+    case G_TYPE_BOOLEAN: return GI_TYPE_TAG_BOOLEAN;
+    case G_TYPE_CHAR: return GI_TYPE_TAG_INT8;
+    case G_TYPE_UCHAR: return GI_TYPE_TAG_UINT8;
+    case G_TYPE_INT: return GI_TYPE_TAG_INT32;
+    case G_TYPE_UINT: return GI_TYPE_TAG_UINT32;
+    case G_TYPE_LONG:
+      return (sizeof (glong) == 8) ? GI_TYPE_TAG_INT64 : GI_TYPE_TAG_INT32;
+    case G_TYPE_ULONG:
+      return (sizeof (gulong) == 8) ? GI_TYPE_TAG_UINT64 : GI_TYPE_TAG_UINT32;
+    case G_TYPE_INT64: return GI_TYPE_TAG_INT64;
+    case G_TYPE_UINT64: return GI_TYPE_TAG_UINT64;
+    case G_TYPE_FLOAT: return GI_TYPE_TAG_FLOAT;
+    case G_TYPE_DOUBLE: return GI_TYPE_TAG_DOUBLE;
+    case G_TYPE_STRING: return GI_TYPE_TAG_UTF8;
+    default: return GI_TYPE_TAG_VOID;
+    }
+}
+
+/* Looks up ObjectProperty for given object and property name,
+   resolving it on the first request.  Returns NULL if the property
+   does not exist or is not of fundamental type. */
+static ObjectProperty *
+object_property_find (lua_State *L, GObject *obj, const char *name)
+{
+  ObjectProperty *prop = NULL;
+  GParamSpec *pspec;
+  GITypeTag tag;
+
+  luaL_checkstack (L, 5, "");
+  lua_pushlightuserdata (L, &properties);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_pushlightuserdata (L, (gpointer) G_OBJECT_TYPE (obj));
+  lua_rawget (L, -2);
+  if (lua_isnil (L, -1))
+    {
+      lua_pop (L, 1);
+      lua_newtable (L);
+      lua_pushlightuserdata (L, (gpointer) G_OBJECT_TYPE (obj));
+      lua_pushvalue (L, -2);
+      lua_rawset (L, -4);
+    }
+  lua_getfield (L, -1, name);
+  if (!lua_isnil (L, -1))
+    {
+      prop = lua_touserdata (L, -1);
+      lua_pop (L, 3);
+      return prop;
+    }
+
+  /* Resolve the property and remember the result, 'false' marks
+     properties which are left for the generic path. */
+  lua_pop (L, 1);
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (obj), name);
+  tag = pspec ? object_property_tag (G_TYPE_FUNDAMENTAL (pspec->value_type))
+    : GI_TYPE_TAG_VOID;
+  if (tag != GI_TYPE_TAG_VOID)
+    {
+      prop = lua_newuserdata (L, sizeof (ObjectProperty));
+      prop->pspec = g_param_spec_ref (pspec);
+      prop->fundamental = G_TYPE_FUNDAMENTAL (pspec->value_type);
+      prop->tag = tag;
+      lua_pushlightuserdata (L, &property_mt);
+      lua_rawget (L, LUA_REGISTRYINDEX);
+      lua_setmetatable (L, -2);
+    }
+  else
+    lua_pushboolean (L, FALSE);
+  lua_setfield (L, -2, name);
+  lua_pop (L, 2);
+  return prop;
+}
+
+/* Stores Lua value at narg into the initialized GValue. */
+static void
+object_property_2c (lua_State *L, ObjectProperty *prop, GValue *value,
+		    int narg)
+{
+  GIArgument arg;
+  if (prop->tag == GI_TYPE_TAG_UTF8)
+    {
+      g_value_set_string (value, lua_isnoneornil (L, narg)
+			  ? NULL : luaL_checkstring (L, narg));
+      return;
+    }
+
+  lgi_marshal_2c_scalar (L, prop->tag, &arg, narg, FALSE, 0);
+  switch (prop->fundamental)
+    {
+    case G_TYPE_BOOLEAN: g_value_set_boolean (value, arg.v_boolean); break;
+    case G_TYPE_CHAR: g_value_set_schar (value, arg.v_int8); break;
+    case G_TYPE_UCHAR: g_value_set_uchar (value, arg.v_uint8); break;
+    case G_TYPE_INT: g_value_set_int (value, arg.v_int32); break;
+    case G_TYPE_UINT: g_value_set_uint (value, arg.v_uint32); break;
+    case G_TYPE_LONG: g_value_set_long (value, arg.v_long); break;
+    case G_TYPE_ULONG: g_value_set_ulong (value, arg.v_ulong); break;
+    case G_TYPE_INT64: g_value_set_int64 (value, arg.v_int64); break;
+    case G_TYPE_UINT64: g_value_set_uint64 (value, arg.v_uint64); break;
+    case G_TYPE_FLOAT: g_value_set_float (value, arg.v_float); break;
+    case G_TYPE_DOUBLE: g_value_set_double (value, arg.v_double); break;
+    default: g_assert_not_reached ();
+    }
+}
+
+/* Pushes contents of the GValue to the Lua stack. */
+static void
+object_property_2lua (lua_State *L, ObjectProperty *prop, GValue *value)
+{
+  GIArgument arg;
+  switch (prop->fundamental)
+    {
+    case G_TYPE_STRING:
+      {
+	const gchar *str = g_value_get_string (value);
+	if (str != NULL)
+	  lua_pushstring (L, str);
+	else
+	  lua_pushnil (L);
+	return;
+      }
+
+    case G_TYPE_BOOLEAN: arg.v_boolean = g_value_get_boolean (value); break;
+    case G_TYPE_CHAR: arg.v_int8 = g_value_get_schar (value); break;
+    case G_TYPE_UCHAR: arg.v_uint8 = g_value_get_uchar (value); break;
+    case G_TYPE_INT: arg.v_int32 = g_value_get_int (value); break;
+    case G_TYPE_UINT: arg.v_uint32 = g_value_get_uint (value); break;
+    case G_TYPE_LONG: arg.v_long = g_value_get_long (value); break;
+    case G_TYPE_ULONG: arg.v_ulong = g_value_get_ulong (value); break;
+    case G_TYPE_INT64: arg.v_int64 = g_value_get_int64 (value); break;
+    case G_TYPE_UINT64: arg.v_uint64 = g_value_get_uint64 (value); break;
+    case G_TYPE_FLOAT: arg.v_float = g_value_get_float (value); break;
+    case G_TYPE_DOUBLE: arg.v_double = g_value_get_double (value); break;
+    default: g_assert_not_reached ();
+    }
+  lgi_marshal_2lua_scalar (L, prop->tag, &arg, 0);
+}
+
+/* Native accessor of properties of fundamental types.  Lua-side
+   prototypes:
+   handled, value = object.property(objectinstance, name)
+   handled = object.property(objectinstance, name, newvalue)
+   Returns false when the property should be handled by the generic
+   GObject.Value based path, i.e. when it is not of fundamental type or
+   when it cannot be accessed in requested mode. */
+static int
+object_property (lua_State *L)
+{
+  gboolean getmode = lua_isnone (L, 3);
+  gpointer obj = object_get (L, 1);
+  const char *name = luaL_checkstring (L, 2);
+  GValue value = { 0 };
+  ObjectProperty *prop;
+  gpointer state_lock;
+
+  prop = G_IS_OBJECT (obj) ? object_property_find (L, obj, name) : NULL;
+  if (prop == NULL || !(prop->pspec->flags & (getmode ? G_PARAM_READABLE
+					      : G_PARAM_WRITABLE)))
+    {
+      lua_pushboolean (L, FALSE);
+      return 1;
+    }
+
+  /* Leave the state during the call, property handlers can call back
+     to Lua, possibly from another thread. */
+  g_value_init (&value, prop->pspec->value_type);
+  state_lock = lgi_state_get_lock (L);
+  lua_pushboolean (L, TRUE);
+  if (getmode)
+    {
+      lgi_state_leave (state_lock);
+      g_object_get_property (obj, prop->pspec->name, &value);
+      lgi_state_enter (state_lock);
+      object_property_2lua (L, prop, &value);
+      g_value_unset (&value);
+      return 2;
+    }
+  else
+    {
+      object_property_2c (L, prop, &value, 3);
+      lgi_state_leave (state_lock);
+      g_object_set_property (obj, prop->pspec->name, &value);
+      lgi_state_enter (state_lock);
+      g_value_unset (&value);
+      return 1;
+    }
+}
+
+/* Construction properties of object_construct(), guarded for the
+   case of errors during their conversion. */
+typedef struct _ObjectConstruct
+{
+  GObjectClass *klass;
+  int n;
+  GValue values[1];
+} ObjectConstruct;
+
+static void
+object_construct_free (ObjectConstruct *construct)
+{
+  int i;
+  for (i = 0; i < construct->n; i++)
+    if (G_IS_VALUE (&construct->values[i]))
+      g_value_unset (&construct->values[i]);
+  g_type_class_unref (construct->klass);
+  g_free (construct);
+}
+
+/* Creates new object, converting all construction properties in one
+   pass.  Lua-side prototype:
+   res = object.construct(gtype, names, args, marshal)
+   'names' is array of canonical property names and 'args' array of
+   corresponding Lua values.  Values of fundamental types are stored
+   into GValues directly, for other properties, marshal(index, gvalue)
+   is called with already initialized GValue record and is supposed
+   to fill it from args[index]. */
+static int
+object_construct (lua_State *L)
+{
+  GType gtype = lgi_type_get_gtype (L, 1);
+  ObjectConstruct *construct;
+  gpointer *guard;
+  const char **names;
+  GValue *values;
+  gpointer state_lock, obj;
+  int i, n;
+
+  luaL_checktype (L, 2, LUA_TTABLE);
+  luaL_checktype (L, 3, LUA_TTABLE);
+  if (!G_TYPE_IS_OBJECT (gtype))
+    return luaL_error (L, "`%s' is not GObject type", g_type_name (gtype));
+
+  /* Prepare arrays of names and values. */
+  n = lua_objlen (L, 2);
+  names = g_newa (const char *, n + 1);
+  construct = g_malloc0 (G_STRUCT_OFFSET (ObjectConstruct, values)
+			 + sizeof (GValue) * (n + 1));
+  construct->klass = g_type_class_ref (gtype);
+  construct->n = n;
+  values = construct->values;
+  guard = lgi_guard_create (L, (GDestroyNotify) object_construct_free);
+  *guard = construct;
+  for (i = 0; i < n; i++)
+    {
+      ObjectProperty prop;
+      lua_rawgeti (L, 2, i + 1);
+      names[i] = lua_tostring (L, -1);
+      lua_pop (L, 1);
+      prop.pspec = names[i]
+	? g_object_class_find_property (construct->klass, names[i]) : NULL;
+      if (prop.pspec == NULL)
+	return luaL_error (L, "%s: no property `%s'", g_type_name (gtype),
+			   names[i] ? names[i] : "?");
+
+      g_value_init (&values[i], prop.pspec->value_type);
+      prop.fundamental = G_TYPE_FUNDAMENTAL (prop.pspec->value_type);
+      prop.tag = object_property_tag (prop.fundamental);
+      lua_rawgeti (L, 3, i + 1);
+      if (prop.tag != GI_TYPE_TAG_VOID)
+	object_property_2c (L, &prop, &values[i], lua_gettop (L));
+      else
+	{
+	  /* Let Lua-side marshaller fill the value. */
+	  lua_pushvalue (L, 4);
+	  lua_pushinteger (L, i + 1);
+	  lgi_type_get_repotype (L, G_TYPE_VALUE, NULL);
+	  lgi_record_2lua (L, &values[i], FALSE, 0);
+	  lua_call (L, 2, 0);
+	}
+      lua_pop (L, 1);
+    }
+
+  /* Create the object, leaving the state, because object construction
+     can call back into Lua. */
+  state_lock = lgi_state_get_lock (L);
+  lgi_state_leave (state_lock);
+#if GLIB_CHECK_VERSION (2, 54, 0)
+  obj = g_object_new_with_properties (gtype, n, names, values);
+#else
+  {
+    GParameter *params = g_newa (GParameter, n + 1);
+    for (i = 0; i < n; i++)
+      {
+	params[i].name = names[i];
+	params[i].value = values[i];
+      }
+    obj = g_object_newv (gtype, n, params);
+  }
+#endif
+  lgi_state_enter (state_lock);
+  *guard = NULL;
+  object_construct_free (construct);
+  lua_pop (L, 1);
+  return lgi_object_2lua (L, obj, TRUE, FALSE);
+}
+
+/* Accounts all proxies from table on the top of the stack into the
+   statistics table at index 1.  Bytes contain proxy userdata and
+   instance size of the object, shared memory referenced by the
+   object is not accounted. */
+static void
+object_stats_add (lua_State *L)
+{
+  ObjectProxy *proxy;
+  GTypeQuery query;
+  GType gtype;
+
+  lua_pushnil (L);
+  while (lua_next (L, -2) != 0)
+    {
+      /* Free slots of the proxies table are plain numbers. */
+      proxy = lua_touserdata (L, -1);
+      if (proxy != NULL && proxy->object != NULL)
+	{
+	  gtype = G_TYPE_FROM_INSTANCE (proxy->object);
+	  g_type_query (gtype, &query);
+	  lua_pushstring (L, g_type_name (gtype));
+	  lgi_stats_add (L, 1, proxy->ref ? "referenced" : "cached",
+			 lua_objlen (L, -2) + query.instance_size);
+	}
+      lua_pop (L, 1);
+    }
+  lua_pop (L, 1);
+}
+
+/* Returns table with statistics of live object proxies, keyed by
+   GType name. */
+static int
+object_stats (lua_State *L)
+{
+  lua_settop (L, 0);
+  lua_newtable (L);
+  lua_pushlightuserdata (L, &cache);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  object_stats_add (L);
+  lua_pushlightuserdata (L, &proxies);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_getfenv (L, -1);
+  lua_replace (L, -2);
+  object_stats_add (L);
+  return 1;
+}
+
 /* Object API table. */
 static const luaL_Reg object_api_reg[] = {
   { "query", object_query },
   { "field", object_field },
   { "new", object_new },
+  { "construct", object_construct },
   { "env", object_env },
+  { "property", object_property },
+  { "stats", object_stats },
   { NULL, NULL }
 };
 
@@ -591,6 +1128,7 @@ void
 lgi_object_init (lua_State *L)
 {
   char *id;
+  ObjectProxies *p;
 
   /* Register metatable. */
   lua_pushlightuserdata (L, &object_mt);
@@ -601,6 +1139,32 @@ lgi_object_init (lua_State *L)
   /* Initialize object cache. */
   lgi_cache_create (L, &cache, "v");
 
+  /* Initialize cache of ref/unref functions. */
+  lgi_cache_create (L, &type_funcs, NULL);
+
+  /* Initialize cache of native properties and their metatable. */
+  lgi_cache_create (L, &properties, NULL);
+  lua_pushlightuserdata (L, &property_mt);
+  lua_newtable (L);
+  lua_pushcfunction (L, object_property_gc);
+  lua_setfield (L, -2, "__gc");
+  lua_rawset (L, LUA_REGISTRYINDEX);
+
+  /* Initialize proxies table and its bookkeeping. */
+  lua_pushlightuserdata (L, &proxies);
+  p = lua_newuserdata (L, sizeof (ObjectProxies));
+  id = g_strdup_printf ("lgi-proxy:%p", L);
+  p->quark = g_quark_from_string (id);
+  g_free (id);
+  p->free = p->top = 0;
+  lua_newtable (L);
+  lua_newtable (L);
+  lua_pushliteral (L, "v");
+  lua_setfield (L, -2, "__mode");
+  lua_setmetatable (L, -2);
+  lua_setfenv (L, -2);
+  lua_rawset (L, LUA_REGISTRYINDEX);
+
   /* Create table for 'env' tables. */
   lua_pushlightuserdata (L, &env);
   lua_newtable (L);
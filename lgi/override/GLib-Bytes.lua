@@ -12,6 +12,7 @@ local select, type, pairs, tostring, setmetatable, error, assert
    = select, type, pairs, tostring, setmetatable, error, assert
 
 local lgi = require 'lgi'
+local core = require 'lgi.core'
 local GLib = lgi.GLib
 local Bytes = GLib.Bytes
 
@@ -20,3 +21,8 @@ Bytes._len = Bytes.get_size
 
 -- Add support for querying bytes attribute
 Bytes._attribute = { data = { get = Bytes.get_data } }
+
+-- Add zero-copy read-only view of the contents.
+function Bytes:view()
+   return core.bytes.view(self)
+end
@@ -55,129 +55,16 @@ function Variant:get_type()
    return VariantType.new(Variant.get_type_string(self))
 end
 
--- Implementation of Variant.new() from type and value.
-local variant_new
-
-local variant_basic_typemap = {
-   b = 'boolean', y = 'byte', n = 'int16', q = 'uint16',
-   i = 'int32', u = 'uint32', x = 'int64', t = 'uint64',
-   d = 'double', s = 'string', o = 'object_path', g = 'signature', }
-
--- Checks validity of variant type format beginning at pos, return
--- position in format string after end of valid part.  Returns nil
--- when format is not valid.
-local function read_format(format, pos, basic)
-   local t = format:sub(pos, pos)
-   pos = pos + 1
-   if variant_basic_typemap[t] then
-      return pos
-   elseif basic then
-      return nil
-   elseif t =='v' then
-      return pos
-   elseif t == 'a' or t == 'm' then
-      return read_format(format, pos)
-   elseif t == '{' then
-      pos = read_format(format, pos, true)
-      if pos then pos = read_format(format, pos) end
-      if not pos or format:sub(pos, pos) ~= '}' then return nil end
-      return pos + 1
-   elseif t == '(' then
-      while format:sub(pos, pos) ~=  ')' do
-	 pos = read_format(format, pos)
-	 if not pos then return nil end
-      end
-      return pos + 1
-   end
-end
-
-local function variant_new_basic(format, val)
-   local func = variant_basic_typemap[format]
-   if not func then return end
-   local v = Variant['new_' .. func](val)
-   if not v then
-      error(("Variant.new(`%s') - invalid source value"):format(format))
-   end
-   return v
-end
-
-function variant_new(format, pos, val)
-   local t = format:sub(pos, pos)
-   pos = pos + 1
-   local variant  = variant_new_basic(t, val)
-   if variant then
-      return variant, pos
-   elseif t == 'v' then
-      return Variant.new_variant(val), pos
-   elseif t == 'm' then
-      local epos
-      if val then
-	 variant, epos = variant_new(format, pos, val)
-      else
-	 epos = read_format(format, pos)
-	 if not epos then return nil end
-      end
-      return Variant.new_maybe(VariantType.new(format:sub(pos, epos - 1)),
-			       variant), epos
-   elseif t == 'a' then
-      if format:sub(pos, pos) == 'y' then
-	 -- Bytestring is just simple Lua string.
-	 return Variant.new_from_data(VariantType.BYTESTRING, val), pos + 1
-      end
-      local epos = read_format(format, pos)
-      if not epos then return nil end
-      local et = VariantType.new(format:sub(pos, epos - 1))
-      local builder = VariantBuilder.new(VariantType.new_array(et))
-      if et:is_subtype_of(VariantType.DICT_ENTRY) then
-	 -- Map dictionary to Lua table directly.
-	 for k, v in pairs(val) do
-	    builder:add_value(Variant.new_dict_entry(
-				 variant_new(format, pos + 1, k),
-				 variant_new(format, pos + 2, v)))
-	 end
-      else
-	 -- We have an issue with 'array with holes'. An attempt is
-	 -- made here to work around it with 'n' field, if present.
-	 for i = 1, val.n or #val do
-	    builder:add_value(variant_new(format, pos, val[i]))
-	 end
-      end
-      return builder:_end(), epos
-   elseif t == '(' or t == '{' then
-      -- Extract and check whole tuple or entry format.
-      local epos = read_format(format, pos -1)
-      if not epos then return nil end
-
-      -- Prepare builder with specified format.
-      local builder = VariantBuilder.new(
-	 VariantType.new(format:sub(pos - 1, epos - 1)))
-
-      -- Loop through provided value array and build variant using
-      -- prepared builder.
-      local i = 1
-      while not format:sub(pos, pos):match('^[%)}]') do
-	 local v, epos = variant_new(format, pos, val[i])
-	 if not v then return nil end
-	 builder:add_value(v)
-	 pos = epos
-	 i = i + 1
-      end
-      return builder:_end(), pos + 1
-   end
-end
-
--- Variant.new() is just a facade over variant_new backend.
+-- Variant.new() is just a facade over native serializer, which
+-- compiles the format into a cached plan on its first use.
+local variant_new = core.variant.new
 function Variant.new(vt, val)
    if type(vt) == 'userdata' then
       -- Wrap existing pointer to variant.
       return core.record.new(Variant, vt, val)
    end
    if type(vt) ~= 'string' then vt = vt:dup_string() end
-   local v, epos = variant_new(vt, 1, val)
-   if not v or epos ~= #vt + 1 then
-      error(("Variant.new(`%s') - invalid type"):format(vt))
-   end
-   return v
+   return variant_new(vt, val)
 end
 function Variant:_new(...) return Variant.new(...) end
 
@@ -257,6 +144,9 @@ end
 -- Map simple unpacking to reading 'value' property.
 Variant._attribute.value = { get = variant_get }
 
+-- Lazy zero-copy unpacking is available through 'view' property.
+Variant._attribute.view = { get = core.variant.view }
+
 -- Define meaning of # and number-indexing to children access. Note
 -- that GVariant g_asserts when these methods are invoked on variants
 -- of inappropriate type, so we have to check manually before.
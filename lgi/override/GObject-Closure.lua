@@ -271,6 +271,13 @@ end
 -- that can be called).  Optionally callback_info specifies detailed
 -- information about how to marshal signals.
 function Closure:_new(target, callback_info)
+   -- Signals with simple enough arguments are marshalled natively,
+   -- without going through CallInfo.
+   if target and callback_info and callback_info.is_signal then
+      local closure = core.marshal.signal_closure(target, callback_info)
+      if closure then return closure end
+   end
+
    local closure = Closure._method.new_simple(closure_info.size, nil)
    if target then
       local marshaller
@@ -36,20 +36,11 @@ function TypeClass:_new()
 end
 
 -- Object constructor, 'param' contains table _with properties/signals
--- to initialize.
-local parameter_repo = repo.GObject.Parameter
--- Before GLib 2.54, g_object_newv() was annotated with [rename-to g_object_new].
--- Starting from GLib 2.54, g_object_new_with_properties() has this annotation.
--- We always want g_object_newv().
-local object_new = gi.GObject.Object.methods.newv or gi.GObject.Object.methods.new
-if object_new then
-   object_new = core.callable.new(object_new)
-else
-   -- Unfortunately, older GI (<1.30) does not export g_object_newv()
-   -- in the typelib, so we have to workaround here with manually
-   -- implemented C version.
-   object_new = core.object.new
-end
+-- to initialize.  Construction properties are converted and passed to
+-- g_object_new_with_properties() in a single native call, only
+-- properties of non-fundamental types call back to the marshaller
+-- below.
+local object_construct = core.object.construct
 
 -- Generic construction method.
 function Object:_construct(gtype, param, owns)
@@ -69,30 +60,18 @@ function Object:_construct(gtype, param, owns)
    -- In 'wrap' mode, just return the created object.
    if object then return object end
 
-   -- Process 'args' table, separate properties from other fields.
-   local parameters, others, safe = {}, {}, {}
+   -- Process 'args' table, separate properties and signals from other
+   -- fields.
+   local names, args, props, signals, others = {}, {}, {}, {}, {}
    for name, arg in pairs(param or {}) do
       if type(name) == 'string' then
-	 local argtype = self[name]
+	 local argtype, category = self:_element(nil, name)
 	 if gi.isinfo(argtype) and argtype.is_property then
-	    local parameter = core.record.new(parameter_repo)
-	    name = argtype.name
-	    local value = parameter.value
-
-	    -- Store the name string in some safe Lua place ('safe'
-	    -- table), because param is GParameter, which contains
-	    -- only non-owning pointer to the string, and it could be
-	    -- Lua-GC'ed while still referenced by GParameter
-	    -- instance.
-	    safe[#safe + 1] = name
-	    safe[#safe + 1] = value
-
-	    parameter.name = name
-	    local gtype = Type.from_typeinfo(argtype.typeinfo)
-	    Value.init(value, gtype)
-	    local marshaller = Value.find_marshaller(gtype, argtype.typeinfo)
-	    marshaller(value, nil, arg)
-	    parameters[#parameters + 1] = parameter
+	    local n = #names + 1
+	    names[n], args[n], props[n] = argtype.name, arg, argtype
+	 elseif category == '_signal' then
+	    signals[#signals + 1] = argtype
+	    signals[#signals + 1] = arg
 	 else
 	    others[name] = arg
 	 end
@@ -100,7 +79,11 @@ function Object:_construct(gtype, param, owns)
    end
 
    -- Create the object.
-   object = object_new(gtype, parameters)
+   object = object_construct(gtype, names, args, function(i, value)
+      local typeinfo = props[i].typeinfo
+      local marshaller = Value.find_marshaller(value.gtype, typeinfo)
+      marshaller(value, nil, args[i])
+   end)
 
    -- Perform initialization on interfaces.
    if next(self._implements) then
@@ -124,6 +107,12 @@ function Object:_construct(gtype, param, owns)
       end
    end
 
+   -- Connect all signal handlers in one pass, without dispatching
+   -- through the instance.
+   for i = 1, #signals, 2 do
+      self:_access_signal(object, signals[i], signals[i + 1])
+   end
+
    -- Attach arguments previously filtered out from creation.
    for name, value in pairs(others) do
       if type(name) == 'string' then object[name] = value end
@@ -271,8 +260,12 @@ local function marshal_property(obj, name, flags, gtype, marshaller, ...)
    end
 end
 
--- Property accessor.
+-- Property accessor.  Properties of fundamental types are handled
+-- natively by core.object.property, the rest goes through GObject.Value.
+local object_property = core.object.property
 function Object:_access_property(object, prop, ...)
+   local handled, value = object_property(object, prop.name, ...)
+   if handled then return value end
    if gi.isinfo(prop) then
       -- GI-based property
       local typeinfo = prop.typeinfo
@@ -36,6 +36,11 @@ if not Gdk.Rectangle then
    Gdk.Rectangle._method.union = Gdk.rectangle_union
 end
 
+-- Rectangles and colors are plain value structures, created and
+-- dropped in large numbers; avoid caching their proxies.
+Gdk.Rectangle._value = true
+if Gdk.RGBA then Gdk.RGBA._value = true end
+
 -- Declare GdkAtoms which are #define'd in Gdk3 sources and not
 -- introspected in gir.
 if Gdk.Atom then
@@ -8,8 +8,9 @@
 --
 ------------------------------------------------------------------------------
 
-local pairs, ipairs
-   = pairs, ipairs
+local pairs, ipairs, error
+   = pairs, ipairs, error
+local table = require 'table'
 
 local lgi = require 'lgi'
 local core = require 'lgi.core'
@@ -80,3 +81,37 @@ if core.gi.Gio.DBusProxy.methods.get_interface_info.return_transfer ~= 'none' th
       core.gi.Gio.DBusProxy.methods.new_sync.return_type,
    }
 end
+
+-- Native dispatch of method calls of exported objects.  Handlers get
+-- decoded method arguments directly and their return values are
+-- encoded using reply signature precomputed from interface info,
+-- without creating any GLib.Variant proxies.
+local dbus_funcs = {
+   register = core.gi.Gio.resolve.g_dbus_connection_register_object,
+   return_value = core.gi.Gio.resolve.g_dbus_method_invocation_return_value,
+   return_dbus_error =
+      core.gi.Gio.resolve.g_dbus_method_invocation_return_dbus_error,
+   return_gerror = core.gi.Gio.resolve.g_dbus_method_invocation_return_gerror,
+}
+
+function Gio.DBusConnection:register_methods(object_path, info, handlers)
+   local methods = {}
+   for _, method in ipairs(info.methods or {}) do
+      local handler = handlers[method.name]
+      if handler then
+	 local signature = {}
+	 for i, arg in ipairs(method.out_args or {}) do
+	    signature[i] = arg.signature
+	 end
+	 signature = '(' .. table.concat(signature) .. ')'
+	 if not core.variant.compile(signature) then
+	    error(("%s: invalid reply signature `%s'"):format(
+		     method.name, signature), 2)
+	 end
+	 methods[method.name] = { handler, signature }
+      end
+   end
+   return core.variant.dbus_register(
+      dbus_funcs, core.object.query(self, 'addr'), object_path,
+      core.record.query(info, 'addr', Gio.DBusInterfaceInfo), methods)
+end
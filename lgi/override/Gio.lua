@@ -8,9 +8,11 @@
 --
 ------------------------------------------------------------------------------
 
-local select, type, pairs, setmetatable, rawset, unpack =
-   select, type, pairs, setmetatable, rawset, unpack or table.unpack
+local select, type, pairs, setmetatable, rawset, pcall, tostring, unpack =
+   select, type, pairs, setmetatable, rawset, pcall, tostring,
+   unpack or table.unpack
 local coroutine = require 'coroutine'
+local table = require 'table'
 
 local lgi = require 'lgi'
 local GLib = lgi.GLib
@@ -63,41 +65,139 @@ function Gio.Async.start(func, cancellable, io_priority)
    end
 end
 
+-- Resumes coroutine, errors are passed to the 'fail' hook of its
+-- async context if present, otherwise they are raised.
+local function async_resume(coro, ...)
+   local ok, err = coroutine.resume(coro, ...)
+   if not ok then
+      local context = async_context[coro]
+      if context and context.fail then
+	 context.fail(err)
+      else
+	 error(err, 0)
+      end
+   end
+end
+
+-- Shared completion callback of async calls started from coroutines.
+-- Completions are queued in C and dispatched in batches, 'batch'
+-- contains (coroutine, source, result) triples.
+local async_ready = core.callable.async(function(batch, count)
+      local errors
+      for i = 1, count * 3, 3 do
+	 local ok, err = pcall(async_resume, batch[i], batch[i + 1],
+			       batch[i + 2])
+	 if not ok then
+	    errors = errors or {}
+	    errors[#errors + 1] = tostring(err)
+	 end
+      end
+      if errors then error(table.concat(errors, '\n'), 0) end
+end)
+
 function Gio.Async.call(func, cancellable, io_priority)
-   -- Create mainloop which will create modality.
-   local loop = GLib.MainLoop()
-   local results
+   local results, failure
 
    -- Create coroutine around function wrapper which will invoke
-   -- target and then terminate the loop.
+   -- target and store its results.
    local coro = coroutine.create(function(...)
 	 (function(...)
 	     results = { n = select('#', ...), ... }
-	     loop:quit()
 	 end)(func(...))
    end)
 
-   -- Register coroutine.
+   -- Register coroutine, collect its errors.
    register_async(coro, cancellable, io_priority)
+   async_context[coro].fail = function(err) failure = failure or err end
 
    -- Return starter closure.
    return function(...)
-      -- Spawn it inside idle handler, to avoid hang in case that
-      -- coroutine finishes during its first resuming.
-      local args = { n = select('#', ...), ... }
-      GLib.idle_add(
-	 GLib.PRIORITY_DEFAULT, function()
-	    coroutine.resume(coro, unpack(args, 1, args.n))
-      end)
-
-      -- Spin the loop.
-      loop:run()
+      -- Start the coroutine and iterate the context until it
+      -- finishes; no modal loop is needed, because completions are
+      -- dispatched from the context itself.
+      async_resume(coro, ...)
+      local context
+      while coroutine.status(coro) ~= 'dead' and not failure do
+	 context = context or GLib.MainContext.ref_thread_default()
+	 context:iteration(true)
+      end
+      if failure then error(failure, 0) end
 
       -- Unpack results.
       return unpack(results, 1, results.n)
    end
 end
 
+-- Runs all functions as concurrent child coroutines of the currently
+-- running async coroutine, and waits for all of them (or for the
+-- first one, when 'race' is set).
+local function async_spawn(name, race, ...)
+   local parent = coroutine.running()
+   if not async_context[parent] then
+      error(("Gio.Async.%s: called out of async context"):format(name), 3)
+   end
+
+   local funcs = { n = select('#', ...), ... }
+   local results, cancellables, pending = {}, {}, funcs.n
+   local waiting, failure, winner
+
+   local function wake()
+      if waiting then
+	 waiting = false
+	 async_resume(parent)
+      end
+   end
+
+   local function done(index, ...)
+      -- Ignore late finishers of already decided race.
+      if pending == 0 then return end
+      results[index] = { n = select('#', ...), ... }
+      pending = pending - 1
+      if race then
+	 winner, pending = index, 0
+	 for i, cancellable in pairs(cancellables) do
+	    if i ~= index then cancellable:cancel() end
+	 end
+      end
+      if pending == 0 then wake() end
+   end
+
+   for i = 1, funcs.n do
+      if pending == 0 then break end
+      local child = coroutine.create(function() done(i, funcs[i]()) end)
+      if race then cancellables[i] = Gio.Cancellable() end
+      register_async(child, cancellables[i])
+      async_context[child].fail = function(err)
+	 -- Only the first failure decides the aggregate; errors of
+	 -- cancelled race losers and late failures are ignored.
+	 if pending == 0 then return end
+	 failure, pending = err, 0
+	 wake()
+      end
+      async_resume(child)
+   end
+
+   -- Wait for children which did not finish synchronously.
+   if pending > 0 then
+      waiting = true
+      coroutine.yield()
+   end
+   if failure then error(failure, 0) end
+   return winner, results
+end
+
+function Gio.Async.all(...)
+   local _, results = async_spawn('all', false, ...)
+   return unpack(results, 1, select('#', ...))
+end
+
+function Gio.Async.race(...)
+   local winner, results = async_spawn('race', true, ...)
+   if winner then
+      return winner, unpack(results[winner], 1, results[winner].n)
+   end
+end
+
 -- Add 'async_' method handling.  Dynamically generates wrapper around
 -- xxx_async()/xxx_finish() sequence using currently running
 -- coroutine.
@@ -127,6 +227,7 @@ local function async_element(name, accessor, param_self, param_object)
 	 for _, param in ipairs(async.params) do
 	    if param['in'] then
 	       element.in_args = element.in_args + 1
+	       if param.closure then element.shared = true end
 	       if not param['out'] and param.typeinfo then
 		  if param.name == 'io_priority' and
 		  param.typeinfo.tag == tag_int then
@@ -167,7 +268,8 @@ local function async_access(element, process_yield)
 	    index = index + 1
 	 end
       end
-      args[element.in_args] = coroutine.running()
+      args[element.in_args] = element.shared and async_ready
+	 or coroutine.running()
 
       element.async(unpack(args, 1, element.in_args))
       return element.finish(process_yield(coroutine.yield()))
@@ -106,6 +106,7 @@ for _, info in ipairs {
    },
 
    {  'Rectangle',
+      value = true,
       fields = {
 	 { 'x', ti.double }, { 'y', ti.double },
 	 { 'width', ti.double }, { 'height', ti.double },
@@ -121,6 +122,7 @@ for _, info in ipairs {
    },
 
    {  'RectangleInt',
+      value = true,
       fields = {
 	 { 'x', ti.int }, { 'y', ti.int },
 	 { 'width', ti.int }, { 'height', ti.int },
@@ -128,6 +130,8 @@ for _, info in ipairs {
    },
 
    {  'Matrix',
+      keep_lock = true,
+      value = true,
       fields = {
 	 { 'xx', ti.double }, { 'yx', ti.double },
 	 { 'xy', ti.double }, { 'yy', ti.double },
@@ -190,6 +194,23 @@ for _, info in ipairs {
 
    {  'Context',
       cprefix = '',
+      -- Only trivial state, path and transformation methods keep the
+      -- lock; drawing calls can take long or flush the surface.
+      keep_lock = {
+	 'status', 'save', 'restore', 'set_source_rgb', 'set_source_rgba',
+	 'set_antialias', 'get_antialias', 'get_dash_count',
+	 'set_fill_rule', 'get_fill_rule', 'set_line_cap', 'get_line_cap',
+	 'set_line_join', 'get_line_join', 'set_line_width',
+	 'get_line_width', 'set_miter_limit', 'get_miter_limit',
+	 'set_operator', 'get_operator', 'set_tolerance', 'get_tolerance',
+	 'has_current_point', 'get_current_point', 'new_path',
+	 'new_sub_path', 'close_path', 'arc', 'arc_negative', 'curve_to',
+	 'line_to', 'move_to', 'rectangle', 'rel_curve_to', 'rel_line_to',
+	 'rel_move_to', 'translate', 'scale', 'rotate', 'transform',
+	 'set_matrix', 'get_matrix', 'identity_matrix', 'user_to_device',
+	 'user_to_device_distance', 'device_to_user',
+	 'device_to_user_distance', 'set_font_size',
+      },
       methods = {
 	 create = { static = true, ret = { cairo.Context, xfer = true },
 		    cairo.Surface },
@@ -672,6 +693,7 @@ for _, info in ipairs {
       local name = info[1]
       local obj = assert(cairo[name], name)
       obj._parent = info.parent
+      obj._value = info.value
       local cprefix = 'cairo_' .. (info.cprefix or core.uncamel(name) .. '_')
       if not obj._parent then
 	 obj._refsink = cairo._module[cprefix .. 'reference']
@@ -681,6 +703,13 @@ for _, info in ipairs {
 	 -- from them.
 	 obj._method = {}
 	 local self_arg = { obj }
+	 local keep_lock = info.keep_lock
+	 if type(keep_lock) == 'table' then
+	    keep_lock = {}
+	    for _, method_name in ipairs(info.keep_lock) do
+	       keep_lock[method_name] = true
+	    end
+	 end
 	 for method_name, method_info in pairs(info.methods) do
 	    if cairo.version >= (method_info.since or 0) then
 	       method_info.name = 'cairo.' .. name .. '.' .. method_name
@@ -691,6 +720,13 @@ for _, info in ipairs {
 		  table.insert(method_info, 1, self_arg)
 	       end
 	       method_info.ret = method_info.ret or ti.void
+	       if method_info.keep_lock == nil then
+		  if type(keep_lock) == 'table' then
+		     method_info.keep_lock = keep_lock[method_name]
+		  else
+		     method_info.keep_lock = keep_lock
+		  end
+	       end
 	       obj._method[method_name] = core.callable.new(method_info)
 	    end
 	 end
@@ -897,6 +933,33 @@ function cairo.Context:get_dash()
    return dashes, offset
 end
 
+-- Batched path construction and retrieval.  Paths are described by a
+-- flat typed buffer or table of coordinates and a string of
+-- operations, 'M' (move_to), 'L' (line_to), 'C' (curve_to) and 'Z'
+-- (close_path); the path is packed by C code and appended by single
+-- call.
+local raw_append_path = core.callable.new {
+   addr = cairo._module.cairo_append_path, ret = ti.void, keep_lock = true,
+   cairo.Context, ti.ptr }
+function cairo.Context:append_path_data(coords, ops)
+   raw_append_path(self, core.cairo.path_pack(coords, ops))
+end
+
+function cairo.Context:polyline(coords)
+   raw_append_path(self, core.cairo.path_pack(coords))
+end
+
+for _, name in pairs { 'copy_path', 'copy_path_flat' } do
+   local copy = cairo.Context._method[name]
+   cairo.Context._method[name .. '_data'] = function(self)
+      -- Keep the path alive in the local until it is unpacked.
+      local path = copy(self)
+      local coords, ops = core.cairo.path_unpack(
+	 core.record.query(path, 'addr'))
+      return coords, ops
+   end
+end
+
 -- Implementation of iteration protocol over the cairo.Path
 function cairo.Path:pairs()
    local index = 0
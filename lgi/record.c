@@ -37,8 +37,15 @@ typedef struct _Record
   /* Address of the record memory data. */
   gpointer addr;
 
-  /* Store mode of the record. */
-  RecordStore store;
+  /* Store mode of the record (RecordStore). */
+  guint store : 3;
+
+  /* Set for records of value types (typetable with '_value' set).
+     Value records are plain data; they are not registered in the
+     record_cache, they never invoke _attach, _refsink, _copy or
+     _uninit and carry their size here. */
+  guint value : 1;
+  guint size : 28;
 
   /* If the record is allocated 'on the stack', its data is
      here. Anonymous union makes sure that data is properly aligned to
@@ -63,26 +70,76 @@ static int record_cache;
    recordproxy(weak) -> parent */
 static int parent_cache;
 
+/* Userdata containing contiguous array of records.  Typetable of the
+   elements is attached as userdata environment. */
+typedef struct _RecordArray
+{
+  /* Number of elements and size of single element. */
+  gsize count;
+  gsize size;
+
+  /* Elements of the array, aligned in the same way as in Record. */
+  union {
+    gchar data[1];
+    double align_double;
+    long align_long;
+    gpointer align_ptr;
+  };
+} RecordArray;
+
+/* lightuserdata key to LUA_REGISTRYINDEX containing metatable for
+   record arrays. */
+static int record_array_mt;
+
+/* lightuserdata key to cache table containing
+   weak(recordarray) -> weak(cursor record) */
+static int record_array_cursors;
+
+/* Number and total size of live value records.  Value records are not
+   registered in any cache, so memory statistics have to count them as
+   they come and go; counters are process-wide. */
+static volatile gint record_values;
+static volatile gint record_value_bytes;
+
+/* Checks whether typetable on the top of the stack is marked as
+   value record type.  The mark is looked up only directly in the
+   typetable, to avoid invoking its generic __index. */
+static gboolean
+record_is_value (lua_State *L)
+{
+  gboolean value;
+  lua_pushliteral (L, "_value");
+  lua_rawget (L, -2);
+  value = lua_toboolean (L, -1);
+  lua_pop (L, 1);
+  return value;
+}
+
 gpointer
 lgi_record_new (lua_State *L, int count, gboolean alloc)
 {
   Record *record;
   size_t size;
+  gboolean value;
 
   luaL_checkstack (L, 4, "");
 
   /* Calculate size of the record to allocate. */
+  value = record_is_value (L);
   lua_getfield (L, -1, "_size");
-  size = lua_tointeger (L, -1) * count;
+  size = lua_tointeger (L, -1);
   lua_pop (L, 1);
 
   /* Allocate new userdata for record object, attach proper
      metatable. */
   record = lua_newuserdata (L, G_STRUCT_OFFSET (Record, data) +
-			    (alloc ? 0 : size));
+			    (alloc ? 0 : size * count));
   lua_pushlightuserdata (L, &record_mt);
   lua_rawget (L, LUA_REGISTRYINDEX);
   lua_setmetatable (L, -2);
+  record->value = value;
+  record->size = size;
+  size *= count;
   if (G_LIKELY (!alloc))
     {
       record->addr = record->data;
@@ -98,6 +155,13 @@ lgi_record_new (lua_State *L, int count, gboolean alloc)
   /* Get ref_repo table, attach it as an environment. */
   lua_pushvalue (L, -2);
   lua_setfenv (L, -2);
+  if (value)
+    {
+      g_atomic_int_inc (&record_values);
+      g_atomic_int_add (&record_value_bytes, lua_objlen (L, -1));
+      lua_remove (L, -2);
+      return record->addr;
+    }
 
   /* Store newly created record into the cache. */
   lua_pushlightuserdata (L, &record_cache);
@@ -167,6 +231,40 @@ record_free (lua_State *L, Record *record, int narg)
   lua_pop (L, 1);
 }
 
+/* Creates proxy of value record, assumes that typetable is on the
+   stack and replaces it with the proxy. */
+static void
+record_value_2lua (lua_State *L, gpointer addr, gboolean own, int parent)
+{
+  Record *record = lua_newuserdata (L, G_STRUCT_OFFSET (Record, data));
+  lua_pushlightuserdata (L, &record_mt);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_setmetatable (L, -2);
+  record->addr = addr;
+  record->value = 1;
+  lua_getfield (L, -2, "_size");
+  record->size = lua_tointeger (L, -1);
+  lua_pop (L, 1);
+  g_atomic_int_inc (&record_values);
+  g_atomic_int_add (&record_value_bytes, G_STRUCT_OFFSET (Record, data));
+  if (parent != 0)
+    {
+      lua_pushlightuserdata (L, &parent_cache);
+      lua_rawget (L, LUA_REGISTRYINDEX);
+      lua_pushvalue (L, -2);
+      lua_pushvalue (L, parent);
+      lua_rawset (L, -3);
+      lua_pop (L, 1);
+      record->store = RECORD_STORE_NESTED;
+    }
+  else
+    record->store = own ? RECORD_STORE_ALLOCATED : RECORD_STORE_EXTERNAL;
+
+  lua_pushvalue (L, -2);
+  lua_setfenv (L, -2);
+  lua_remove (L, -2);
+}
+
 void
 lgi_record_2lua (lua_State *L, gpointer addr, gboolean own, int parent)
 {
@@ -188,6 +286,13 @@ lgi_record_2lua (lua_State *L, gpointer addr, gboolean own, int parent)
   else
     lgi_makeabs (L, parent);
 
+  /* Value records do not use the cache at all. */
+  if (record_is_value (L))
+    {
+      record_value_2lua (L, addr, own, parent);
+      return;
+    }
+
   /* Prepare access to cache. */
   lua_pushlightuserdata (L, &record_cache);
   lua_rawget (L, LUA_REGISTRYINDEX);
@@ -223,6 +328,7 @@ lgi_record_2lua (lua_State *L, gpointer addr, gboolean own, int parent)
   lua_rawget (L, LUA_REGISTRYINDEX);
   lua_setmetatable (L, -2);
   record->addr = addr;
+  record->value = 0;
   if (parent != 0)
     {
       /* Store reference to the parent argument into parent reference
@@ -400,7 +506,10 @@ lgi_record_2c (lua_State *L, int narg, gpointer target, gboolean by_value,
       size = lua_tointeger (L, -1);
       lua_pop (L, 1);
 
-      if (record)
+      if (record && record->value)
+	/* Value records are plain data, copy them directly. */
+	memcpy (target, record->addr, record->size);
+      else if (record)
 	{
 	  /* Check, whether custom _copy is registered. */
 	  void (*copy_func)(gpointer, gpointer) =
@@ -423,8 +532,16 @@ record_gc (lua_State *L)
 {
   Record *record = record_get (L, 1);
 
-  if (record->store == RECORD_STORE_EMBEDDED
-      || record->store == RECORD_STORE_NESTED)
+  if (record->value)
+    {
+      /* Value records have to be freed only when owned. */
+      if (record->store == RECORD_STORE_ALLOCATED)
+	record_free (L, record, 1);
+      g_atomic_int_add (&record_values, -1);
+      g_atomic_int_add (&record_value_bytes, -(gint) lua_objlen (L, 1));
+    }
+  else if (record->store == RECORD_STORE_EMBEDDED
+	   || record->store == RECORD_STORE_NESTED)
     {
       /* Check whether record has registered '_uninit' function, and
 	 invoke it if yes. */
@@ -563,7 +680,8 @@ static const char* const query_modes[] = { "gtype", "repo", "addr", NULL };
    'repo': returns repotable of this instance.
    'addr': returns address of the object.  If 3rd argument is either
 	   repotable, checks, whether record conforms to the specs and
-	   if not, throws an error.  */
+	   if not, throws an error.  Optional 4th argument tells whether
+	   nil is accepted (and converted to NULL), defaults to true.  */
 static int
 record_query (lua_State *L)
 {
@@ -601,8 +719,9 @@ record_query (lua_State *L)
       else
 	{
 	  gpointer addr;
+	  gboolean optional = lua_isnone (L, 4) || lua_toboolean (L, 4);
 	  lua_pushvalue (L, 3);
-	  lgi_record_2c (L, 1, &addr, FALSE, FALSE, TRUE, FALSE);
+	  lgi_record_2c (L, 1, &addr, FALSE, FALSE, optional, FALSE);
 	  lua_pushlightuserdata (L, addr);
 	}
 
@@ -656,8 +775,13 @@ record_fromarray (lua_State *L)
 
   /* Find out the size of this record. */
   lua_getfenv (L, 1);
-  lua_getfield (L, -1, "_size");
-  size = lua_tointeger (L, -1);
+  if (record->value)
+    size = record->size;
+  else
+    {
+      lua_getfield (L, -1, "_size");
+      size = lua_tointeger (L, -1);
+    }
 
   if (record->store == RECORD_STORE_EMBEDDED)
     /* Parent is actually our embedded record. */
@@ -713,6 +837,307 @@ record_set (lua_State *L)
   return 0;
 }
 
+/* Checks that given argument is record array, returns NULL if not. */
+static RecordArray *
+record_array_check (lua_State *L, int narg)
+{
+  RecordArray *array = lua_touserdata (L, narg);
+  luaL_checkstack (L, 3, "");
+  if (!lua_getmetatable (L, narg))
+    return NULL;
+  lua_pushlightuserdata (L, &record_array_mt);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  if (!lua_equal (L, -1, -2))
+    array = NULL;
+  lua_pop (L, 2);
+  return array;
+}
+
+static RecordArray *
+record_array_get (lua_State *L, int narg)
+{
+  RecordArray *array = record_array_check (L, narg);
+  if (array == NULL)
+    record_error (L, narg, "lgi.recarray");
+  return array;
+}
+
+gpointer
+lgi_record_array_new (lua_State *L, gsize count, gconstpointer data)
+{
+  RecordArray *array;
+  gsize size;
+
+  luaL_checkstack (L, 3, "");
+  lua_getfield (L, -1, "_size");
+  size = lua_tointeger (L, -1);
+  lua_pop (L, 1);
+  if (size > 0 && count > (G_MAXSIZE - G_STRUCT_OFFSET (RecordArray, data))
+      / size)
+    luaL_error (L, "record array of %lu elements is too large",
+		(unsigned long) count);
+
+  array = lua_newuserdata (L, G_STRUCT_OFFSET (RecordArray, data)
+			   + size * count);
+  lua_pushlightuserdata (L, &record_array_mt);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_setmetatable (L, -2);
+  array->count = count;
+  array->size = size;
+  if (data != NULL)
+    memcpy (array->data, data, size * count);
+  else
+    memset (array->data, 0, size * count);
+
+  /* Attach typetable as an environment and remove it from the
+     stack. */
+  lua_pushvalue (L, -2);
+  lua_setfenv (L, -2);
+  lua_remove (L, -2);
+  return array->data;
+}
+
+gpointer
+lgi_record_array_get (lua_State *L, int narg, gsize *count)
+{
+  RecordArray *array;
+  gpointer data = NULL;
+
+  lgi_makeabs (L, narg);
+  array = record_array_check (L, narg);
+  if (array != NULL)
+    {
+      lua_getfenv (L, narg);
+      if (lua_rawequal (L, -1, -2))
+	{
+	  *count = array->count;
+	  data = array->data;
+	}
+      lua_pop (L, 1);
+    }
+
+  lua_pop (L, 1);
+  return data;
+}
+
+/* Returns address of element of the array at given 1-based index,
+   checking the bounds. */
+static gpointer
+record_array_element (lua_State *L, RecordArray *array, int narg)
+{
+  lua_Integer index = luaL_checkinteger (L, narg);
+  luaL_argcheck (L, index >= 1 && (gsize) index <= array->count, narg,
+		 "out of bounds");
+  return array->data + (index - 1) * array->size;
+}
+
+/* Pushes cursor record of the array at narg, pointing to given
+   element.  The cursor is single record proxy shared by all accesses
+   to the array elements, so that no proxy has to be created for
+   every element. */
+static void
+record_array_cursor (lua_State *L, int narg, gpointer element)
+{
+  Record *cursor;
+
+  luaL_checkstack (L, 5, "");
+  lua_pushlightuserdata (L, &record_array_cursors);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_pushvalue (L, narg);
+  lua_rawget (L, -2);
+  if (lua_isnil (L, -1))
+    {
+      /* Create new cursor; it keeps the array alive through the
+	 parent_cache.  The cursor does not own the element, so it
+	 must not be uninitialized when the cursor dies. */
+      lua_pop (L, 1);
+      lua_getfenv (L, narg);
+      lgi_record_2lua (L, element, FALSE, narg);
+      cursor = lua_touserdata (L, -1);
+      cursor->store = RECORD_STORE_EXTERNAL;
+      lua_pushvalue (L, narg);
+      lua_pushvalue (L, -2);
+      lua_rawset (L, -4);
+    }
+
+  cursor = lua_touserdata (L, -1);
+  cursor->addr = element;
+  lua_replace (L, -2);
+}
+
+/* Stores value at given stack index into the array element.  Value
+   can be either record of the element type, which is copied, or table
+   with fields to assign. */
+static void
+record_array_store (lua_State *L, int narg, gpointer element, int val)
+{
+  lgi_makeabs (L, narg);
+  lgi_makeabs (L, val);
+  if (lua_type (L, val) == LUA_TTABLE)
+    {
+      record_array_cursor (L, narg, element);
+      lua_pushnil (L);
+      while (lua_next (L, val))
+	{
+	  lua_pushvalue (L, -2);
+	  lua_insert (L, -2);
+	  lua_settable (L, -4);
+	}
+      lua_pop (L, 1);
+    }
+  else
+    {
+      lua_getfenv (L, narg);
+      lgi_record_2c (L, val, element, TRUE, FALSE, FALSE, FALSE);
+    }
+}
+
+static int
+record_array_index (lua_State *L)
+{
+  RecordArray *array = record_array_get (L, 1);
+  record_array_cursor (L, 1, record_array_element (L, array, 2));
+  return 1;
+}
+
+static int
+record_array_newindex (lua_State *L)
+{
+  RecordArray *array = record_array_get (L, 1);
+  record_array_store (L, 1, record_array_element (L, array, 2), 3);
+  return 0;
+}
+
+static int
+record_array_len (lua_State *L)
+{
+  RecordArray *array = record_array_get (L, 1);
+  lua_pushinteger (L, array->count);
+  return 1;
+}
+
+static int
+record_array_tostring (lua_State *L)
+{
+  RecordArray *array = record_array_get (L, 1);
+  lua_getfenv (L, 1);
+  lua_getfield (L, -1, "_name");
+  lua_pushfstring (L, "lgi.recarray %p:%s[%d]", array->data,
+		   lua_tostring (L, -1), (int) array->count);
+  return 1;
+}
+
+static const struct luaL_Reg record_array_meta_reg[] = {
+  { "__index", record_array_index },
+  { "__newindex", record_array_newindex },
+  { "__len", record_array_len },
+  { "__tostring", record_array_tostring },
+  { NULL, NULL }
+};
+
+/* Creates contiguous array of records.  Lua prototype:
+   array = core.record.array(repotable, count|{ records-or-tables })
+   or queries address and length of existing array:
+   addr, count = core.record.array(array) */
+static int
+record_array (lua_State *L)
+{
+  RecordArray *array = record_array_check (L, 1);
+  gsize count, i;
+  if (array != NULL)
+    {
+      lua_pushlightuserdata (L, array->data);
+      lua_pushinteger (L, array->count);
+      return 2;
+    }
+
+  luaL_checktype (L, 1, LUA_TTABLE);
+  if (lua_type (L, 2) == LUA_TTABLE)
+    count = lua_objlen (L, 2);
+  else
+    {
+      lua_Integer n = luaL_checkinteger (L, 2);
+      luaL_argcheck (L, n >= 0, 2, "invalid count");
+      count = n;
+    }
+  lua_pushvalue (L, 1);
+  lgi_record_array_new (L, count, NULL);
+  if (lua_type (L, 2) == LUA_TTABLE)
+    {
+      array = lua_touserdata (L, -1);
+      for (i = 0; i < count; i++)
+	{
+	  lua_rawgeti (L, 2, i + 1);
+	  record_array_store (L, -2, array->data + i * array->size, -1);
+	  lua_pop (L, 1);
+	}
+    }
+  return 1;
+}
+
+/* Names of store modes, used as counters in memory statistics. */
+static const char *const record_store_names[] = {
+  "external", "embedded", "nested", "allocated"
+};
+
+/* Returns table with statistics of live record proxies, keyed by
+   typetable name, and table with totals which cannot be attributed to
+   single typetable. */
+static int
+record_stats (lua_State *L)
+{
+  Record *record;
+  size_t bytes;
+  int count;
+
+  lua_settop (L, 0);
+  lua_newtable (L);
+  lua_pushlightuserdata (L, &record_cache);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_pushnil (L);
+  while (lua_next (L, -2) != 0)
+    {
+      /* Proxy memory itself, embedded data included; allocated
+	 records own also the memory of the record. */
+      record = lua_touserdata (L, -1);
+      bytes = lua_objlen (L, -1);
+      lua_getfenv (L, -1);
+      if (record->store == RECORD_STORE_ALLOCATED)
+	{
+	  lua_pushliteral (L, "_size");
+	  lua_rawget (L, -2);
+	  bytes += lua_tointeger (L, -1);
+	  lua_pop (L, 1);
+	}
+      lua_pushliteral (L, "_name");
+      lua_rawget (L, -2);
+      if (lua_isnil (L, -1))
+	{
+	  lua_pop (L, 1);
+	  lua_pushliteral (L, "<unknown>");
+	}
+      lua_replace (L, -3);
+      lua_pop (L, 1);
+      lgi_stats_add (L, 1, record_store_names[record->store], bytes);
+    }
+  lua_pop (L, 1);
+
+  /* Totals of uncached records and parent links. */
+  lua_newtable (L);
+  lua_pushinteger (L, g_atomic_int_get (&record_values));
+  lua_setfield (L, -2, "values");
+  lua_pushinteger (L, g_atomic_int_get (&record_value_bytes));
+  lua_setfield (L, -2, "value_bytes");
+  lua_pushlightuserdata (L, &parent_cache);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  for (count = 0, lua_pushnil (L); lua_next (L, -2) != 0; count++)
+    lua_pop (L, 1);
+  lua_pop (L, 1);
+  lua_pushinteger (L, count);
+  lua_setfield (L, -2, "parents");
+  return 2;
+}
+
 static const struct luaL_Reg record_api_reg[] = {
   { "new", record_new },
   { "query", record_query },
@@ -720,6 +1145,8 @@ static const struct luaL_Reg record_api_reg[] = {
   { "cast", record_cast },
   { "fromarray", record_fromarray },
   { "set", record_set },
+  { "array", record_array },
+  { "stats", record_stats },
   { NULL, NULL }
 };
 
@@ -750,9 +1177,16 @@ lgi_record_init (lua_State *L)
   luaL_register (L, NULL, record_meta_reg);
   lua_rawset (L, LUA_REGISTRYINDEX);
 
+  /* Register record array metatable. */
+  lua_pushlightuserdata (L, &record_array_mt);
+  lua_newtable (L);
+  luaL_register (L, NULL, record_array_meta_reg);
+  lua_rawset (L, LUA_REGISTRYINDEX);
+
   /* Create caches. */
   lgi_cache_create (L, &record_cache, "v");
   lgi_cache_create (L, &parent_cache, "k");
+  lgi_cache_create (L, &record_array_cursors, "kv");
 
   /* Create 'record' API table in main core API table. */
   lua_newtable (L);
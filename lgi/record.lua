@@ -34,6 +34,12 @@ function record.struct_mt:is_type_of(instance)
    return false
 end
 
+-- Creates contiguous array of records of this type, init is either
+-- count of elements or table with initial values of the elements.
+function record.struct_mt:array(init)
+   return core.record.array(self, init)
+end
+
 -- Resolver for records, recursively resolves also all parents.
 function record.struct_mt:_resolve(recursive)
    -- Resolve itself using inherited implementation.
@@ -186,8 +192,10 @@ function record.load(info)
    local record = component.create(
       info, info.is_struct and record.struct_mt or record.union_mt)
    record._size = info.size
-   record._method = component.get_category(info.methods, core.callable.new)
-   record._field = component.get_category(info.fields)
+   record._method = component.get_category(
+      info.methods, core.callable.new, nil, nil, info.fullname .. ':methods')
+   record._field = component.get_category(
+      info.fields, core.marshal.field, nil, nil, info.fullname .. ':fields')
 
    -- Check, whether global namespace contains 'constructor' method,
    -- i.e. method which has the same name as our record type (except
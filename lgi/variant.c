@@ -0,0 +1,1193 @@
+/*
+ * Dynamic Lua binding to GObject using dynamic gobject-introspection.
+ *
+ * Copyright (c) 2026 lgi contributors
+ * Licensed under the MIT license:
+ * http://www.opensource.org/licenses/mit-license.php
+ *
+ * Native GVariant serialization driven by compiled format plans and
+ * lazy zero-copy reading of serialized variants.
+ */
+
+#include <string.h>
+#include "lgi.h"
+
+/* lightuserdata key to registry, containing table which maps format
+   strings to compiled VariantPlan userdata. */
+static int plans;
+
+/* lightuserdata key to registry for metatable of VariantPlan. */
+static int plan_mt;
+
+/* Metatable name of lazy variant views. */
+#define LGI_VARIANT_VIEW "lgi.variant.view"
+
+/* Lazy view of container variant.  Its env table memoizes results of
+   dictionary lookups. */
+typedef struct _VariantView
+{
+  GVariant *variant;
+} VariantView;
+
+/* Special node kinds, which are not plain GVariant type characters. */
+enum {
+  /* Array of fixed-size basic elements, filled in bulk. */
+  VARIANT_NODE_FIXED_ARRAY = 'A',
+
+  /* Array of dictionary entries, mapped to Lua table keys. */
+  VARIANT_NODE_DICT = 'D'
+};
+
+/* Single node of compiled plan.  Nodes are stored in pre-order,
+   children of the node start right after it and 'end' is the index
+   of the first node following the whole subtree. */
+typedef struct _VariantNode
+{
+  /* GVariant type character of the node or one of VARIANT_NODE_xxx. */
+  gchar kind;
+
+  /* Size of elements of VARIANT_NODE_FIXED_ARRAY. */
+  guint8 elem_size;
+
+  /* Typetag used to marshal scalars and fixed array elements. */
+  GITypeTag tag;
+
+  /* Index of the node following this subtree. */
+  guint end;
+
+  /* Owned type of the value produced by this node. */
+  GVariantType *type;
+} VariantNode;
+
+/* Compiled plan, allocated with enough nodes for its format. */
+typedef struct _VariantPlan
+{
+  guint n_nodes;
+  VariantNode nodes[1];
+} VariantPlan;
+
+/* Floating variants built so far by the running serialization.  It is
+   owned by a guard, so that already built children are released when
+   an error interrupts the serialization. */
+typedef struct _VariantStack
+{
+  GVariant **items;
+  gsize len, alloc;
+} VariantStack;
+
+/* State of single serialization. */
+typedef struct _VariantBuild
+{
+  const char *format;
+  VariantPlan *plan;
+  VariantStack *stack;
+} VariantBuild;
+
+/* Returns typetag of fixed-size basic type character, GI_TYPE_TAG_VOID
+   for other characters. */
+static GITypeTag
+variant_fixed_tag (gchar type, guint8 *size)
+{
+  switch (type)
+    {
+#define TYPE_CASE(c, t, s)			\
+      case c: *size = s; return GI_TYPE_TAG_ ## t
+
+      TYPE_CASE ('b', BOOLEAN, 1);
+      TYPE_CASE ('y', UINT8, 1);
+      TYPE_CASE ('n', INT16, 2);
+      TYPE_CASE ('q', UINT16, 2);
+      TYPE_CASE ('i', INT32, 4);
+      TYPE_CASE ('u', UINT32, 4);
+      TYPE_CASE ('x', INT64, 8);
+      TYPE_CASE ('t', UINT64, 8);
+      TYPE_CASE ('d', DOUBLE, 8);
+#undef TYPE_CASE
+
+    default:
+      *size = 0;
+      return GI_TYPE_TAG_VOID;
+    }
+}
+
+/* Maximal nesting of containers in the format, the same as GVariant
+   itself allows. */
+#define VARIANT_MAX_DEPTH 128
+
+/* Compiles single complete type starting at format into the plan.
+   Returns pointer after the parsed type or NULL if the format is not
+   valid or nested deeper than VARIANT_MAX_DEPTH.  Every node consumes
+   at least one character of the format, so the plan never needs more
+   nodes than the length of the format. */
+static const char *
+variant_plan_parse (VariantPlan *plan, const char *format, gboolean basic,
+		    int depth)
+{
+  guint index;
+  VariantNode *node;
+  const char *start = format;
+  gchar t = *format++;
+
+  /* Truncated format must not claim a node past the end of the
+     plan. */
+  if (t == '\0' || depth > VARIANT_MAX_DEPTH)
+    return NULL;
+
+  index = plan->n_nodes++;
+  node = &plan->nodes[index];
+
+  node->kind = t;
+  node->tag = variant_fixed_tag (t, &node->elem_size);
+  node->type = NULL;
+  if (node->tag == GI_TYPE_TAG_VOID && t != 's' && t != 'o' && t != 'g')
+    {
+      if (basic)
+	return NULL;
+      else if (t == 'v')
+	;
+      else if (t == 'a' || t == 'm')
+	{
+	  VariantNode *child = &plan->nodes[index + 1];
+	  format = variant_plan_parse (plan, format, FALSE, depth + 1);
+	  if (format == NULL)
+	    return NULL;
+	  if (t == 'a' && child->tag != GI_TYPE_TAG_VOID)
+	    {
+	      node->kind = VARIANT_NODE_FIXED_ARRAY;
+	      node->tag = child->tag;
+	      node->elem_size = child->elem_size;
+	    }
+	  else if (t == 'a' && child->kind == '{')
+	    node->kind = VARIANT_NODE_DICT;
+	}
+      else if (t == '{')
+	{
+	  format = variant_plan_parse (plan, format, TRUE, depth + 1);
+	  if (format != NULL)
+	    format = variant_plan_parse (plan, format, FALSE, depth + 1);
+	  if (format == NULL || *format++ != '}')
+	    return NULL;
+	}
+      else if (t == '(')
+	{
+	  while (*format != ')')
+	    {
+	      format = variant_plan_parse (plan, format, FALSE, depth + 1);
+	      if (format == NULL)
+		return NULL;
+	    }
+	  format++;
+	}
+      else
+	return NULL;
+    }
+
+  /* Validated type string is directly usable as GVariantType; its
+     extent is already known, so it is not rescanned. */
+  node->type = (GVariantType *) g_strndup (start, format - start);
+  node->end = plan->n_nodes;
+  return format;
+}
+
+static int
+variant_plan_gc (lua_State *L)
+{
+  VariantPlan *plan = lua_touserdata (L, 1);
+  guint i;
+  for (i = 0; i < plan->n_nodes; i++)
+    if (plan->nodes[i].type != NULL)
+      g_variant_type_free (plan->nodes[i].type);
+  return 0;
+}
+
+/* Retrieves compiled plan for given format, compiling and caching it
+   on the first request.  Returns NULL if the format is invalid. */
+static VariantPlan *
+variant_plan_get (lua_State *L, const char *format)
+{
+  VariantPlan *plan;
+  size_t len = strlen (format);
+  const char *end;
+
+  luaL_checkstack (L, 4, "");
+  lua_pushlightuserdata (L, &plans);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_getfield (L, -1, format);
+  plan = lua_touserdata (L, -1);
+  if (plan != NULL || len == 0)
+    {
+      lua_pop (L, 2);
+      return plan;
+    }
+
+  /* Every node consumes at least one character of the format. */
+  lua_pop (L, 1);
+  plan = lua_newuserdata (L, G_STRUCT_OFFSET (VariantPlan, nodes)
+			  + len * sizeof (VariantNode));
+  plan->n_nodes = 0;
+  lua_pushlightuserdata (L, &plan_mt);
+  lua_rawget (L, LUA_REGISTRYINDEX);
+  lua_setmetatable (L, -2);
+  end = variant_plan_parse (plan, format, FALSE, 0);
+  if (end == NULL || *end != '\0')
+    {
+      lua_pop (L, 2);
+      return NULL;
+    }
+
+  lua_setfield (L, -2, format);
+  lua_pop (L, 1);
+  return plan;
+}
+
+static void
+variant_stack_free (VariantStack *stack)
+{
+  while (stack->len > 0)
+    g_variant_unref (stack->items[--stack->len]);
+  g_free (stack->items);
+  g_free (stack);
+}
+
+static void
+variant_stack_push (VariantStack *stack, GVariant *variant)
+{
+  if (stack->len == stack->alloc)
+    {
+      stack->alloc = stack->alloc ? stack->alloc * 2 : 16;
+      stack->items = g_renew (GVariant *, stack->items, stack->alloc);
+    }
+  stack->items[stack->len++] = variant;
+}
+
+static void
+variant_error (lua_State *L, VariantBuild *build)
+{
+  luaL_error (L, "Variant.new(`%s') - invalid source value", build->format);
+}
+
+/* Returns number of elements of the array at narg, honoring 'n' field
+   of arrays with holes. */
+static gsize
+variant_array_len (lua_State *L, int narg)
+{
+  gsize len;
+  luaL_checktype (L, narg, LUA_TTABLE);
+  lua_getfield (L, narg, "n");
+  if (lua_isnumber (L, -1))
+    {
+      lua_Number n = lua_tonumber (L, -1);
+      luaL_argcheck (L, n >= 0 && n <= G_MAXINT, narg, "invalid array length");
+      len = (gsize) n;
+    }
+  else
+    len = lua_objlen (L, narg);
+  lua_pop (L, 1);
+  return len;
+}
+
+/* Creates fixed array variant from Lua value at narg. */
+static GVariant *
+variant_build_fixed (lua_State *L, VariantBuild *build, VariantNode *node,
+		     int narg)
+{
+  const GVariantType *elem_type = build->plan->nodes
+    [node - build->plan->nodes + 1].type;
+  gconstpointer data = NULL;
+  gsize len = 0, i;
+  guint8 *buffer;
+
+  if (node->tag == GI_TYPE_TAG_UINT8)
+    {
+      /* Bytestrings can be given as string or bytes buffers. */
+      if (lua_type (L, narg) == LUA_TSTRING)
+	data = lua_tolstring (L, narg, &len);
+      else if (lgi_udata_test (L, narg, LGI_BYTES_BUFFER))
+	{
+	  data = lua_touserdata (L, narg);
+	  len = lua_objlen (L, narg);
+	}
+      else
+	data = lgi_buffer_view_get (L, narg, &len);
+    }
+  else if (node->tag != GI_TYPE_TAG_BOOLEAN)
+    data = lgi_buffer_typed_get (L, narg, node->tag, &len);
+  if (data != NULL)
+    return g_variant_new_fixed_array (elem_type, data, len,
+				      node->elem_size);
+
+  /* Pack elements of the table into temporary Lua-owned buffer. */
+  len = variant_array_len (L, narg);
+  luaL_argcheck (L, len < G_MAXSIZE / node->elem_size, narg,
+		 "invalid array length");
+  buffer = lua_newuserdata (L, len * node->elem_size + 1);
+  for (i = 0; i < len; i++)
+    {
+      GIArgument arg;
+      lua_rawgeti (L, narg, i + 1);
+      lgi_marshal_2c_scalar (L, node->tag, &arg, -1, FALSE, 0);
+      if (node->tag == GI_TYPE_TAG_BOOLEAN)
+	buffer[i] = arg.v_boolean ? 1 : 0;
+      else
+	/* All members of GIArgument start at its beginning. */
+	memcpy (buffer + i * node->elem_size, &arg, node->elem_size);
+      lua_pop (L, 1);
+    }
+  lua_pop (L, 1);
+  return g_variant_new_fixed_array (elem_type, buffer, len, node->elem_size);
+}
+
+/* Builds variant described by the plan node at index from Lua value
+   at narg and pushes it to the build stack. */
+static void
+variant_build (lua_State *L, VariantBuild *build, guint index, int narg)
+{
+  VariantNode *node = &build->plan->nodes[index];
+  VariantStack *stack = build->stack;
+  GVariant *variant = NULL;
+  gsize base = stack->len, i;
+  guint child;
+
+  lgi_makeabs (L, narg);
+  luaL_checkstack (L, 4, "");
+  switch (node->kind)
+    {
+    case 'b': case 'y': case 'n': case 'q': case 'i': case 'u':
+    case 'x': case 't': case 'd':
+      {
+	GIArgument arg;
+	lgi_marshal_2c_scalar (L, node->tag, &arg, narg, FALSE, 0);
+	switch (node->kind)
+	  {
+	  case 'b': variant = g_variant_new_boolean (arg.v_boolean); break;
+	  case 'y': variant = g_variant_new_byte (arg.v_uint8); break;
+	  case 'n': variant = g_variant_new_int16 (arg.v_int16); break;
+	  case 'q': variant = g_variant_new_uint16 (arg.v_uint16); break;
+	  case 'i': variant = g_variant_new_int32 (arg.v_int32); break;
+	  case 'u': variant = g_variant_new_uint32 (arg.v_uint32); break;
+	  case 'x': variant = g_variant_new_int64 (arg.v_int64); break;
+	  case 't': variant = g_variant_new_uint64 (arg.v_uint64); break;
+	  case 'd': variant = g_variant_new_double (arg.v_double); break;
+	  }
+	break;
+      }
+
+    case 's':
+    case 'o':
+    case 'g':
+      {
+	size_t len;
+	const char *str;
+	if (lua_type (L, narg) != LUA_TSTRING && !lua_isnumber (L, narg))
+	  variant_error (L, build);
+	str = lua_tolstring (L, narg, &len);
+	if (node->kind == 's' && g_utf8_validate (str, len, NULL))
+	  variant = g_variant_new_string (str);
+	else if (node->kind == 'o' && g_variant_is_object_path (str))
+	  variant = g_variant_new_object_path (str);
+	else if (node->kind == 'g' && g_variant_is_signature (str))
+	  variant = g_variant_new_signature (str);
+	else
+	  variant_error (L, build);
+	break;
+      }
+
+    case 'v':
+      {
+	GVariant *inner;
+	lgi_type_get_repotype (L, G_TYPE_VARIANT, NULL);
+	lgi_record_2c (L, narg, &inner, FALSE, FALSE, FALSE, FALSE);
+	variant = g_variant_new_variant (inner);
+	break;
+      }
+
+    case 'm':
+      if (lua_isnoneornil (L, narg))
+	variant = g_variant_new_maybe (build->plan->nodes[index + 1].type,
+				       NULL);
+      else
+	{
+	  variant_build (L, build, index + 1, narg);
+	  variant = g_variant_new_maybe (NULL, stack->items[--stack->len]);
+	}
+      break;
+
+    case VARIANT_NODE_FIXED_ARRAY:
+      variant = variant_build_fixed (L, build, node, narg);
+      break;
+
+    case VARIANT_NODE_DICT:
+      {
+	/* Map keys of the Lua table directly to dictionary entries.
+	   Keys are converted from their copies, so that the
+	   conversion does not disturb lua_next(). */
+	guint entry = index + 1, key = entry + 1;
+	guint value = build->plan->nodes[key].end;
+	luaL_checktype (L, narg, LUA_TTABLE);
+	lua_pushnil (L);
+	while (lua_next (L, narg) != 0)
+	  {
+	    GVariant *k, *v;
+	    lua_pushvalue (L, -2);
+	    variant_build (L, build, key, -1);
+	    variant_build (L, build, value, -2);
+	    lua_pop (L, 2);
+	    v = stack->items[--stack->len];
+	    k = stack->items[--stack->len];
+	    variant_stack_push (stack, g_variant_new_dict_entry (k, v));
+	  }
+	variant = g_variant_new_array (build->plan->nodes[entry].type,
+				       stack->items + base,
+				       stack->len - base);
+	stack->len = base;
+	break;
+      }
+
+    case 'a':
+      {
+	gsize len = variant_array_len (L, narg);
+	for (i = 0; i < len; i++)
+	  {
+	    lua_rawgeti (L, narg, i + 1);
+	    variant_build (L, build, index + 1, -1);
+	    lua_pop (L, 1);
+	  }
+	variant = g_variant_new_array (build->plan->nodes[index + 1].type,
+				       stack->items + base, len);
+	stack->len = base;
+	break;
+      }
+
+    case '(':
+    case '{':
+      if (index + 1 < node->end)
+	luaL_checktype (L, narg, LUA_TTABLE);
+      for (i = 1, child = index + 1; child < node->end;
+	   i++, child = build->plan->nodes[child].end)
+	{
+	  lua_rawgeti (L, narg, i);
+	  variant_build (L, build, child, -1);
+	  lua_pop (L, 1);
+	}
+      if (node->kind == '(')
+	variant = g_variant_new_tuple (stack->items + base,
+				       stack->len - base);
+      else
+	variant = g_variant_new_dict_entry (stack->items[base],
+					    stack->items[base + 1]);
+      stack->len = base;
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  variant_stack_push (stack, variant);
+}
+
+GVariant *
+lgi_variant_2c (lua_State *L, const char *format, int narg)
+{
+  VariantBuild build;
+  GVariant *variant;
+
+  lgi_makeabs (L, narg);
+  build.format = format;
+  build.plan = variant_plan_get (L, format);
+  if (build.plan == NULL)
+    luaL_error (L, "Variant.new(`%s') - invalid type", format);
+
+  /* Create the build stack, guarded for the case of errors. */
+  build.stack = g_new0 (VariantStack, 1);
+  *lgi_guard_create (L, (GDestroyNotify) variant_stack_free) = build.stack;
+  variant_build (L, &build, 0, narg);
+  variant = build.stack->items[--build.stack->len];
+  lua_pop (L, 1);
+  return variant;
+}
+
+/* Creates new variant from format and Lua value.  Lua-side prototype:
+   variant = core.variant.new(format, value) */
+static int
+variant_new (lua_State *L)
+{
+  GVariant *variant = lgi_variant_2c (L, luaL_checkstring (L, 1), 2);
+  lgi_type_get_repotype (L, G_TYPE_VARIANT, NULL);
+  lgi_record_2lua (L, variant, FALSE, 0);
+  return 1;
+}
+
+/* Checks whether given format is valid type format, compiling its
+   plan.  Lua-side prototype:
+   ok = core.variant.compile(format) */
+static int
+variant_compile (lua_State *L)
+{
+  lua_pushboolean (L, variant_plan_get (L, luaL_checkstring (L, 1)) != NULL);
+  return 1;
+}
+
+/* Pushes basic variant value to the stack, returns FALSE if the
+   variant is not basic. */
+static gboolean
+variant_push_basic (lua_State *L, GVariant *variant)
+{
+  GIArgument arg;
+  GITypeTag tag;
+  guint8 size;
+  gchar type = g_variant_classify (variant);
+  switch (type)
+    {
+    case G_VARIANT_CLASS_BOOLEAN:
+      arg.v_boolean = g_variant_get_boolean (variant); break;
+    case G_VARIANT_CLASS_BYTE: arg.v_uint8 = g_variant_get_byte (variant); break;
+    case G_VARIANT_CLASS_INT16: arg.v_int16 = g_variant_get_int16 (variant); break;
+    case G_VARIANT_CLASS_UINT16:
+      arg.v_uint16 = g_variant_get_uint16 (variant); break;
+    case G_VARIANT_CLASS_INT32: arg.v_int32 = g_variant_get_int32 (variant); break;
+    case G_VARIANT_CLASS_UINT32:
+      arg.v_uint32 = g_variant_get_uint32 (variant); break;
+    case G_VARIANT_CLASS_INT64: arg.v_int64 = g_variant_get_int64 (variant); break;
+    case G_VARIANT_CLASS_UINT64:
+      arg.v_uint64 = g_variant_get_uint64 (variant); break;
+    case G_VARIANT_CLASS_DOUBLE:
+      arg.v_double = g_variant_get_double (variant); break;
+    case G_VARIANT_CLASS_HANDLE:
+      lua_pushinteger (L, g_variant_get_handle (variant));
+      return TRUE;
+
+    case G_VARIANT_CLASS_STRING:
+    case G_VARIANT_CLASS_OBJECT_PATH:
+    case G_VARIANT_CLASS_SIGNATURE:
+      {
+	gsize len;
+	const gchar *str = g_variant_get_string (variant, &len);
+	lua_pushlstring (L, str, len);
+	return TRUE;
+      }
+
+    default:
+      return FALSE;
+    }
+
+  tag = variant_fixed_tag (type, &size);
+  lgi_marshal_2lua_scalar (L, tag, &arg, 0);
+  return TRUE;
+}
+
+/* Pushes array of fixed-size elements as zero-copy buffer owning the
+   variant.  Returns FALSE if the array cannot be represented this
+   way. */
+static gboolean
+variant_push_fixed (lua_State *L, GVariant *variant)
+{
+  const gchar *type = g_variant_get_type_string (variant);
+  gconstpointer data;
+  GITypeTag tag;
+  guint8 size;
+  gsize len;
+
+  tag = variant_fixed_tag (type[1], &size);
+  if (tag == GI_TYPE_TAG_VOID || tag == GI_TYPE_TAG_BOOLEAN)
+    return FALSE;
+
+  data = g_variant_get_fixed_array (variant, &len, size);
+  if (tag == GI_TYPE_TAG_UINT8)
+    lgi_buffer_view_new (L, data, len, variant,
+			 (GDestroyNotify) g_variant_unref);
+  else if (lgi_buffer_typed_new (L, tag, (gpointer) data, len, variant,
+				 (GDestroyNotify) g_variant_unref))
+    lgi_buffer_typed_freeze (L, -1);
+  else
+    return FALSE;
+  return TRUE;
+}
+
+void
+lgi_variant_2lua (lua_State *L, GVariant *variant)
+{
+  VariantView *view;
+
+  luaL_checkstack (L, 4, "");
+  while (variant != NULL)
+    {
+      GVariant *inner;
+      if (variant_push_basic (L, variant))
+	break;
+
+      switch (g_variant_classify (variant))
+	{
+	case G_VARIANT_CLASS_VARIANT:
+	  /* Views look through boxed variants. */
+	  inner = g_variant_get_variant (variant);
+	  break;
+
+	case G_VARIANT_CLASS_MAYBE:
+	  inner = g_variant_get_maybe (variant);
+	  if (inner == NULL)
+	    lua_pushnil (L);
+	  break;
+
+	case G_VARIANT_CLASS_ARRAY:
+	  if (variant_push_fixed (L, variant))
+	    /* The buffer took over our reference. */
+	    return;
+
+	  /* Fall through. */
+	default:
+	  view = lua_newuserdata (L, sizeof (VariantView));
+	  view->variant = variant;
+	  luaL_getmetatable (L, LGI_VARIANT_VIEW);
+	  lua_setmetatable (L, -2);
+	  lua_newtable (L);
+	  lua_setfenv (L, -2);
+	  return;
+	}
+
+      g_variant_unref (variant);
+      variant = inner;
+    }
+
+  if (variant != NULL)
+    g_variant_unref (variant);
+}
+
+static VariantView *
+variant_view_check (lua_State *L, int narg)
+{
+  return luaL_checkudata (L, narg, LGI_VARIANT_VIEW);
+}
+
+/* lightuserdata key to the env table of dictionary view, containing
+   table mapping Lua keys to child indices. */
+static int variant_view_keys;
+
+/* Looks up value of dictionary entry with given key, returns new
+   reference to the value or NULL if not found.  The table mapping
+   keys to indices is built on the first lookup and stored into the
+   view env table at 'env', so that lookups are not linear scans. */
+static GVariant *
+variant_view_lookup (lua_State *L, GVariant *dict, int narg, int env)
+{
+  GVariant *entry, *value = NULL;
+  gsize i, n;
+
+  luaL_checkstack (L, 4, "");
+  lua_pushlightuserdata (L, &variant_view_keys);
+  lua_rawget (L, env);
+  if (lua_isnil (L, -1))
+    {
+      lua_pop (L, 1);
+      n = g_variant_n_children (dict);
+      lua_createtable (L, 0, n);
+      for (i = 0; i < n; i++)
+	{
+	  entry = g_variant_get_child_value (dict, i);
+	  value = g_variant_get_child_value (entry, 0);
+	  variant_push_basic (L, value);
+	  g_variant_unref (value);
+	  g_variant_unref (entry);
+
+	  /* Skip NaN keys, which cannot be looked up anyway, and keep
+	     the first one of duplicate keys. */
+	  lua_pushvalue (L, -1);
+	  if (!lua_rawequal (L, -1, -2))
+	    lua_pop (L, 2);
+	  else
+	    {
+	      lua_rawget (L, -3);
+	      if (!lua_isnil (L, -1))
+		lua_pop (L, 2);
+	      else
+		{
+		  lua_pop (L, 1);
+		  lua_pushinteger (L, i);
+		  lua_rawset (L, -3);
+		}
+	    }
+	}
+      lua_pushlightuserdata (L, &variant_view_keys);
+      lua_pushvalue (L, -2);
+      lua_rawset (L, env);
+      value = NULL;
+    }
+
+  lua_pushvalue (L, narg);
+  lua_rawget (L, -2);
+  if (lua_type (L, -1) == LUA_TNUMBER)
+    {
+      entry = g_variant_get_child_value (dict, lua_tointeger (L, -1));
+      value = g_variant_get_child_value (entry, 1);
+      g_variant_unref (entry);
+    }
+  lua_pop (L, 2);
+  return value;
+}
+
+static gboolean
+variant_view_is_dict (VariantView *view)
+{
+  const gchar *type = g_variant_get_type_string (view->variant);
+  return type[0] == 'a' && type[1] == '{';
+}
+
+static int
+variant_view_index (lua_State *L)
+{
+  VariantView *view = variant_view_check (L, 1);
+  GVariant *child = NULL;
+
+  if (variant_view_is_dict (view))
+    {
+      /* Return memoized value, if available. */
+      lua_getfenv (L, 1);
+      lua_pushvalue (L, 2);
+      lua_rawget (L, -2);
+      if (!lua_isnil (L, -1))
+	return 1;
+
+      lua_pop (L, 1);
+      child = variant_view_lookup (L, view->variant, 2, lua_gettop (L));
+      if (child == NULL)
+	return 0;
+      lgi_variant_2lua (L, child);
+      lua_pushvalue (L, 2);
+      lua_pushvalue (L, -2);
+      lua_rawset (L, -4);
+      return 1;
+    }
+  else if (lua_type (L, 2) == LUA_TNUMBER)
+    {
+      lua_Integer index = lua_tointeger (L, 2);
+      if (index > 0 && (gsize) index <= g_variant_n_children (view->variant))
+	child = g_variant_get_child_value (view->variant, index - 1);
+    }
+
+  if (child == NULL)
+    return 0;
+  lgi_variant_2lua (L, child);
+  return 1;
+}
+
+static int
+variant_view_len (lua_State *L)
+{
+  VariantView *view = variant_view_check (L, 1);
+  lua_pushinteger (L, g_variant_n_children (view->variant));
+  return 1;
+}
+
+static int
+variant_view_gc (lua_State *L)
+{
+  VariantView *view = variant_view_check (L, 1);
+  g_variant_unref (view->variant);
+  view->variant = NULL;
+  return 0;
+}
+
+static int
+variant_view_tostring (lua_State *L)
+{
+  VariantView *view = variant_view_check (L, 1);
+  lua_pushfstring (L, "lgi.variant.view %s: %p",
+		   g_variant_get_type_string (view->variant), view->variant);
+  return 1;
+}
+
+/* Iterator over the view, yields index and child for arrays and
+   tuples, key and value for dictionaries. */
+static int
+variant_view_next (lua_State *L)
+{
+  VariantView *view = variant_view_check (L, 1);
+  gsize index = lua_tointeger (L, lua_upvalueindex (1));
+  GVariant *child;
+
+  if (index >= g_variant_n_children (view->variant))
+    return 0;
+
+  lua_pushinteger (L, index + 1);
+  lua_replace (L, lua_upvalueindex (1));
+  child = g_variant_get_child_value (view->variant, index);
+  if (variant_view_is_dict (view))
+    {
+      lgi_variant_2lua (L, g_variant_get_child_value (child, 0));
+      lgi_variant_2lua (L, g_variant_get_child_value (child, 1));
+      g_variant_unref (child);
+    }
+  else
+    {
+      lua_pushinteger (L, index + 1);
+      lgi_variant_2lua (L, child);
+    }
+  return 2;
+}
+
+static int
+variant_view_pairs (lua_State *L)
+{
+  variant_view_check (L, 1);
+  lua_pushinteger (L, 0);
+  lua_pushcclosure (L, variant_view_next, 1);
+  lua_pushvalue (L, 1);
+  lua_pushnil (L);
+  return 3;
+}
+
+static const struct luaL_Reg variant_view_mt_reg[] = {
+  { "__index", variant_view_index },
+  { "__len", variant_view_len },
+  { "__gc", variant_view_gc },
+  { "__tostring", variant_view_tostring },
+  { "__pairs", variant_view_pairs },
+  { "__ipairs", variant_view_pairs },
+  { NULL, NULL }
+};
+
+/* Creates lazy view of the variant.  Lua-side prototype:
+   value = core.variant.view(variant) */
+static int
+variant_view (lua_State *L)
+{
+  GVariant *variant;
+  lgi_type_get_repotype (L, G_TYPE_VARIANT, NULL);
+  lgi_record_2c (L, 1, &variant, FALSE, FALSE, FALSE, FALSE);
+  lgi_variant_2lua (L, g_variant_ref (variant));
+  return 1;
+}
+
+/* Creates new floating tuple of given tuple format from consecutive
+   Lua values starting at narg, one value for every tuple member. */
+static GVariant *
+variant_2c_tuple (lua_State *L, const char *format, int narg)
+{
+  VariantBuild build;
+  GVariant *variant;
+  guint child;
+  int i;
+
+  lgi_makeabs (L, narg);
+  build.format = format;
+  build.plan = variant_plan_get (L, format);
+  if (build.plan == NULL || build.plan->nodes[0].kind != '(')
+    luaL_error (L, "Variant.new(`%s') - invalid tuple type", format);
+
+  build.stack = g_new0 (VariantStack, 1);
+  *lgi_guard_create (L, (GDestroyNotify) variant_stack_free) = build.stack;
+  for (i = 0, child = 1; child < build.plan->nodes[0].end;
+       i++, child = build.plan->nodes[child].end)
+    variant_build (L, &build, child, narg + i);
+  variant = g_variant_new_tuple (build.stack->items, build.stack->len);
+  build.stack->len = 0;
+  lua_pop (L, 1);
+  return variant;
+}
+
+/* Layout of GDBusInterfaceVTable; lgi does not depend on gio
+   headers, so gio types are passed around as plain pointers. */
+typedef struct _DBusVTable
+{
+  void (*method_call) (gpointer connection, const gchar *sender,
+		       const gchar *object_path, const gchar *interface_name,
+		       const gchar *method_name, GVariant *parameters,
+		       gpointer invocation, gpointer user_data);
+  gpointer get_property;
+  gpointer set_property;
+  gpointer padding[8];
+} DBusVTable;
+
+/* Dispatcher of method calls of single exported interface.  It is
+   owned by GDBus as user_data of the registration, so it is allocated
+   outside of Lua.  Its Lua side is the handle userdata, whose env
+   table contains the table of methods at 1 and the thread used for
+   calling handlers at 2, kept alive by registry reference for the
+   time the interface is registered.  When the state is closed while
+   the interface is still registered, the handle is collected and the
+   dispatcher is marked closed; it then only refuses method calls and
+   is freed when the interface is unregistered. */
+typedef struct _DBusDispatch
+{
+  DBusVTable vtable;
+
+  /* Resolved gio functions completing the invocation. */
+  void (*return_value) (gpointer invocation, GVariant *parameters);
+  void (*return_dbus_error) (gpointer invocation, const gchar *name,
+			     const gchar *message);
+  void (*return_gerror) (gpointer invocation, const GError *error);
+
+  /* Thread for handlers, its state lock and reference of the
+     dispatcher in the registry, LUA_NOREF when released. */
+  lua_State *L;
+  gpointer state_lock;
+  int ref;
+
+  /* Set when the state owning the dispatcher was closed. */
+  gboolean closed;
+} DBusDispatch;
+
+#define UD_DBUS_DISPATCH "lgi.dbus.dispatch"
+
+/* Collects the handle, which happens only when the state is closed
+   or after the dispatcher was released. */
+static int
+variant_dbus_handle_gc (lua_State *L)
+{
+  DBusDispatch **handle = lua_touserdata (L, 1);
+  if (*handle != NULL)
+    {
+      (*handle)->closed = TRUE;
+      *handle = NULL;
+    }
+  return 0;
+}
+
+/* Protected part of the method call dispatch.  Decodes parameters
+   directly to the stack, calls the handler and encodes its results
+   into the reply.  Stack: dispatch, method_name, parameters,
+   invocation. */
+static int
+variant_dbus_call (lua_State *L)
+{
+  DBusDispatch *dispatch = lua_touserdata (L, 1);
+  GVariant *parameters = lua_touserdata (L, 3);
+  gpointer invocation = lua_touserdata (L, 4);
+  gsize i, n = g_variant_n_children (parameters);
+  GVariant *reply;
+
+  /* Find method { handler, reply_format } entry. */
+  lua_rawgeti (L, LUA_REGISTRYINDEX, dispatch->ref);
+  lua_getfenv (L, -1);
+  lua_rawgeti (L, -1, 1);
+  lua_pushvalue (L, 2);
+  lua_rawget (L, -2);
+  lua_replace (L, 5);
+  lua_settop (L, 5);
+  if (!lua_istable (L, 5))
+    {
+      dispatch->return_dbus_error (invocation,
+				   "org.freedesktop.DBus.Error.UnknownMethod",
+				   lua_tostring (L, 2));
+      return 0;
+    }
+
+  lua_rawgeti (L, 5, 2);
+  lua_rawgeti (L, 5, 1);
+  luaL_checkstack (L, n, "");
+  for (i = 0; i < n; i++)
+    lgi_variant_2lua (L, g_variant_get_child_value (parameters, i));
+  lua_call (L, n, LUA_MULTRET);
+  reply = variant_2c_tuple (L, lua_tostring (L, 6), 7);
+  dispatch->return_value (invocation, reply);
+  return 0;
+}
+
+/* Completes the invocation with error on the top of the stack;
+   GLib.Error instances are passed as they are, other errors are
+   reported as org.freedesktop.DBus.Error.Failed. */
+static void
+variant_dbus_error (lua_State *L, DBusDispatch *dispatch, gpointer invocation)
+{
+  GError *err = NULL;
+  const gchar *message;
+
+  lgi_type_get_repotype (L, G_TYPE_ERROR, NULL);
+  lgi_record_2c (L, -2, &err, FALSE, FALSE, TRUE, TRUE);
+  lua_pop (L, 1);
+  if (err != NULL)
+    dispatch->return_gerror (invocation, err);
+  else
+    {
+      message = lua_tostring (L, -1);
+      dispatch->return_dbus_error (invocation,
+				   "org.freedesktop.DBus.Error.Failed",
+				   message ? message : "(error object)");
+    }
+}
+
+static void
+variant_dbus_method_call (gpointer connection, const gchar *sender,
+			  const gchar *object_path,
+			  const gchar *interface_name,
+			  const gchar *method_name, GVariant *parameters,
+			  gpointer invocation, gpointer user_data)
+{
+  DBusDispatch *dispatch = user_data;
+  lua_State *L;
+  (void) connection;
+  (void) sender;
+  (void) object_path;
+  (void) interface_name;
+
+  if (dispatch->closed)
+    {
+      dispatch->return_dbus_error (invocation,
+				   "org.freedesktop.DBus.Error.UnknownObject",
+				   "object handler was closed");
+      return;
+    }
+
+  lgi_state_enter (dispatch->state_lock);
+  L = dispatch->L;
+  luaL_checkstack (L, 5, "");
+  lua_pushcfunction (L, variant_dbus_call);
+  lua_pushlightuserdata (L, dispatch);
+  lua_pushstring (L, method_name);
+  lua_pushlightuserdata (L, parameters);
+  lua_pushlightuserdata (L, invocation);
+  if (lua_pcall (L, 4, 0, 0) != 0)
+    {
+      variant_dbus_error (L, dispatch, invocation);
+      lua_pop (L, 1);
+    }
+  lgi_state_leave (dispatch->state_lock);
+}
+
+/* Releases the handle of the dispatcher, unless its state was
+   already closed. */
+static void
+variant_dbus_unref (lua_State *L, DBusDispatch *dispatch)
+{
+  if (dispatch->closed || dispatch->ref == LUA_NOREF)
+    return;
+  lua_rawgeti (L, LUA_REGISTRYINDEX, dispatch->ref);
+  *(DBusDispatch **) lua_touserdata (L, -1) = NULL;
+  lua_pop (L, 1);
+  luaL_unref (L, LUA_REGISTRYINDEX, dispatch->ref);
+  dispatch->ref = LUA_NOREF;
+}
+
+/* Frees the dispatcher when the interface is unregistered. */
+static void
+variant_dbus_release (gpointer user_data)
+{
+  DBusDispatch *dispatch = user_data;
+  gpointer state_lock = dispatch->state_lock;
+
+  if (!dispatch->closed)
+    {
+      lgi_state_enter (state_lock);
+      variant_dbus_unref (dispatch->L, dispatch);
+      lgi_state_leave (state_lock);
+    }
+  g_free (dispatch);
+}
+
+/* Registers interface of exported object, whose method calls are
+   dispatched natively to Lua handlers.  Lua-side prototype:
+   id, err = core.variant.dbus_register(funcs, connection, path, info,
+					 methods)
+   'funcs' contains addresses of gio functions 'register',
+   'return_value', 'return_dbus_error' and 'return_gerror',
+   'connection' and 'info' are addresses of GDBusConnection and
+   GDBusInterfaceInfo and 'methods' maps method names to
+   { handler, reply_format } tables. */
+static int
+variant_dbus_register (lua_State *L)
+{
+  guint (*reg) (gpointer connection, const gchar *path, gpointer info,
+		const DBusVTable *vtable, gpointer user_data,
+		GDestroyNotify user_data_free, GError **error);
+  gpointer connection = lua_touserdata (L, 2);
+  const gchar *path = luaL_checkstring (L, 3);
+  gpointer info = lua_touserdata (L, 4);
+  DBusDispatch *dispatch, **handle;
+  gpointer *guard;
+  GError *err = NULL;
+  guint id;
+
+  luaL_checktype (L, 1, LUA_TTABLE);
+  luaL_checktype (L, 5, LUA_TTABLE);
+  luaL_argcheck (L, connection != NULL, 2, "connection expected");
+  luaL_argcheck (L, info != NULL, 4, "interface info expected");
+  lua_settop (L, 5);
+  lua_getfield (L, 1, "register");
+  reg = lua_touserdata (L, -1);
+  lua_pop (L, 1);
+  luaL_argcheck (L, reg != NULL, 1, "register function expected");
+
+  /* Create the dispatcher, guarded until it is registered. */
+  dispatch = g_new0 (DBusDispatch, 1);
+  dispatch->ref = LUA_NOREF;
+  guard = lgi_guard_create (L, g_free);
+  *guard = dispatch;
+  dispatch->vtable.method_call = variant_dbus_method_call;
+#define GET_FUNC(name)					\
+  lua_getfield (L, 1, #name);				\
+  *(gpointer *) &dispatch->name = lua_touserdata (L, -1);	\
+  lua_pop (L, 1);					\
+  luaL_argcheck (L, dispatch->name != NULL, 1, #name " expected")
+  GET_FUNC (return_value);
+  GET_FUNC (return_dbus_error);
+  GET_FUNC (return_gerror);
+#undef GET_FUNC
+  dispatch->state_lock = lgi_state_get_lock (L);
+  handle = lua_newuserdata (L, sizeof (DBusDispatch *));
+  *handle = dispatch;
+  luaL_getmetatable (L, UD_DBUS_DISPATCH);
+  lua_setmetatable (L, -2);
+  lua_createtable (L, 2, 0);
+  lua_pushvalue (L, 5);
+  lua_rawseti (L, -2, 1);
+  dispatch->L = lua_newthread (L);
+  lua_rawseti (L, -2, 2);
+  lua_setfenv (L, -2);
+  lua_pushvalue (L, -1);
+  dispatch->ref = luaL_ref (L, LUA_REGISTRYINDEX);
+
+  /* From now on, the dispatcher is owned by the registration. */
+  *guard = NULL;
+  id = reg (connection, path, info, &dispatch->vtable, dispatch,
+	    variant_dbus_release, &err);
+  if (id == 0)
+    {
+      /* Some gio versions release user_data on failure, some do not;
+	 the release clears the handle. */
+      if (*handle != NULL)
+	variant_dbus_release (*handle);
+      lua_pushnil (L);
+      lgi_type_get_repotype (L, G_TYPE_ERROR, NULL);
+      lgi_record_2lua (L, err, TRUE, 0);
+      return 2;
+    }
+
+  lua_pushnumber (L, id);
+  return 1;
+}
+
+static const struct luaL_Reg variant_api_reg[] = {
+  { "new", variant_new },
+  { "compile", variant_compile },
+  { "view", variant_view },
+  { "pairs", variant_view_pairs },
+  { "dbus_register", variant_dbus_register },
+  { NULL, NULL }
+};
+
+void
+lgi_variant_init (lua_State *L)
+{
+  /* Create cache of plans and metatable of plans. */
+  lgi_cache_create (L, &plans, NULL);
+  lua_pushlightuserdata (L, &plan_mt);
+  lua_newtable (L);
+  lua_pushcfunction (L, variant_plan_gc);
+  lua_setfield (L, -2, "__gc");
+  lua_rawset (L, LUA_REGISTRYINDEX);
+
+  /* Create metatable of views. */
+  luaL_newmetatable (L, LGI_VARIANT_VIEW);
+  luaL_register (L, NULL, variant_view_mt_reg);
+  lua_pop (L, 1);
+
+  /* Create metatable of handles of D-Bus dispatchers. */
+  luaL_newmetatable (L, UD_DBUS_DISPATCH);
+  lua_pushcfunction (L, variant_dbus_handle_gc);
+  lua_setfield (L, -2, "__gc");
+  lua_pop (L, 1);
+
+  /* Register variant API. */
+  lua_newtable (L);
+  luaL_register (L, NULL, variant_api_reg);
+  lua_setfield (L, -2, "variant");
+}
@@ -0,0 +1,191 @@
+--[[--------------------------------------------------------------------------
+
+  LGI benchmark suite.
+
+  Copyright (c) 2026 lgi contributors
+  Licensed under the MIT license:
+  http://www.opensource.org/licenses/mit-license.php
+
+  Usage: lua tests/bench.lua [options] [pattern...]
+
+    -o FILE        write JSON results into FILE instead of stdout
+    -c BASELINE    compare results against JSON file saved earlier,
+                   fail when any benchmark is slower than the baseline
+                   by more than the threshold
+    -t PERCENT     regression threshold for compare mode (default 25)
+    -r COUNT       number of measured repetitions (default 5)
+    -m MSEC        minimal duration of single repetition (default 50)
+
+  Only benchmarks whose names match any of given Lua patterns are run.
+
+--]]--------------------------------------------------------------------------
+
+local lgi = require 'lgi'
+local GLib = lgi.GLib
+local GObject = lgi.GObject
+local Gio = lgi.Gio
+local R = lgi.Regress
+
+local options = { threshold = 25, repetitions = 5, mintime = 50,
+		  patterns = {} }
+do
+   local i, flags = 1, { o = 'output', c = 'compare', t = 'threshold',
+			 r = 'repetitions', m = 'mintime' }
+   while arg[i] do
+      local flag = arg[i]:match('^%-(%a)$')
+      if flag then
+	 local key = flags[flag] or error('unknown option ' .. arg[i])
+	 i = i + 1
+	 options[key] = assert(arg[i], 'missing value of ' .. arg[i - 1])
+	 if key ~= 'output' and key ~= 'compare' then
+	    options[key] = assert(tonumber(options[key]))
+	 end
+      else
+	 options.patterns[#options.patterns + 1] = arg[i]
+      end
+      i = i + 1
+   end
+end
+
+-- Benchmarks, each of them is function performing single operation,
+-- optionally created by setup function.
+local benchmarks = {}
+local function bench(name, func)
+   benchmarks[#benchmarks + 1] = { name = name, func = func }
+end
+
+bench('call.scalar', function() R.test_int(42) end)
+bench('call.scalar_double', function() R.test_double(4.2) end)
+local ints = {}
+for i = 1, 100 do ints[i] = i end
+bench('array.in_100', function() R.test_array_int_in(ints) end)
+bench('array.out', function() R.test_array_int_out() end)
+bench('array.inout_100', function() R.test_array_int_inout(ints) end)
+local callback = function() return 42 end
+bench('closure.call_scope', function() R.test_callback(callback) end)
+bench('record.new', function() R.TestStructA() end)
+bench('object.new', function() R.TestObj() end)
+bench('object.new_props', function()
+	 Gio.SimpleAction { name = 'bench', enabled = false }
+end)
+local obj = R.TestObj()
+bench('property.get', function() return obj.int end)
+bench('property.set', function() obj.int = 42 end)
+local emitter = R.TestObj()
+emitter.on_notify = function() end
+bench('signal.emit', function() emitter:notify('int') end)
+local dict = { a = GLib.Variant('i', 1), b = GLib.Variant('s', 'lgi') }
+bench('variant.build', function() GLib.Variant('a{sv}', dict) end)
+bench('variant.build_fixed', function() GLib.Variant('ai', ints) end)
+local variant = GLib.Variant('a{sv}', dict)
+bench('variant.parse', function() return variant.value.a end)
+bench('variant.view', function() return variant.view.a end)
+
+-- Returns current time in nanoseconds.
+local function now()
+   return GLib.get_monotonic_time() * 1000
+end
+
+-- Runs function given number of times, returns elapsed nanoseconds.
+local function run(func, count)
+   local start = now()
+   for _ = 1, count do func() end
+   return now() - start
+end
+
+-- Measures single benchmark.  Iteration count is calibrated so that
+-- one repetition takes at least options.mintime, then one warm-up
+-- repetition is performed and median of measured repetitions is
+-- reported.
+local function measure(benchmark)
+   local func, count = benchmark.func, 1
+   local mintime = options.mintime * 1000000
+   while run(func, count) < mintime do count = count * 2 end
+   run(func, count)
+   collectgarbage()
+
+   local samples = {}
+   for i = 1, options.repetitions do
+      samples[i] = run(func, count) / count
+   end
+   table.sort(samples)
+   return {
+      name = benchmark.name, iterations = count, warmup = 1,
+      repetitions = options.repetitions,
+      ns_per_op = samples[math.floor((#samples + 1) / 2)],
+      min = samples[1], max = samples[#samples],
+   }
+end
+
+local function selected(name)
+   if #options.patterns == 0 then return true end
+   for _, pattern in ipairs(options.patterns) do
+      if name:match(pattern) then return true end
+   end
+end
+
+local results = {}
+for _, benchmark in ipairs(benchmarks) do
+   if selected(benchmark.name) then
+      results[#results + 1] = measure(benchmark)
+   end
+end
+
+-- Produce JSON output.
+local lines = {
+   '{',
+   ('  "lgi": "%s",'):format(require 'lgi.version'),
+   ('  "lua": "%s",'):format(_VERSION),
+   '  "benchmarks": [',
+}
+for i, result in ipairs(results) do
+   lines[#lines + 1] = ('    { "name": "%s", "iterations": %d, '
+			.. '"warmup": %d, "repetitions": %d, '
+			.. '"ns_per_op": %.2f, "min": %.2f, "max": %.2f }%s')
+      :format(result.name, result.iterations, result.warmup,
+	      result.repetitions, result.ns_per_op, result.min, result.max,
+	      i < #results and ',' or '')
+end
+lines[#lines + 1] = '  ]'
+lines[#lines + 1] = '}'
+local json = table.concat(lines, '\n') .. '\n'
+if options.output then
+   local file = assert(io.open(options.output, 'w'))
+   file:write(json)
+   file:close()
+else
+   io.write(json)
+end
+
+-- Compare with the baseline.
+if options.compare then
+   local file = assert(io.open(options.compare))
+   local baseline = {}
+   for name, ns in file:read('*a'):gmatch(
+      '"name":%s*"([^"]*)".-"ns_per_op":%s*([%d%.eE+-]+)') do
+      baseline[name] = tonumber(ns)
+   end
+   file:close()
+
+   local regressed = 0
+   io.stderr:write(('%-24s%14s%14s%10s\n'):format(
+		      'benchmark', 'baseline', 'current', 'change'))
+   for _, result in ipairs(results) do
+      local base = baseline[result.name]
+      if base then
+	 local change = (result.ns_per_op - base) / base * 100
+	 local mark = ''
+	 if change > options.threshold then
+	    regressed = regressed + 1
+	    mark = ' REGRESSED'
+	 end
+	 io.stderr:write(('%-24s%14.2f%14.2f%+9.1f%%%s\n'):format(
+			    result.name, base, result.ns_per_op, change, mark))
+      end
+   end
+   if regressed > 0 then
+      io.stderr:write(('%d benchmark(s) regressed by more than %g%%\n')
+		      :format(regressed, options.threshold))
+      os.exit(1)
+   end
+end
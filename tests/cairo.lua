@@ -128,6 +128,17 @@ function cairo.matrix_operations()
    checkv(y, -3, 'number')
 end
 
+function cairo.keep_lock()
+   local cairo = lgi.cairo
+
+   check(cairo.Matrix.translate.keep_lock == true)
+   check(cairo.Context.move_to.keep_lock == true)
+   check(cairo.Context.get_current_point.keep_lock == true)
+   check(cairo.Context.stroke.keep_lock == false)
+   check(cairo.Context.paint.keep_lock == false)
+   check(cairo.Context.show_page.keep_lock == false)
+end
+
 function cairo.dash()
    local cairo = lgi.cairo
    local surface = cairo.ImageSurface('ARGB32', 100, 100)
@@ -198,6 +209,61 @@ function cairo.path()
    check(i == 6)
 end
 
+function cairo.path_batch()
+   local cairo = lgi.cairo
+   local bytes = require 'bytes'
+   local surface = cairo.ImageSurface('ARGB32', 100, 100)
+   local cr = cairo.Context(surface)
+   local line_to = cairo.Context._method.line_to
+
+   cr:move_to(0, 0)
+   checkv(line_to:batch(cr, { 1, 2, 3, 4 }), 2, 'number')
+   checkv(line_to:batch(cr, { { 5, 6 }, { 7, 8 } }), 2, 'number')
+   checkv(line_to:batch(cr, bytes.new('double', { 9, 10 })), 1, 'number')
+   check(not pcall(line_to.batch, line_to, cr, { 1, 2, 3 }))
+
+   local x, y = cr:get_current_point()
+   checkv(x, 9, 'number')
+   checkv(y, 10, 'number')
+   local n = 0
+   for t in cr:copy_path():pairs() do n = n + 1 end
+   check(n == 6)
+end
+
+function cairo.path_data()
+   local cairo = lgi.cairo
+   local bytes = require 'bytes'
+   local surface = cairo.ImageSurface('ARGB32', 100, 100)
+   local cr = cairo.Context(surface)
+
+   cr:append_path_data(bytes.new('double', { 10, 11, 1, 2, 3, 4, 5, 6,
+					     21, 22 }), 'MCZL')
+   local coords, ops = cr:copy_path_data()
+   checkv(ops, 'MCZML', 'string')
+   check(coords.type == 'double' and #coords == 12)
+   check(coords[1] == 10 and coords[2] == 11 and coords[8] == 6)
+   check(coords[9] == 10 and coords[10] == 11 and coords[12] == 22)
+
+   cr:new_path()
+   cr:polyline { 0, 0, 10, 0, 10, 10 }
+   coords, ops = cr:copy_path_flat_data()
+   checkv(ops, 'MLL', 'string')
+   check(#coords == 6 and coords[3] == 10 and coords[6] == 10)
+   local x, y = cr:get_current_point()
+   checkv(x, 10, 'number')
+   checkv(y, 10, 'number')
+
+   cr:new_path()
+   cr:append_path_data(coords, ops)
+   local n = 0
+   for t in cr:copy_path():pairs() do n = n + 1 end
+   check(n == 3)
+   check(not pcall(cr.polyline, cr, { 1, 2, 3 }))
+   check(not pcall(cr.append_path_data, cr, { 1, 2 }, 'C'))
+   check(not pcall(cr.append_path_data, cr, { 1, 2 }, 'X'))
+   check(not pcall(cr.polyline, cr, { 1, 'a' }))
+end
+
 function cairo.surface_type()
    local cairo = lgi.cairo
    local surface = cairo.ImageSurface('ARGB32', 100, 100)
@@ -496,3 +562,18 @@ function cairo.pattern_reference()
    -- use-after-free if custom refsink would not work correctly.
    cr.source = source
 end
+
+function cairo.matrix_value()
+   local cairo = lgi.cairo
+   check(rawget(cairo.Matrix, '_value') == true)
+   local m = cairo.Matrix.create_translate(2, 3)
+   for i = 1, 100 do
+      local t = cairo.Matrix.create_identity()
+      t:translate(i, i)
+      m:multiply(m, cairo.Matrix.create_identity())
+   end
+   check_matrix(m, 1, 0, 0, 1, 2, 3)
+   local cr = cairo.Context(cairo.ImageSurface('ARGB32', 10, 10))
+   cr.matrix = m
+   check_matrix(cr.matrix, 1, 0, 0, 1, 2, 3)
+end
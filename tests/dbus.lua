@@ -138,3 +138,61 @@ function dbus.proxy_get_interface_info()
    -- Just so that we do test something
    assert(interface == interface2)
 end
+
+function dbus.register_methods()
+   local GLib, Gio = lgi.GLib, lgi.Gio
+   local node = Gio.DBusNodeInfo.new_for_xml [[
+<node>
+  <interface name='org.lgi.Test'>
+    <method name='Add'>
+      <arg type='i' direction='in'/><arg type='i' direction='in'/>
+      <arg type='i' direction='out'/>
+    </method>
+    <method name='Split'>
+      <arg type='s' direction='in'/>
+      <arg type='as' direction='out'/><arg type='u' direction='out'/>
+    </method>
+    <method name='Fail'/>
+    <method name='Missing'/>
+  </interface>
+</node>]]
+   local bus = Gio.bus_get_sync(Gio.BusType.SESSION)
+   local id = bus:register_methods('/org/lgi/Test', node.interfaces[1], {
+      Add = function(a, b) return a + b end,
+      Split = function(s)
+	 local words = {}
+	 for word in s:gmatch('%S+') do words[#words + 1] = word end
+	 return words, #words
+      end,
+      Fail = function() error('failed on purpose') end,
+   })
+   check(id)
+
+   local context = GLib.MainContext.default()
+   local function call(method, params)
+      local result
+      bus:call(bus.unique_name, '/org/lgi/Test', 'org.lgi.Test', method,
+	       params, nil, Gio.DBusCallFlags.NONE, -1, nil,
+	       function(_, res) result = res end)
+      while not result do context:iteration(true) end
+      return bus:call_finish(result)
+   end
+
+   local reply = call('Add', GLib.Variant('(ii)', { 2, 3 }))
+   check(reply[1] == 5)
+   reply = call('Split', GLib.Variant('(s)', { 'a b c' }))
+   check(reply[2] == 3 and #reply[1] == 3 and reply[1][3] == 'c')
+   local ok, err = call('Fail')
+   check(not ok and err.message:match('failed on purpose'))
+   ok, err = call('Missing')
+   check(not ok and err)
+
+   -- Second registration of the same interface fails, other records
+   -- are rejected as interface info.
+   local id2, err2 = bus:register_methods('/org/lgi/Test',
+					  node.interfaces[1], {})
+   check(not id2 and err2)
+   check(not pcall(bus.register_methods, bus, '/org/lgi/Test2', node, {}))
+   check(bus:unregister_object(id))
+   collectgarbage()
+end
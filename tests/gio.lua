@@ -78,3 +78,86 @@ function gio.async_access()
    check(Gio.DBusProxy:is_type_of(proxy))
 end
 
+
+function gio.async_all_race()
+   local Gio = lgi.Gio
+
+   local function query(path)
+      return function()
+	 return Gio.File.new_for_path(path):async_query_info(
+	    'standard::type', 'NONE')
+      end
+   end
+
+   local a, b, c = Gio.Async.call(function()
+	 return Gio.Async.all(query('.'), query('..'),
+			      function() return 1, 2 end)
+   end)()
+   check(Gio.FileInfo:is_type_of(a[1]))
+   check(Gio.FileInfo:is_type_of(b[1]))
+   check(c.n == 2 and c[1] == 1 and c[2] == 2)
+
+   local index, info = Gio.Async.call(function()
+	 return Gio.Async.race(query('.'), query('..'))
+   end)()
+   check(index == 1 or index == 2)
+   check(Gio.FileInfo:is_type_of(info))
+
+   local ok, err = pcall(Gio.Async.call(function()
+	 Gio.Async.all(query('.'), function() error('failed', 0) end)
+   end))
+   check(not ok and err == 'failed')
+
+   check(not pcall(Gio.Async.all, query('.')))
+
+   -- Failures after the aggregate is decided are ignored.
+   local late
+   ok, err = pcall(Gio.Async.call(function()
+	 Gio.Async.all(function()
+			  query('.')()
+			  late = true
+			  error('second', 0)
+		       end,
+		       function() error('first', 0) end)
+   end))
+   check(not ok and err == 'first')
+   local context = lgi.GLib.MainContext.default()
+   while not late do context:iteration(true) end
+end
+
+function gio.async_nested()
+   local Gio = lgi.Gio
+
+   local function query(path)
+      return function()
+	 return Gio.File.new_for_path(path):async_query_info(
+	    'standard::type', 'NONE')
+      end
+   end
+
+   -- The coroutine is resumed from the completion dispatcher and
+   -- blocks in nested Gio.Async.call, which must still receive its
+   -- completions.
+   local outer, inner = Gio.Async.call(function()
+	 local outer = query('.')()
+	 return outer, Gio.Async.call(query('..'))()
+   end)()
+   check(Gio.FileInfo:is_type_of(outer))
+   check(Gio.FileInfo:is_type_of(inner))
+end
+
+function gio.signal_enum_arg()
+    local Gio = lgi.Gio
+    local client = Gio.SocketClient()
+    local address = Gio.NetworkAddress.new('localhost', 1)
+    local calls = 0
+    client.on_event = function(self, event, connectable, connection)
+        check(self == client)
+        check(event == 'RESOLVING')
+        check(connectable == address)
+        check(connection == nil)
+        calls = calls + 1
+    end
+    for _ = 1, 3 do client.on_event:emit('RESOLVING', address, nil) end
+    check(calls == 3)
+end
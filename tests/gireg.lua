@@ -513,6 +513,31 @@ function gireg.array_gint64_in()
    check(not pcall(R.test_array_gint64_in, {'help'}))
 end
 
+function gireg.array_typed_buffer()
+   local R = lgi.Regress
+   local b = bytes.new('int32', {1, 2, 3})
+   check(#b == 3 and b.type == 'int32' and b[1] == 1 and b[3] == 3)
+   b[2] = 5
+   check(b[2] == 5)
+   check(b[4] == nil)
+   check(not pcall(function() b[4] = 1 end))
+   check(R.test_array_gint32_in(b) == 9)
+   check(R.test_array_gint64_in(bytes.new('int64', {1, 2, 3})) == 6)
+   check(not pcall(R.test_array_gint16_in, b))
+   check(#bytes.new('double', 4) == 4 and bytes.new('double', 4)[4] == 0)
+   check(#bytes.new('double', 0) == 0)
+   check(not pcall(bytes.new, 'double', -1))
+   check(not pcall(bytes.new, 'int64', -2147483647))
+
+   local func = R.test_array_int_full_out
+   func.typed_buffers = true
+   local a = func()
+   func.typed_buffers = false
+   check(type(a) == 'userdata' and a.type == 'int32' and #a == 5)
+   check(a[1] == 0 and a[2] == 1 and a[3] == 2 and a[4] == 3 and a[5] == 4)
+   check(type(func()) == 'table')
+end
+
 function gireg.array_strv_in()
    local R = lgi.Regress
    check(R.test_strv_in{'1', '2', '3'})
@@ -766,6 +791,48 @@ function gireg.ghash_everything_return()
    check(h.foo == 'bar' and h.baz == 'bat' and h.qux == 'quux')
 end
 
+function gireg.container_lazy()
+   local R = lgi.Regress
+   local pairs = lgi.core.marshal.pairs
+   for _, name in ipairs { 'test_glist_container_return',
+			   'test_glist_everything_return' } do
+      local func = R[name]
+      func.lazy_containers = true
+      local l = func()
+      func.lazy_containers = false
+      check(type(l) == 'userdata')
+      check(l[2] == '2' and l[1] == '1' and l[3] == '3' and l[4] == nil)
+      check(#l == 3 and l[0] == nil)
+      local seen = {}
+      for i, v in pairs(l) do seen[i] = v end
+      check(#seen == 3 and seen[1] == '1' and seen[3] == '3')
+      check(type(func()) == 'table')
+
+      -- Elements never accessed are released with the proxy.
+      func.lazy_containers = true
+      l = func()
+      func.lazy_containers = false
+      check(l[2] == '2')
+      l = nil
+      collectgarbage()
+   end
+
+   for _, name in ipairs { 'test_ghash_container_return',
+			   'test_ghash_everything_return' } do
+      local func = R[name]
+      func.lazy_containers = true
+      local h = func()
+      func.lazy_containers = false
+      check(type(h) == 'userdata' and #h == 3)
+      check(h.foo == 'bar' and h.baz == 'bat' and h.qux == 'quux')
+      check(h.missing == nil and h.foo == 'bar')
+      local seen = {}
+      for k, v in pairs(h) do seen[k] = v end
+      check(size_htab(seen) == 3 and seen.qux == 'quux')
+   end
+   collectgarbage()
+end
+
 function gireg.ghash_null_in()
    local R = lgi.Regress
    R.test_ghash_null_in(nil)
@@ -896,6 +963,20 @@ function gireg.struct_a()
    check(select('#', (function() local b = a.some_int end)()) == 0)
 end
 
+function gireg.struct_a_field_descriptors()
+   local R = lgi.Regress
+   local fields = R.TestStructA._field
+   check(type(fields.some_int) == 'table')
+   check(type(fields.some_double) == 'table')
+   local a = R.TestStructA { some_int = -5, some_double = 2.5 }
+   check(a.some_int == -5)
+   check(a.some_double == 2.5)
+   a.some_int = nil
+   a.some_double = nil
+   check(a.some_int == 0)
+   check(a.some_double == 0)
+end
+
 function gireg.struct_a_clone()
    local R = lgi.Regress
    local a = R.TestStructA { some_int = 42, some_int8 = 12, some_double = 3.14,
@@ -1383,6 +1464,21 @@ function gireg.obj_naming()
    check(o:get_testbool() == false)
 end
 
+function gireg.obj_signal_notify()
+   local R = lgi.Regress
+   local o = R.TestObj()
+   local count, self, name = 0
+   o.on_notify['int'] = function(obj, pspec)
+      count = count + 1
+      self, name = obj, pspec:get_name()
+   end
+   o.int = 42
+   check(count == 1 and self == o and name == 'int')
+   o.on_notify['int'] = function() error('handler failure') end
+   o.int = 43
+   check(count == 2 and o.int == 43)
+end
+
 function gireg.obj_floating()
    local R = lgi.Regress
    local o = R.TestFloating()
@@ -1417,6 +1513,199 @@ function gireg.callback_simple()
    check(R.test_multi_callback() == 0)
 end
 
+function gireg.callable_keep_lock()
+   local R = lgi.Regress
+   local core = require 'lgi.core'
+   local ti = require('lgi.ffi').types
+   local func = R.test_int8
+   check(func.keep_lock == false)
+   lgi.lockstats(true)
+   check(func(42) == 42)
+   check(lgi.lockstats().acquisitions == 1)
+   func.keep_lock = true
+   lgi.lockstats(true)
+   check(func(42) == 42)
+   check(lgi.lockstats().acquisitions == 0)
+   func.keep_lock = false
+
+   local parsed = core.callable.new {
+      name = 'Regress.test_int8',
+      addr = core.gi.Regress.resolve.regress_test_int8,
+      ret = ti.int8, ti.int8, keep_lock = true }
+   check(parsed.keep_lock == true)
+   lgi.lockstats(true)
+   check(parsed(7) == 7)
+   check(lgi.lockstats().acquisitions == 0)
+   lgi.lockstats(false)
+   check(type(core.callable.keep_lock) == 'table')
+end
+
+function gireg.callable_profile()
+   local R = lgi.Regress
+   local name = tostring(R.test_int16)
+   lgi.profile.start()
+   for i = 1, 10 do R.test_int16(i) end
+   R.test_callback(function() return 1 end)
+   lgi.profile.stop()
+   R.test_int16(1)
+
+   local records = {}
+   for _, record in ipairs(lgi.profile.report()) do
+      records[record.name] = record
+   end
+   local record = records[name]
+   check(record and record.calls == 10)
+   check(record.call >= 0 and record.marshal_in >= 0
+	 and record.marshal_out >= 0 and record.lock >= 0)
+   check(record.total >= record.call)
+   local callbacks = 0
+   for recname, record in pairs(records) do
+      if recname:match('^lgi%.cbk') then callbacks = callbacks + record.calls end
+   end
+   check(callbacks == 1)
+
+   lgi.profile.start()
+   lgi.profile.stop()
+   check(#lgi.profile.report() == 0)
+end
+
+function gireg.memstats()
+   local R = lgi.Regress
+   local objs, structs = {}, {}
+   for i = 1, 3 do
+      objs[i] = R.TestObj()
+      structs[i] = R.TestStructA()
+   end
+   local stats = lgi.memstats()
+   local entry = stats.types.RegressTestObj
+   check(entry and entry.kind == 'object' and entry.count >= 3)
+   check(entry.bytes > 0 and stats.objects.count >= 3)
+   entry = stats.types['Regress.TestStructA']
+   local records = (entry and entry.count or 0) + stats.records.values
+   check(records >= 3)
+   check(stats.closures.blocks >= stats.closures.outstanding)
+   check(stats.closures.ffi_bytes >= 0)
+   check(type(stats.cached) == 'table')
+end
+
+function gireg.prewarm()
+   local R = lgi.Regress
+   lgi.prewarm { Regress = { 'TestObj', 'test_int' } }
+   check(getmetatable(rawget(R.TestObj, '_method')) == nil)
+   check(rawget(rawget(R, '_function'), 'test_int') ~= nil)
+
+   local done = false
+   lgi.prewarm({ Regress = 'TestStructA' }, function() done = true end)
+   check(not done)
+   local context = lgi.GLib.MainContext.default()
+   while not done do context:iteration(true) end
+   check(getmetatable(rawget(R.TestStructA, '_method')) == nil)
+end
+
+function gireg.callable_scratch()
+   local R = lgi.Regress
+   for _ = 1, 3 do
+      check(not pcall(R.test_array_int_in, { 1, 'help' }))
+      check(R.test_array_int_in { 1, 2, 3 } == 6)
+   end
+   check(R.test_callback(function()
+	    check(not pcall(R.test_array_int_in, { 'help' }))
+	    return R.test_array_int_in { 4, 5 }
+   end) == 9)
+   check(R.test_array_int_in { 1, 2 } == 3)
+
+   -- Temporaries marshalled outside of any call, right after a call
+   -- aborted during argument marshalling, and from a callback.
+   local obj = R.TestObj()
+   check(not pcall(R.test_array_int_in, { 1, 'help' }))
+   obj.list = { 'a', 'b' }
+   check(R.test_callback(function()
+	    check(not pcall(R.test_array_int_in, { 1, 'help' }))
+	    obj.list = { 'c', 'd', 'e' }
+	    return R.test_array_int_in { 4, 5 }
+   end) == 9)
+   collectgarbage()
+   local list = obj.list
+   check(#list == 3 and list[1] == 'c' and list[3] == 'e')
+end
+
+function gireg.callable_fastpath()
+   local R = lgi.Regress
+   local core = require 'lgi.core'
+   local fastcall = require 'lgi.fastcall'
+   local func = R.test_int8
+   check(func.fastpath == nil)
+   func.keep_lock = true
+   local desc = func.fastpath
+   check(desc.ctype == 'int8_t (*)(int8_t)')
+   check(desc.ret == 'number' and #desc == 1 and desc[1] == 'number')
+   if fastcall.available then
+      check(fastcall.wrap(core, func)(-3) == -3)
+   end
+   func.keep_lock = false
+
+   func = R.test_utf8_const_return
+   func.keep_lock = true
+   desc = func.fastpath
+   check(desc.ctype == 'const char * (*)(void)' and desc.ret == 'string')
+   if fastcall.available then
+      check(fastcall.wrap(core, func)() == R.test_utf8_const_return())
+   end
+   func.keep_lock = false
+
+   func = R.TestObj._method.instance_method
+   func.keep_lock = true
+   desc = func.fastpath
+   check(desc[1] == 'object' and desc.gtypes[1] == R.TestObj._gtype)
+   if fastcall.available then
+      check(fastcall.wrap(core, func)(R.TestObj()) == -1)
+      check(not pcall(fastcall.wrap(core, func), 1))
+   end
+   func.keep_lock = false
+
+   func = R.TestSimpleBoxedA._method.equals
+   func.keep_lock = true
+   desc = func.fastpath
+   check(desc[1] == 'record' and desc[2] == 'record' and not desc.optional[2])
+   if fastcall.available then
+      local a = R.TestSimpleBoxedA { some_int = 1 }
+      check(fastcall.wrap(core, func)(a, a) == true)
+      check(not pcall(fastcall.wrap(core, func), a, nil))
+   end
+   func.keep_lock = false
+   check(pcall(core.record.query, nil, 'addr', R.TestSimpleBoxedA))
+   check(not pcall(core.record.query, nil, 'addr', R.TestSimpleBoxedA, false))
+
+   R.test_callback.keep_lock = true
+   check(R.test_callback.fastpath == nil)
+   R.test_callback.keep_lock = false
+end
+
+function gireg.callable_batch()
+   local R = lgi.Regress
+   local res = R.test_int8:batch { 1, 2, 3 }
+   check(#res == 3 and res[1] == 1 and res[2] == 2 and res[3] == 3)
+   res = R.test_int8:batch { { 4 }, { 5 } }
+   check(#res == 2 and res[1] == 4 and res[2] == 5)
+   res = R.test_double:batch(bytes.new('double', { 1.5, 2.5 }))
+   check(#res == 2 and res[1] == 1.5 and res[2] == 2.5)
+   check(#R.test_boolean:batch { true, false } == 2)
+   check(#R.test_int8:batch {} == 0)
+   check(not pcall(R.test_int8.batch, R.test_int8, { 'a' }))
+   check(not pcall(R.test_callback.batch, R.test_callback, {}))
+end
+
+function gireg.callback_recycled()
+   local R = lgi.Regress
+   for i = 1, 100 do
+      check(R.test_callback(function() return i end) == i)
+      check(not pcall(R.test_callback, 'foo'))
+      check(R.test_multi_callback(function() return i end) == 2 * i)
+   end
+   collectgarbage()
+   check(R.test_callback(function() return 42 end) == 42)
+end
+
 function gireg.callback_data()
    local R = lgi.Regress
    local called
@@ -1458,3 +1747,15 @@ function gireg.callback_async()
    collectgarbage()
    check(R.test_callback_thaw_async() == 1)
 end
+
+function gireg.gi_info_keys()
+   local info = core.gi.Regress.TestObj
+   check(info.type == 'object' and info.is_object and not info.is_struct)
+   check(info.name == 'TestObj' and info.namespace == 'Regress')
+   check(info.gtype ~= nil and info.gtype == info.gtype)
+   check(info.is_gtype_struct == nil)
+   check(info.no_such_attribute == nil)
+   check(info[1] == nil)
+   local method = info.methods.set_bare
+   check(method.is_function and method.args[1].direction == 'in')
+end
@@ -134,6 +134,82 @@ function glib.gsourcefuncs()
    check(called == source)
 end
 
+function glib.bytes_view()
+   local bytes = require 'bytes'
+   local GLib = lgi.GLib
+
+   local view = bytes.view('hello world')
+   check(#view == 11)
+   check(view[1] == 104)
+   check(view[12] == nil)
+   check(tostring(view) == 'hello world')
+   check(tostring(view:sub(7)) == 'world')
+   check(tostring(view:sub(-5, -2)) == 'worl')
+   check(#view:sub(5, 2) == 0)
+   check(view:uint(1, 1) == 104)
+   check(view:int(1, 2) == view:uint(1, 2))
+   check(not pcall(view.uint, view, 10, 4))
+   check(not pcall(function() view[1] = 0 end))
+
+   view = GLib.Bytes.new('data', 4):view()
+   check(#view == 4)
+   check(tostring(view) == 'data')
+
+   local decode = GLib.base64_decode
+   decode.bytes_view = true
+   view = decode('aGVsbG8=')
+   decode.bytes_view = false
+   check(type(view) == 'userdata')
+   check(tostring(view) == 'hello')
+   check(decode('aGVsbG8=') == 'hello')
+end
+
+function glib.lockstats()
+   local stats = lgi.lockstats(true)
+   check(stats.enabled == true and stats.acquisitions == 0)
+   check(#stats.histogram == 8)
+   lgi.GLib.get_monotonic_time()
+   lgi.yield()
+   stats = lgi.lockstats()
+   check(stats.acquisitions >= 2)
+   check(stats.contended <= stats.acquisitions)
+   check(stats.wait_max <= stats.wait_total)
+   stats = lgi.lockstats(false)
+   check(stats.enabled == false and stats.acquisitions == 0)
+   lgi.yield()
+   check(lgi.lockstats().acquisitions == 0)
+end
+
+function glib.offload()
+   local GLib = lgi.GLib
+   local context = GLib.MainContext.default()
+   local done = 0
+   for _ = 1, 3 do
+      coroutine.wrap(function()
+	 check(select('#', lgi.offload(GLib.usleep, 10000)) == 0)
+	 check(lgi.offload(GLib.getenv, 'HOME') == GLib.getenv('HOME'))
+	 local ok, err = lgi.offload(GLib.file_get_contents, '/nonexistent/lgi')
+	 check(not ok and err)
+	 done = done + 1
+      end)()
+   end
+   check(done == 0)
+   while done < 3 do context:iteration(true) end
+   check(not pcall(lgi.offload, GLib.usleep, 0))
+
+   -- Foreign resume of the waiting coroutine raises.
+   local coro = coroutine.create(function()
+	 return lgi.offload(GLib.usleep, 10000)
+   end)
+   check(coroutine.resume(coro))
+   local ok, err = coroutine.resume(coro, 'foreign')
+   check(not ok and err:match('resumed while the call is running'))
+   for _ = 1, 5 do
+      GLib.usleep(5000)
+      context:iteration(false)
+   end
+end
+
 function glib.coroutine_related_crash()
     -- This test does not have a specific assert() or check() call. Instead it
     -- is a regression test: Once upon a time this caused a segmentation fault
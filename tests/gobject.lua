@@ -341,6 +341,52 @@ function gobject.subclass_prop_getset()
    checkv(propval, 'assign', 'string')
 end
 
+function gobject.subclass_prop_native()
+   local GObject = lgi.GObject
+   local Derived = GObject.Object:derive('LgiTestDerivedPropNative')
+   Derived._property.int = GObject.ParamSpecInt(
+      'int', 'Nick int', 'Blurb int', -10, 10, 1,
+      { 'READABLE', 'WRITABLE' })
+   Derived._property.double = GObject.ParamSpecDouble(
+      'double', 'Nick double', 'Blurb double', 0, 100, 0.5,
+      { 'READABLE', 'WRITABLE' })
+   Derived._property.flag = GObject.ParamSpecBoolean(
+      'flag', 'Nick flag', 'Blurb flag', false, { 'READABLE' })
+   local der = Derived()
+   checkv(der.int, 1, 'number')
+   der.int = -7
+   checkv(der.int, -7, 'number')
+   checkv(der.priv.int, -7, 'number')
+   checkv(der.double, 0.5, 'number')
+   der.double = 42.25
+   checkv(der.double, 42.25, 'number')
+   checkv(der.flag, false, 'boolean')
+   check(not pcall(function() der.flag = true end))
+   check(not pcall(function() der.int = 'notanumber' end))
+   checkv(der.int, -7, 'number')
+end
+
+function gobject.construct_batch()
+   local GLib, Gio = lgi.GLib, lgi.Gio
+   local activated
+   local action = Gio.SimpleAction {
+      name = 'lgi-action', enabled = false,
+      parameter_type = GLib.VariantType.new('s'),
+      on_activate = function(_, param) activated = param.value end,
+   }
+   checkv(action.name, 'lgi-action', 'string')
+   checkv(action.enabled, false, 'boolean')
+   checkv(action.parameter_type:dup_string(), 's', 'string')
+   action.enabled = true
+   action:activate(GLib.Variant('s', 'param'))
+   checkv(activated, 'param', 'string')
+
+   -- Errors during conversion release already converted values.
+   check(not pcall(Gio.SimpleAction, { name = 'lgi-action',
+				       parameter_type = 42 }))
+   collectgarbage()
+end
+
 function gobject.signal_query()
    local GObject = lgi.GObject
    local id = GObject.signal_lookup('notify', GObject.Object)
@@ -352,3 +398,20 @@ function gobject.signal_query()
    check(#query.param_types == 1)
    check(query.param_types[1] == GObject.Type.name(GObject.Type.PARAM))
 end
+
+function gobject.proxy_identity()
+   local GObject = lgi.GObject
+   local o = GObject.Object()
+   local p = o._native
+   check(rawequal(GObject.Object(p), o))
+   o = nil
+   collectgarbage()
+   collectgarbage()
+   local objs = {}
+   for i = 1, 10 do objs[i] = GObject.Object() end
+   for i = 1, 10 do check(rawequal(GObject.Object(objs[i]._native), objs[i])) end
+   objs = nil
+   collectgarbage()
+   local o2 = GObject.Object()
+   check(rawequal(GObject.Object(o2._native), o2))
+end
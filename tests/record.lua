@@ -23,3 +23,27 @@ function record.native()
    check(type(p) == 'userdata')
    check(GObject.EnumValue(p) == c)
 end
+
+function record.array()
+   local arr = GObject.EnumValue:array(3)
+   check(#arr == 3)
+   check(arr[2].value == 0)
+   arr[2].value = 42
+   check(arr[2].value == 42)
+   check(arr[1].value == 0)
+   arr[3] = { value = 7 }
+   check(arr[3].value == 7)
+   arr[1] = GObject.EnumValue { value = 3 }
+   check(arr[1].value == 3)
+   check(not pcall(function() return arr[4] end))
+   check(not pcall(function() return arr[0] end))
+
+   local init = GObject.EnumValue:array { { value = 1 }, { value = 2 } }
+   check(#init == 2 and init[1].value == 1 and init[2].value == 2)
+   local addr, count = require("lgi.core").record.array(init)
+   check(type(addr) == 'userdata' and count == 2)
+
+   check(#GObject.EnumValue:array(0) == 0)
+   check(not pcall(GObject.EnumValue.array, GObject.EnumValue, -1))
+   check(not pcall(GObject.EnumValue.array, GObject.EnumValue, 2^53))
+end
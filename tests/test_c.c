@@ -35,6 +35,14 @@ const char add_async[] =
 "end)(stream)"
 ;
 
+const char add_offload[] =
+"local lgi = require('lgi');"
+"coroutine.wrap(function()"
+"  lgi.offload(lgi.GLib.usleep, 50000);"
+"  error('completed in closed state');"
+"end)()"
+;
+
 int main()
 {
   /* Set up multiple Lua states */
@@ -67,6 +75,19 @@ int main()
 
   lua_close (L1);
   lua_close (L2);
+
+  /* Close state with offloaded call still running, its completion
+     must not be delivered into the closed state. */
+  L1 = luaL_newstate ();
+  luaL_openlibs (L1);
+  run_string (L1, add_offload);
+  lua_close (L1);
+  run_string (L3, "local GLib = require('lgi').GLib;"
+	      "for i = 1, 5 do"
+	      "  GLib.usleep(20000);"
+	      "  GLib.MainContext.default():iteration(false);"
+	      "end");
+
   lua_close (L3);
 
   puts ("Success");
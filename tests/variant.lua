@@ -11,6 +11,7 @@
 local lgi = require 'lgi'
 local GLib = lgi.GLib
 local GObject = lgi.GObject
+local core = require 'lgi.core'
 
 local check = testsuite.check
 
@@ -130,6 +131,38 @@ function variant.newv_dictionary()
    check(vv.type == 'd' and vv:get_double() == 1)
 end
 
+function variant.newv_fixed_array()
+   local V, v = GLib.Variant
+   v = V('ai', { 1, -2, 3 })
+   check(v.type == 'ai' and v:n_children() == 3
+	 and v:get_child_value(1):get_int32() == -2)
+   v = V('ad', { 0.5, 1.5 })
+   check(v:n_children() == 2 and v:get_child_value(1):get_double() == 1.5)
+   v = V('ab', { true, false, n = 2 })
+   check(v:get_child_value(0):get_boolean() == true
+	 and v:get_child_value(1):get_boolean() == false)
+   v = V('ay', { 65, 66 })
+   check(tostring(v.data) == 'AB')
+   v = V('aq', {})
+   check(v.type == 'aq' and v:n_children() == 0)
+   check(not pcall(V.new, 'ay', { 256 }))
+end
+
+function variant.newv_nested()
+   local V, v = GLib.Variant
+   v = V('a(ussa{sv})', {
+	    { 1, 'first', 'a', { x = V('i', 1) } },
+	    { 2, 'second', 'b', {} } })
+   check(v.type == 'a(ussa{sv})' and v:n_children() == 2)
+   local first = v:get_child_value(0)
+   check(first:get_child_value(0):get_uint32() == 1)
+   check(first:get_child_value(1):get_string() == 'first')
+   check(first:get_child_value(3):lookup_value('x', nil):get_int32() == 1)
+   check(v:get_child_value(1):get_child_value(3):n_children() == 0)
+   check(not pcall(V.new, 'a(us)', { { 1, {} } }))
+   check(not pcall(V.new, 'o', 'not a path'))
+end
+
 function variant.newv_badtype()
    local V, v = GLib.Variant
    check(not pcall(V.new, '{vs}'))
@@ -146,6 +179,20 @@ function variant.newv_badtype()
    check(not pcall(V.new, '*'))
    check(not pcall(V.new, '?'))
    check(not pcall(V.new, 'ii'))
+   check(not pcall(V.new, '('))
+   check(not pcall(V.new, '(i'))
+   check(not pcall(V.new, '{s'))
+   check(not pcall(V.new, 'aa'))
+   check(not pcall(V.new, 'mm'))
+   check(not pcall(V.new, 'ai', { n = -1 }))
+   check(not pcall(V.new, 'ad', { 1, 2, n = -3 }))
+   check(not pcall(V.new, 'ams', { n = -1 }))
+   check(not pcall(V.new, ('a'):rep(1e6) .. 'i', {}))
+   check(not pcall(V.new, ('('):rep(200) .. (')'):rep(200)))
+   check(V.new(('a'):rep(100) .. 'i', {}).type == ('a'):rep(100) .. 'i')
+
+   -- Release rejected plans, so that memory checkers see their nodes.
+   collectgarbage()
 end
 
 function variant.value_simple()
@@ -198,6 +245,40 @@ function variant.value_dictionary()
    check(v.value.three == nil)
 end
 
+function variant.view()
+   local V = GLib.Variant
+   check(V('s', 'Hello').view == 'Hello')
+   check(V('v', V('i', 3)).view == 3)
+   check(V('mi').view == nil)
+   local ai = V('ai', { 1, 2, 3 }).view
+   check(#ai == 3 and ai[3] == 3 and ai.type == 'int32')
+   check(not pcall(function() ai[1] = 5 end))
+   local ay = V('ay', 'bytes').view
+   check(#ay == 5 and tostring(ay) == 'bytes')
+   local pts = V('a(ii)', { { 1, 2 }, { 3, 4 } }).view
+   check(#pts == 2 and pts[2][1] == 3 and pts[2][2] == 4 and pts[3] == nil)
+   local dict = V('a{sv}', { one = V('i', 1), name = V('s', 'lgi'),
+			     list = V('ad', { 0.5 }) }).view
+   check(#dict == 3)
+   check(dict.one == 1 and dict.name == 'lgi' and dict.list[1] == 0.5)
+   check(dict.missing == nil)
+   check(dict.one == 1)
+   local keys = {}
+   for k, v in core.variant.pairs(dict) do keys[k] = v end
+   check(keys.one == 1 and keys.name == 'lgi')
+   local idict = V('a{ix}', { [10] = 100, [20] = 200 }).view
+   check(idict[10] == 100 and idict[20] == 200 and idict[30] == nil)
+
+   -- Large dictionaries are looked up through index of the keys.
+   local big = {}
+   for i = 1, 1000 do big['key' .. i] = i end
+   local bdict = V('a{si}', big).view
+   for i = 1000, 1, -1 do check(bdict['key' .. i] == i) end
+   check(bdict.key0 == nil and bdict[1] == nil)
+   local ddict = V('a{db}', { [0.5] = true, [1.5] = false }).view
+   check(ddict[0.5] == true and ddict[1.5] == false and ddict[0 / 0] == nil)
+end
+
 function variant.length()
    local V, v = GLib.Variant
    check(#V('s', 'Hello') == 0)